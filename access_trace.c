@@ -0,0 +1,138 @@
+#include "access_trace.h"
+
+#include <ctype.h>
+#include <string.h>
+
+
+/*
+ * Functions for memory access traces
+ *   A trace is a text file of accesses in program order, one record per line:
+ *
+ *     <address> <size> [data]
+ *
+ *   Address is decimal or hexadecimal (0x prefix), size is the number of accessed bytes, and data
+ *   is an optional snapshot of the accessed bytes after the access as a hex string (2 digits per
+ *   byte, in address order). Empty lines and lines starting with '#' are skipped, and broken
+ *   records are counted and skipped.
+ *
+ *   mark_hot_lines splits lines into hot and cold by their access counts: lines are taken from the
+ *   most accessed one until they cover the given share of all accesses.
+ *
+ * Functions:
+ *   open_access_trace: opens trace file (fp is NULL on failure)
+ *   close_access_trace: closes trace file
+ *   next_access_record: reads next record (FALSE at the end of the trace)
+ *   mark_hot_lines: marks most accessed lines covering share of accesses
+ */
+
+typedef struct {
+    long count;  // access count of the line
+    long line;   // index of the line
+} LineCount;
+
+static int compare_line_count(const void *a, const void *b) {
+    const LineCount *x = (const LineCount *)a, *y = (const LineCount *)b;
+
+    if (x->count != y->count)
+        return x->count < y->count ? 1 : -1;  // descending count
+    return x->line < y->line ? -1 : (x->line > y->line);
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+AccessTrace open_access_trace(char const *filename) {
+    AccessTrace trace;
+
+    trace.fp = fopen(filename, "rt");
+    trace.line_no = 0;
+    trace.record_num = 0;
+    trace.broken_num = 0;
+
+    if (trace.fp == NULL)
+        fprintf(stderr, "[ERROR] Opening trace file '%s' failed\n", filename);
+
+    return trace;
+}
+
+void close_access_trace(AccessTrace trace) {
+    if (trace.fp != NULL)
+        fclose(trace.fp);
+}
+
+static Bool parse_access_record(char *cursor, AccessRecord *record) {
+    char *end;
+    int high, low;
+
+    // address and size
+    record->address = strtoull(cursor, &end, 0);
+    if (end == cursor) return FALSE;
+    cursor = end;
+    record->size = (int)strtol(cursor, &end, 0);
+    if (end == cursor || record->size <= 0) return FALSE;
+    cursor = end;
+
+    // data snapshot (optional)
+    for (; isspace((unsigned char)*cursor); cursor++);
+    record->has_data = *cursor != 0;
+    if (!record->has_data)
+        return TRUE;
+    if (record->size > TRACE_MAX_DATA)
+        return FALSE;
+    for (int i = 0; i < record->size; i++) {
+        high = hex_digit(cursor[2 * i]);
+        low = high < 0 ? -1 : hex_digit(cursor[2 * i + 1]);
+        if (low < 0) return FALSE;
+        record->data[i] = (Byte)(high * 16 + low);
+    }
+    return TRUE;
+}
+
+Bool next_access_record(AccessTrace *trace, AccessRecord *record) {
+    char linebuf[TRACE_LINE_BUFSIZ];
+    char *cursor;
+
+    while (trace->fp != NULL && fgets(linebuf, TRACE_LINE_BUFSIZ, trace->fp)) {
+        trace->line_no += 1;
+        for (cursor = linebuf; isspace((unsigned char)*cursor); cursor++);
+        if (*cursor == 0 || *cursor == '#')
+            continue;
+
+        if (parse_access_record(cursor, record)) {
+            trace->record_num += 1;
+            return TRUE;
+        }
+#ifdef VERBOSE
+        printf("broken record at line %ld: %s", trace->line_no, linebuf);
+#endif
+        trace->broken_num += 1;
+    }
+
+    return FALSE;
+}
+
+long mark_hot_lines(long const *counts, long line_num, double share, Bool *hot) {
+    LineCount *order = (LineCount *)malloc(sizeof(LineCount) * (line_num > 0 ? line_num : 1));
+    long total = 0, covered = 0, hot_num = 0;
+
+    for (long i = 0; i < line_num; i++) {
+        order[i].count = counts[i];
+        order[i].line = i;
+        total += counts[i];
+        hot[i] = FALSE;
+    }
+    qsort(order, line_num, sizeof(LineCount), compare_line_count);
+
+    for (long i = 0; i < line_num && covered < share * total; i++) {
+        hot[order[i].line] = TRUE;
+        covered += order[i].count;
+        hot_num += 1;
+    }
+
+    free(order);
+    return hot_num;
+}
@@ -0,0 +1,34 @@
+#ifndef ACCESS_TRACE
+#define ACCESS_TRACE
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for memory access traces
+#define TRACE_LINE_BUFSIZ   8192  // maximum length of a record in the trace file
+#define TRACE_MAX_DATA      2048  // maximum size of data snapshot of a record
+#define TRACE_HOT_SHARE     0.8   // hot lines are the most accessed lines covering this share of accesses
+
+typedef struct {
+    uint64_t  address;               // accessed address
+    int       size;                  // size of the access
+    Bool      has_data;              // whether the record has data snapshot
+    Byte      data[TRACE_MAX_DATA];  // data at the address after the access (snapshot)
+} AccessRecord;
+
+typedef struct {
+    FILE     *fp;           // trace file (NULL if not opened)
+    long      line_no;      // line number of the last record read
+    long      record_num;   // number of records read
+    long      broken_num;   // number of broken records skipped
+} AccessTrace;
+
+// Functions for memory access traces
+AccessTrace open_access_trace(char const *filename);                             // opens trace file (fp is NULL on failure)
+void close_access_trace(AccessTrace trace);                                       // closes trace file
+Bool next_access_record(AccessTrace *trace, AccessRecord *record);               // reads next record (FALSE at the end of the trace)
+long mark_hot_lines(long const *counts, long line_num, double share, Bool *hot);  // marks most accessed lines covering share of accesses (returns number of hot lines)
+
+#endif
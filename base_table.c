@@ -0,0 +1,229 @@
+#include "base_table.h"
+
+
+/*
+ * Functions for BDI algorithm with global base table
+ *   Every BDI line spends 2-8Bytes storing its own base. With global base table, lines of a region
+ *   (e.g. a layer) reference bases from a small table shared by the region and only deltas are
+ *   stored in the line. The table is learned online: base of every line compressed with its own
+ *   base is inserted into the table, replacing the least recently (LRU) or least frequently (LFU)
+ *   used entry. Decompressor replays the same insertions, so the table is never transferred
+ *   along with the lines, but its storage is a per-region cost.
+ *
+ * Functions:
+ *   make_base_table: allocates table with 2^index_bits bases
+ *   reset_base_table: clears bases and statistics (start of a new region)
+ *   remove_base_table: removes table
+ *   base_table_size: storage cost of the table (bases and their sizes)
+ *   base_table_compression: BDI compression algorithm with global base table
+ *   base_table_decompression: BDI decompression algorithm with global base table
+ *
+ * Note
+ *   Delta check of each table entry is done with bdi_delta_check, which is shared with
+ *   bdi_compressing_unit
+ */
+
+static const int base_table_k[8] = {0, 0, 8, 4, 2, 8, 4, 8};  // base size of BDI encodings
+static const int base_table_d[8] = {0, 0, 1, 1, 1, 2, 2, 4};  // delta size of BDI encodings
+
+BaseTable make_base_table(int index_bits, int policy) {
+    BaseTable table;
+    table.index_bits = index_bits;
+    table.capacity = 1 << index_bits;
+    table.policy = policy;
+    table.bases = (ValueBuffer *)calloc(table.capacity, sizeof(ValueBuffer));
+    table.base_sizes = (int *)calloc(table.capacity, sizeof(int));
+    table.stamps = (long *)calloc(table.capacity, sizeof(long));
+    reset_base_table(&table);
+    return table;
+}
+
+void reset_base_table(BaseTable *table) {
+    memset(table->bases, 0, table->capacity * sizeof(ValueBuffer));
+    memset(table->base_sizes, 0, table->capacity * sizeof(int));
+    memset(table->stamps, 0, table->capacity * sizeof(long));
+    table->clock = 0;
+    table->lookups = 0;
+    table->hits = 0;
+}
+
+void remove_base_table(BaseTable table) {
+    free(table.bases);
+    free(table.base_sizes);
+    free(table.stamps);
+}
+
+long base_table_size(BaseTable table) {
+    return (long)table.capacity * DWORDSIZ + (long)ceil((double)table.capacity * 2 / BYTE_BITWIDTH);  // 8Bytes base + 2bits base size
+}
+
+static void base_table_touch(BaseTable *table, int index) {
+    if (table->policy == BASE_TABLE_LFU)
+        table->stamps[index] += 1;
+    else
+        table->stamps[index] = ++table->clock;
+}
+
+static void base_table_insert(BaseTable *table, ValueBuffer base, int k) {
+    int victim = 0;
+
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->base_sizes[i] == k && table->bases[i] == base) {
+            base_table_touch(table, i);  // already in table
+            return;
+        }
+    }
+
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->base_sizes[i] == 0) {
+            victim = i;  // empty entry
+            break;
+        }
+        if (table->stamps[i] < table->stamps[victim])
+            victim = i;
+    }
+
+#ifdef VERBOSE
+    printf("base table insert: 0x%016llx (%dBytes) -> entry %d\n", base, k, victim);
+#endif
+
+    table->bases[victim] = base;
+    table->base_sizes[victim] = k;
+    table->stamps[victim] = 0;
+    base_table_touch(table, victim);
+}
+
+CompressionResult base_table_compression(BaseTable *table, CacheLine original) {
+    CompressionResult result, plain;
+    MetaData tag_overhead = make_memory_chunk((BASE_TABLE_TAG_OFFSET + table->index_bits + 11 + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH, 0);
+    CacheLine compressed;
+    int best_bits, best_encoding = -1, best_index = -1;
+    int k, d, hit_size, encoding;
+
+#ifdef VERBOSE
+    printf("Compressing with BDI algorithm with global base table...\n");
+#endif
+
+    plain = bdi_compression(original);
+    best_bits = plain.compressed.size * BYTE_BITWIDTH;
+    table->lookups += 1;
+
+    // 1. Find out the smallest encoding with a base of the table
+    for (encoding = 2; encoding < 8 && original.size % DWORDSIZ == 0; encoding++) {
+        k = base_table_k[encoding];
+        d = base_table_d[encoding];
+        hit_size = (original.size / k) * d;
+
+        if (hit_size * BYTE_BITWIDTH + table->index_bits >= best_bits)
+            continue;
+
+        for (int i = 0; i < table->capacity; i++) {
+            if (table->base_sizes[i] != k) continue;
+            if (bdi_delta_check(original, table->bases[i], k, d, NULL)) {
+                best_bits = hit_size * BYTE_BITWIDTH + table->index_bits;
+                best_encoding = encoding;
+                best_index = i;
+                break;
+            }
+        }
+    }
+
+    result.compression_type = "BDI with global base table";
+    result.original = original;
+
+    // 2. Encode deltas against the base of the table
+    if (best_encoding >= 0) {
+        k = base_table_k[best_encoding];
+        d = base_table_d[best_encoding];
+        compressed = make_memory_chunk((original.size / k) * d, 0);
+        bdi_delta_check(original, table->bases[best_index], k, d, compressed.body);
+        base_table_touch(table, best_index);
+        table->hits += 1;
+
+#ifdef VERBOSE
+        printf("base table hit (entry: %d  encoding: %d  size: %dBytes)\n", best_index, best_encoding, compressed.size);
+#endif
+
+        set_value_bitwise(tag_overhead.body, 1, 0, 1);
+        set_value_bitwise(tag_overhead.body, best_index, BASE_TABLE_TAG_OFFSET, table->index_bits);
+        set_value_bitwise(tag_overhead.body, best_encoding, BASE_TABLE_TAG_OFFSET + table->index_bits, 4);
+        set_value_bitwise(tag_overhead.body, (ValueBuffer)ceil((double)compressed.size / BYTE_BITWIDTH), BASE_TABLE_TAG_OFFSET + table->index_bits + 4, 7);
+        tag_overhead.valid_bitwidth = BASE_TABLE_TAG_OFFSET + table->index_bits + 11;
+
+        remove_compression_result(plain);
+        result.compressed = compressed;
+        result.is_compressed = TRUE;
+        result.tag_overhead = tag_overhead;
+        return result;
+    }
+
+    // 3. Line is encoded with its own base, which is learned by the table
+    encoding = get_value_bitwise(plain.tag_overhead.body, 0, 4);
+    if (encoding >= 2 && encoding < 8)
+        base_table_insert(table, get_value(original.body, 0, base_table_k[encoding]), base_table_k[encoding]);
+
+    set_value_bitwise(tag_overhead.body, get_value_bitwise(plain.tag_overhead.body, 0, 11), BASE_TABLE_TAG_OFFSET, 11);
+    tag_overhead.valid_bitwidth = BASE_TABLE_TAG_OFFSET + 11;
+    remove_memory_chunk(plain.tag_overhead);
+
+    result.compressed = plain.compressed;
+    result.is_compressed = plain.is_compressed;
+    result.tag_overhead = tag_overhead;
+    return result;
+}
+
+DecompressionResult base_table_decompression(BaseTable *table, CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result, bdi_result;
+    MetaData bdi_tag;
+    ValueBuffer buffer;
+    int index, encoding, k, d;
+
+#ifdef VERBOSE
+    printf("Decompressing with BDI algorithm with global base table...\n");
+#endif
+
+    result.compression_type = "BDI with global base table";
+    result.compressed = compressed;
+
+    if (get_value_bitwise(tag_overhead.body, 0, 1)) {
+        index = get_value_bitwise(tag_overhead.body, BASE_TABLE_TAG_OFFSET, table->index_bits);
+        encoding = get_value_bitwise(tag_overhead.body, BASE_TABLE_TAG_OFFSET + table->index_bits, 4);
+        result.original = make_memory_chunk(original_size, 0);
+
+        if (encoding < 2 || encoding >= 8 || table->base_sizes[index] != base_table_k[encoding]) {
+            result.is_decompressed = FALSE;
+            return result;
+        }
+
+        k = base_table_k[encoding];
+        d = base_table_d[encoding];
+        for (int i = 0; i < original_size / k; i++) {
+            buffer = get_value(compressed.body, d * i, d);
+            set_value(result.original.body, buffer + table->bases[index], i * k, k);
+        }
+        base_table_touch(table, index);
+        result.is_decompressed = TRUE;
+        return result;
+    }
+
+    bdi_tag = make_memory_chunk(2, 0);
+    set_value_bitwise(bdi_tag.body, get_value_bitwise(tag_overhead.body, BASE_TABLE_TAG_OFFSET, 11), 0, 11);
+    bdi_tag.valid_bitwidth = 11;
+    encoding = get_value_bitwise(bdi_tag.body, 0, 4);
+
+    if (encoding == 15) {  // not compressed with BDI
+        bdi_result.original = make_memory_chunk(original_size, 0);
+        memcpy(bdi_result.original.body, compressed.body, original_size);
+        bdi_result.is_decompressed = TRUE;
+    } else {
+        bdi_result = bdi_decompression(compressed, bdi_tag, original_size);
+    }
+    remove_memory_chunk(bdi_tag);
+
+    if (encoding >= 2 && encoding < 8)
+        base_table_insert(table, get_value(bdi_result.original.body, 0, base_table_k[encoding]), base_table_k[encoding]);
+
+    result.original = bdi_result.original;
+    result.is_decompressed = bdi_result.is_decompressed;
+    return result;
+}
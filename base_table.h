@@ -0,0 +1,36 @@
+#ifndef BASE_TABLE
+#define BASE_TABLE
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for global base table
+#define BASE_TABLE_DEFAULT_BITS  4   // 16 bases by default
+#define BASE_TABLE_TAG_OFFSET    1   // tag_overhead = {hit(1bit), base index, BDI tag(11bits)}
+#define BASE_TABLE_MAX_BITS      16  // maximum bitwidth of base index (bases are searched linearly)
+#define BASE_TABLE_LRU           0   // replaces least recently used base
+#define BASE_TABLE_LFU           1   // replaces least frequently used base
+
+typedef struct {
+    ValueBuffer *bases;       // base values
+    int         *base_sizes;  // size of each base in bytes (0: empty entry)
+    long        *stamps;      // last access time (LRU) or access count (LFU)
+    int          index_bits;  // bitwidth of base index
+    int          capacity;    // number of entries
+    int          policy;      // replacement policy (BASE_TABLE_LRU, BASE_TABLE_LFU)
+    long         clock;       // access counter for LRU
+    long         lookups;     // number of compressed lines
+    long         hits;        // number of lines encoded with base of the table
+} BaseTable;
+
+// Functions for BDI algorithm with global base table
+BaseTable make_base_table(int index_bits, int policy);                                                                  // allocates table with 2^index_bits bases
+void reset_base_table(BaseTable *table);                                                                                // clears bases and statistics
+void remove_base_table(BaseTable table);                                                                                // removes table
+long base_table_size(BaseTable table);                                                                                  // storage cost of the table in bytes
+CompressionResult base_table_compression(BaseTable *table, CacheLine original);                                        // BDI compression algorithm with global base table
+DecompressionResult base_table_decompression(BaseTable *table, CacheLine compressed, MetaData tag_overhead, int original_size);  // BDI decompression algorithm with global base table
+
+#endif
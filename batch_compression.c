@@ -0,0 +1,373 @@
+#include "batch_compression.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+ * Functions for batch compression
+ *   Algorithms are called per line through a function pointer and return CompressionResult with
+ *   two heap chunks, while testbenches process lines in bulk. Batch entry points compress N lines
+ *   of a contiguous buffer per call and fill structure-of-arrays results (sizes, encodings, tag
+ *   bitwidths, compressed flags and optionally the compressed lines).
+ *
+ *   batch_compression runs any per-line algorithm over a batch. Algorithms with a batch kernel
+ *   (BDI, zero vector) compute sizes without allocation when payloads are not kept, and fall back
+ *   to the per-line algorithm for payloads. Results are identical to the per-line algorithm.
+ *
+ *   BDI kernel compresses BATCH_LANE_NUM lines in parallel with each SIMD lane holding a different
+ *   line (bdi_lane_encodings): 32Bytes of 4 lines are loaded and transposed into 8Bytes words of
+ *   each line (words after the last 32Bytes are gathered), and feasibility of every
+ *   encoding is accumulated without branches, so lines do not diverge at early exits. Elements of
+ *   4Bytes and 2Bytes bases are differences of 32/16bit lanes of the words against the lane of
+ *   the first element, with signed overflow check (deltas of sign extended elements as BDI).
+ *   Without AVX2, SSE2 (every x86-64 build) holds 2 lines per register and loads 16Bytes of each.
+ *
+ * Functions:
+ *   make_batch_result: allocates result arrays (payloads are optional)
+ *   remove_batch_result: removes result arrays
+ *   batch_compression: per-line algorithm over a batch
+ *   bdi_batch_compression: BDI without allocation (sizes only)
+ *   bdi_lane_encodings: BDI encodings and sizes of BATCH_LANE_NUM lines (one line per SIMD lane)
+ *   zero_vec_batch_compression: zero vector without allocation (sizes only)
+ *
+ * Note
+ *   Payloads are stored at line_size stride (compressed lines are not larger than the original),
+ *   and the next line is prefetched while a line is compressed. Lane kernel is selected at compile
+ *   time (AVX2, SSE2 or scalar)
+ */
+
+#define BATCH_PREFETCH(lines, l, line_num, line_size) \
+    do { if ((l) + 1 < (line_num)) __builtin_prefetch((lines) + (long)((l) + 1) * (line_size)); } while (0)
+
+BatchResult make_batch_result(int capacity, int line_size, Bool keep_payloads) {
+    BatchResult result;
+    result.capacity = capacity;
+    result.line_num = 0;
+    result.line_size = line_size;
+    result.sizes = (int *)malloc(sizeof(int) * capacity);
+    result.encodings = (int *)malloc(sizeof(int) * capacity);
+    result.tag_bits = (int *)malloc(sizeof(int) * capacity);
+    result.compressed = (Bool *)malloc(sizeof(Bool) * capacity);
+    result.payloads = keep_payloads ? (ByteArr)malloc((long)capacity * line_size) : NULL;
+    return result;
+}
+
+void remove_batch_result(BatchResult result) {
+    free(result.sizes);
+    free(result.encodings);
+    free(result.tag_bits);
+    free(result.compressed);
+    free(result.payloads);
+}
+
+void batch_compression(CompressionResult (*func)(CacheLine), ByteArr lines, int line_num, BatchResult *result) {
+    CompressionResult line_result;
+    CacheLine line;
+    int line_size = result->line_size;
+
+    line.size = line_size;
+    line.valid_bitwidth = line_size * BYTE_BITWIDTH;
+    result->line_num = line_num < result->capacity ? line_num : result->capacity;
+
+    for (int l = 0; l < result->line_num; l++) {
+        BATCH_PREFETCH(lines, l, result->line_num, line_size);
+        line.body = lines + (long)l * line_size;
+        line_result = func(line);
+
+        result->sizes[l] = line_result.compressed.size;
+        result->encodings[l] = BATCH_NO_ENCODING;
+        result->tag_bits[l] = line_result.tag_overhead.valid_bitwidth;
+        result->compressed[l] = line_result.is_compressed;
+        if (result->payloads != NULL)
+            memcpy(result->payloads + (long)l * line_size, line_result.compressed.body,
+                   line_result.compressed.size < line_size ? line_result.compressed.size : line_size);
+
+        remove_compression_result(line_result);
+    }
+}
+
+static int bdi_batch_encoding(CacheLine line, int *compressed_size) {
+    static const int bases[8] = {0, 8, 8, 4, 2, 8, 4, 8};   // k of each encoding (as bdi_compressing_unit)
+    static const int deltas[8] = {0, 0, 1, 1, 1, 2, 2, 4};  // d of each encoding
+    ValueBuffer first, buffer;
+    Bool feasible;
+    int size;
+
+    for (int encoding = 0; encoding < 8; encoding++) {
+        switch (encoding) {
+        case 0:  // Zero values
+            feasible = TRUE;
+            for (int i = 0; i < line.size && feasible; i += 8) {
+                memcpy(&buffer, line.body + i, 8);
+                feasible = buffer == 0;
+            }
+            size = 1;
+            break;
+
+        case 1:  // Repeated values
+            feasible = TRUE;
+            memcpy(&first, line.body, 8);
+            for (int i = 8; i < line.size && feasible; i += 8) {
+                memcpy(&buffer, line.body + i, 8);
+                feasible = buffer == first;
+            }
+            size = 8;
+            break;
+
+        default:
+            size = bases[encoding] + ((line.size + bases[encoding] - 1) / bases[encoding]) * deltas[encoding];
+            feasible = size < line.size && bdi_delta_check(line, get_value(line.body, 0, bases[encoding]), bases[encoding], deltas[encoding], NULL);
+            break;
+        }
+
+        if (feasible && size < line.size) {
+            *compressed_size = size;
+            return encoding;
+        }
+    }
+
+    *compressed_size = line.size;
+    return 15;  // uncompressed
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+static int bdi_lane_size(int encoding, int line_size) {
+    static const int bases[8] = {0, 8, 8, 4, 2, 8, 4, 8};
+    static const int deltas[8] = {0, 0, 1, 1, 1, 2, 2, 4};
+
+    if (encoding == 0) return 1;
+    if (encoding == 1) return 8;
+    return bases[encoding] + ((line_size + bases[encoding] - 1) / bases[encoding]) * deltas[encoding];
+}
+#endif
+
+#if defined(__AVX2__)
+static inline void bdi_lane_accumulate(__m256i *acc, __m256i word, __m256i base8, __m256i base4, __m256i base2) {
+    const __m256i bias8[3] = {_mm256_set1_epi64x(0x80), _mm256_set1_epi64x(0x8000), _mm256_set1_epi64x(0x80000000LL)};
+    const __m256i high8[3] = {_mm256_set1_epi64x(~0xffLL), _mm256_set1_epi64x(~0xffffLL), _mm256_set1_epi64x(~0xffffffffLL)};
+    const __m256i bias4[2] = {_mm256_set1_epi32(0x80), _mm256_set1_epi32(0x8000)};
+    const __m256i high4[2] = {_mm256_set1_epi32(~0xff), _mm256_set1_epi32(~0xffff)};
+    const __m256i sign4 = _mm256_set1_epi32((int)0x80000000);
+    const __m256i bias2 = _mm256_set1_epi16(0x80), high2 = _mm256_set1_epi16((short)0xff00), sign2 = _mm256_set1_epi16((short)0x8000);
+    __m256i delta, overflow;
+
+    // zeros and repeated values
+    acc[0] = _mm256_or_si256(acc[0], word);
+    acc[1] = _mm256_or_si256(acc[1], _mm256_xor_si256(word, base8));
+
+    // 8Bytes base (delta wraps around as ValueBuffer)
+    delta = _mm256_sub_epi64(word, base8);
+    acc[2] = _mm256_or_si256(acc[2], _mm256_and_si256(_mm256_add_epi64(delta, bias8[0]), high8[0]));
+    acc[5] = _mm256_or_si256(acc[5], _mm256_and_si256(_mm256_add_epi64(delta, bias8[1]), high8[1]));
+    acc[7] = _mm256_or_si256(acc[7], _mm256_and_si256(_mm256_add_epi64(delta, bias8[2]), high8[2]));
+
+    // 4Bytes base (32bit lanes, overflow means delta does not fit)
+    delta = _mm256_sub_epi32(word, base4);
+    overflow = _mm256_and_si256(_mm256_and_si256(_mm256_xor_si256(word, base4), _mm256_xor_si256(word, delta)), sign4);
+    acc[3] = _mm256_or_si256(acc[3], _mm256_or_si256(overflow, _mm256_and_si256(_mm256_add_epi32(delta, bias4[0]), high4[0])));
+    acc[6] = _mm256_or_si256(acc[6], _mm256_or_si256(overflow, _mm256_and_si256(_mm256_add_epi32(delta, bias4[1]), high4[1])));
+
+    // 2Bytes base (16bit lanes)
+    delta = _mm256_sub_epi16(word, base2);
+    overflow = _mm256_and_si256(_mm256_and_si256(_mm256_xor_si256(word, base2), _mm256_xor_si256(word, delta)), sign2);
+    acc[4] = _mm256_or_si256(acc[4], _mm256_or_si256(overflow, _mm256_and_si256(_mm256_add_epi16(delta, bias2), high2)));
+}
+#elif defined(__SSE2__)
+static inline void bdi_lane_accumulate(__m128i *acc, __m128i word, __m128i base8, __m128i base4, __m128i base2) {
+    const __m128i bias8[3] = {_mm_set1_epi64x(0x80), _mm_set1_epi64x(0x8000), _mm_set1_epi64x(0x80000000LL)};
+    const __m128i high8[3] = {_mm_set1_epi64x(~0xffLL), _mm_set1_epi64x(~0xffffLL), _mm_set1_epi64x(~0xffffffffLL)};
+    const __m128i bias4[2] = {_mm_set1_epi32(0x80), _mm_set1_epi32(0x8000)};
+    const __m128i high4[2] = {_mm_set1_epi32(~0xff), _mm_set1_epi32(~0xffff)};
+    const __m128i sign4 = _mm_set1_epi32((int)0x80000000);
+    const __m128i bias2 = _mm_set1_epi16(0x80), high2 = _mm_set1_epi16((short)0xff00), sign2 = _mm_set1_epi16((short)0x8000);
+    __m128i delta, overflow;
+
+    // zeros and repeated values
+    acc[0] = _mm_or_si128(acc[0], word);
+    acc[1] = _mm_or_si128(acc[1], _mm_xor_si128(word, base8));
+
+    // 8Bytes base (delta wraps around as ValueBuffer)
+    delta = _mm_sub_epi64(word, base8);
+    acc[2] = _mm_or_si128(acc[2], _mm_and_si128(_mm_add_epi64(delta, bias8[0]), high8[0]));
+    acc[5] = _mm_or_si128(acc[5], _mm_and_si128(_mm_add_epi64(delta, bias8[1]), high8[1]));
+    acc[7] = _mm_or_si128(acc[7], _mm_and_si128(_mm_add_epi64(delta, bias8[2]), high8[2]));
+
+    // 4Bytes base (32bit lanes, overflow means delta does not fit)
+    delta = _mm_sub_epi32(word, base4);
+    overflow = _mm_and_si128(_mm_and_si128(_mm_xor_si128(word, base4), _mm_xor_si128(word, delta)), sign4);
+    acc[3] = _mm_or_si128(acc[3], _mm_or_si128(overflow, _mm_and_si128(_mm_add_epi32(delta, bias4[0]), high4[0])));
+    acc[6] = _mm_or_si128(acc[6], _mm_or_si128(overflow, _mm_and_si128(_mm_add_epi32(delta, bias4[1]), high4[1])));
+
+    // 2Bytes base (16bit lanes)
+    delta = _mm_sub_epi16(word, base2);
+    overflow = _mm_and_si128(_mm_and_si128(_mm_xor_si128(word, base2), _mm_xor_si128(word, delta)), sign2);
+    acc[4] = _mm_or_si128(acc[4], _mm_or_si128(overflow, _mm_and_si128(_mm_add_epi16(delta, bias2), high2)));
+}
+#endif
+
+void bdi_lane_encodings(ByteArr lines, int line_size, int *encodings, int *sizes) {
+#if defined(__AVX2__)
+    int feasible[BATCH_LANE_NUM] = {0};  // bit e is set if encoding e is feasible for the line
+    int candidates = 0, mask;
+    const __m256i zeros = _mm256_setzero_si256();
+    __m256i acc[8], base8, base4, base2, row[4], half[4];
+    __m256i index;
+    ByteArr quad;
+    int w;
+
+    for (int e = 0; e < 8; e++)  // encodings smaller than the line
+        if (bdi_lane_size(e, line_size) < line_size)
+            candidates |= 1 << e;
+
+    for (int h = 0; h < 2; h++) {  // lines 0-3 and 4-7 (4 x 64bit lanes)
+        quad = lines + (long)h * 4 * line_size;
+        index = _mm256_setr_epi64x(0, line_size, 2L * line_size, 3L * line_size);
+        for (int e = 0; e < 8; e++)
+            acc[e] = zeros;
+
+        base8 = _mm256_i64gather_epi64((long long const *)quad, index, 1);
+        base4 = _mm256_shuffle_epi32(base8, 0xa0);                                 // first 4Bytes element on both halves
+        base2 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(base8, 0), 0);      // first 2Bytes element on every quarter
+
+        // 32Bytes of 4 lines are loaded and transposed (4 x 4 words, order of words does not matter)
+        for (w = 0; w + 32 <= line_size; w += 32) {
+            for (int l = 0; l < 4; l++)
+                row[l] = _mm256_loadu_si256((__m256i const *)(quad + (long)l * line_size + w));
+            half[0] = _mm256_unpacklo_epi64(row[0], row[1]);
+            half[1] = _mm256_unpackhi_epi64(row[0], row[1]);
+            half[2] = _mm256_unpacklo_epi64(row[2], row[3]);
+            half[3] = _mm256_unpackhi_epi64(row[2], row[3]);
+            bdi_lane_accumulate(acc, _mm256_permute2x128_si256(half[0], half[2], 0x20), base8, base4, base2);
+            bdi_lane_accumulate(acc, _mm256_permute2x128_si256(half[1], half[3], 0x20), base8, base4, base2);
+            bdi_lane_accumulate(acc, _mm256_permute2x128_si256(half[0], half[2], 0x31), base8, base4, base2);
+            bdi_lane_accumulate(acc, _mm256_permute2x128_si256(half[1], half[3], 0x31), base8, base4, base2);
+        }
+        for (; w < line_size; w += 8)  // remaining words are gathered
+            bdi_lane_accumulate(acc, _mm256_i64gather_epi64((long long const *)(quad + w), index, 1), base8, base4, base2);
+
+        for (int e = 0; e < 8; e++) {
+            mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(acc[e], zeros)));
+            for (int l = 0; l < 4; l++)
+                feasible[h * 4 + l] |= ((mask >> l) & 1) << e;
+        }
+    }
+
+    // first feasible encoding smaller than the line (as bdi_compression)
+    for (int l = 0; l < BATCH_LANE_NUM; l++) {
+        mask = feasible[l] & candidates;
+        encodings[l] = mask ? __builtin_ctz(mask) : 15;
+        sizes[l] = mask ? bdi_lane_size(encodings[l], line_size) : line_size;
+    }
+#elif defined(__SSE2__)
+    int feasible[BATCH_LANE_NUM] = {0};  // bit e is set if encoding e is feasible for the line
+    int candidates = 0, mask;
+    __m128i acc[8], base8, base4, base2, row[2];
+    uint64_t words[2];
+    ByteArr pair;
+    int w;
+
+    for (int e = 0; e < 8; e++)  // encodings smaller than the line
+        if (bdi_lane_size(e, line_size) < line_size)
+            candidates |= 1 << e;
+
+    for (int p = 0; p < BATCH_LANE_NUM / 2; p++) {  // pairs of lines (2 x 64bit lanes)
+        pair = lines + (long)p * 2 * line_size;
+        for (int e = 0; e < 8; e++)
+            acc[e] = _mm_setzero_si128();
+
+        base8 = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i const *)pair), _mm_loadl_epi64((__m128i const *)(pair + line_size)));
+        base4 = _mm_shuffle_epi32(base8, 0xa0);                              // first 4Bytes element on both halves
+        base2 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(base8, 0), 0);      // first 2Bytes element on every quarter
+
+        // 16Bytes of 2 lines are loaded and transposed (2 x 2 words)
+        for (w = 0; w + 16 <= line_size; w += 16) {
+            row[0] = _mm_loadu_si128((__m128i const *)(pair + w));
+            row[1] = _mm_loadu_si128((__m128i const *)(pair + line_size + w));
+            bdi_lane_accumulate(acc, _mm_unpacklo_epi64(row[0], row[1]), base8, base4, base2);
+            bdi_lane_accumulate(acc, _mm_unpackhi_epi64(row[0], row[1]), base8, base4, base2);
+        }
+        if (w < line_size)  // remaining word
+            bdi_lane_accumulate(acc, _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i const *)(pair + w)), _mm_loadl_epi64((__m128i const *)(pair + line_size + w))),
+                                base8, base4, base2);
+
+        for (int e = 0; e < 8; e++) {  // no 64bit compare in SSE2
+            _mm_storeu_si128((__m128i *)words, acc[e]);
+            feasible[p * 2] |= (words[0] == 0) << e;
+            feasible[p * 2 + 1] |= (words[1] == 0) << e;
+        }
+    }
+
+    // first feasible encoding smaller than the line (as bdi_compression)
+    for (int l = 0; l < BATCH_LANE_NUM; l++) {
+        mask = feasible[l] & candidates;
+        encodings[l] = mask ? __builtin_ctz(mask) : 15;
+        sizes[l] = mask ? bdi_lane_size(encodings[l], line_size) : line_size;
+    }
+#else
+    CacheLine line;
+
+    line.size = line_size;
+    line.valid_bitwidth = line_size * BYTE_BITWIDTH;
+    for (int l = 0; l < BATCH_LANE_NUM; l++) {
+        line.body = lines + (long)l * line_size;
+        encodings[l] = bdi_batch_encoding(line, &sizes[l]);
+    }
+#endif
+}
+
+void bdi_batch_compression(ByteArr lines, int line_num, BatchResult *result) {
+    CacheLine line;
+    int line_size = result->line_size, lane_end;
+
+    if (result->payloads != NULL || line_size % 8 != 0) {  // only sizes of 8Bytes aligned lines are computed in place
+        batch_compression(bdi_compression, lines, line_num, result);
+        return;
+    }
+
+    line.size = line_size;
+    line.valid_bitwidth = line_size * BYTE_BITWIDTH;
+    result->line_num = line_num < result->capacity ? line_num : result->capacity;
+
+    lane_end = result->line_num - result->line_num % BATCH_LANE_NUM;
+    for (int l = 0; l < lane_end; l += BATCH_LANE_NUM)
+        bdi_lane_encodings(lines + (long)l * line_size, line_size, &result->encodings[l], &result->sizes[l]);
+
+    for (int l = lane_end; l < result->line_num; l++) {  // lines after the last group of lanes
+        line.body = lines + (long)l * line_size;
+        result->encodings[l] = bdi_batch_encoding(line, &result->sizes[l]);
+    }
+
+    for (int l = 0; l < result->line_num; l++) {
+        result->tag_bits[l] = 11;  // {encoding(4bits), segment_pointer(7bits)}
+        result->compressed[l] = result->encodings[l] != 15;
+    }
+}
+
+void zero_vec_batch_compression(ByteArr lines, int line_num, BatchResult *result) {
+    Byte mask[ZERO_RUN_MASK_SIZ];
+    CacheLine line;
+    int line_size = result->line_size, nonzero_cnt;
+
+    if (result->payloads != NULL || (line_size + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH > ZERO_RUN_MASK_SIZ) {
+        batch_compression(zero_vec_compression, lines, line_num, result);
+        return;
+    }
+
+    line.size = line_size;
+    line.valid_bitwidth = line_size * BYTE_BITWIDTH;
+    result->line_num = line_num < result->capacity ? line_num : result->capacity;
+
+    for (int l = 0; l < result->line_num; l++) {
+        BATCH_PREFETCH(lines, l, result->line_num, line_size);
+        line.body = lines + (long)l * line_size;
+        nonzero_cnt = zero_vec_mask(line, mask);
+
+        // lines with less than half zero bytes are not compressed (as zero_vec_compression)
+        result->compressed[l] = (double)(line_size - nonzero_cnt) / line_size >= 0.5;
+        result->sizes[l] = result->compressed[l] ? (line_size + nonzero_cnt * BYTE_BITWIDTH) / BYTE_BITWIDTH : line_size;
+        result->encodings[l] = BATCH_NO_ENCODING;
+        result->tag_bits[l] = 0;
+    }
+}
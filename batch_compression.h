@@ -0,0 +1,33 @@
+#ifndef BATCH_COMPRESSION
+#define BATCH_COMPRESSION
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for batch compression
+#define BATCH_DEFAULT_LINES  1024  // lines per batch of testbenches
+#define BATCH_NO_ENCODING    -1    // encoding of algorithms without encoding field (per-line fallback)
+#define BATCH_LANE_NUM       8     // lines compressed in parallel by lane kernels (one line per SIMD lane)
+
+typedef struct {
+    int       capacity;     // maximum number of lines
+    int       line_num;     // number of lines in the batch
+    int       line_size;    // size of lines
+    int      *sizes;        // compressed size of each line
+    int      *encodings;    // encoding of each line (algorithm specific, BATCH_NO_ENCODING if not available)
+    int      *tag_bits;     // valid bitwidth of tag overhead of each line
+    Bool     *compressed;   // whether each line is compressed
+    ByteArr   payloads;     // compressed lines at line_size stride (NULL: sizes only)
+} BatchResult;
+
+// Functions for batch compression (N contiguous lines per call, structure-of-arrays results)
+BatchResult make_batch_result(int capacity, int line_size, Bool keep_payloads);                                          // allocates result arrays (payloads are optional)
+void remove_batch_result(BatchResult result);                                                                             // removes result arrays
+void batch_compression(CompressionResult (*func)(CacheLine), ByteArr lines, int line_num, BatchResult *result);        // per-line algorithm over a batch
+void bdi_batch_compression(ByteArr lines, int line_num, BatchResult *result);                                            // BDI without allocation (sizes only)
+void bdi_lane_encodings(ByteArr lines, int line_size, int *encodings, int *sizes);                                       // BDI encodings and sizes of BATCH_LANE_NUM lines (8Bytes aligned)
+void zero_vec_batch_compression(ByteArr lines, int line_num, BatchResult *result);                                       // zero vector without allocation (sizes only)
+
+#endif
@@ -28,9 +28,9 @@ CompressionResult bdi_zv_compression(CacheLine original) {
 
 
 Bool bdi_zv_compressing_unit(CacheLine original, CacheLine *compressed, MetaData *tag_overhead, int encoding) {
-    MetaData target_bytearr = make_memory_chunk(original.size, 0);
-    ValueBuffer base, buffer, delta, mask;
-    int k, d, compressed_size;
+    MetaData target_bytearr;
+    ValueBuffer base, buffer, delta, mask = 0;
+    int k, d, compressed_size = 0;
     Bool flag;
 
     switch (encoding) {
@@ -99,6 +99,7 @@ Bool bdi_zv_compressing_unit(CacheLine original, CacheLine *compressed, MetaData
     }
 
     int target_offset = 0;
+    target_bytearr = make_memory_chunk(original.size, 0);
 
     for (int i = 0; i < original.size; i++) {
         if (original.body[i] == 0) {
@@ -117,6 +118,7 @@ Bool bdi_zv_compressing_unit(CacheLine original, CacheLine *compressed, MetaData
         }
         compressed->size = compressed_size + target_offset;
         compressed->valid_bitwidth = (compressed_size + target_offset) * BYTE_BITWIDTH;
+        remove_memory_chunk(target_bytearr);
         return TRUE;
     }
 
@@ -141,6 +143,8 @@ Bool bdi_zv_compressing_unit(CacheLine original, CacheLine *compressed, MetaData
         compressed_size += d;
     }
 
+    compressed->size = compressed_size;
+    compressed->valid_bitwidth = compressed_size * BYTE_BITWIDTH;
     remove_memory_chunk(target_bytearr);
     return TRUE;
 }
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include "block_compression.h"
+
+
+/*
+ * Functions for page-scale block mode of BDI algorithm
+ *   Block mode compresses 1-4KB blocks (e.g. pages) as a set of sub-lines. Instead of storing a
+ *   base per sub-line, one base per element size is shared across every sub-line of the block,
+ *   and each element of a sub-line selects either the shared base or the implicit zero base.
+ *   Metadata is segmented into streams so that each stream stays densely packed:
+ *
+ *   [header: base mask(1Byte) + shared bases][encoding stream: 4bits per sub-line]
+ *   [selection stream: 1bit per element of BDI encoded sub-lines][payload stream]
+ *
+ *   Encodings follow bdi_compressing_unit: 0 (zeros), 1 (repeated 8Bytes), 2-7 (Base-Delta),
+ *   15 (uncompressed). tag_overhead = {compressed(1bit), sub-line size(16bits)}
+ *
+ * Functions:
+ *   block_bdi_compression: block mode with default sub-line size (BLOCK_SUBLINE_SIZ)
+ *   block_bdi_compression_subline: block mode with given sub-line size
+ *   block_bdi_decompression: block mode decompression
+ */
+
+static const int block_k[8] = {0, 8, 8, 4, 2, 8, 4, 8};  // element size of each encoding
+static const int block_d[8] = {0, 0, 1, 1, 1, 2, 2, 4};  // delta size of each encoding
+
+static int block_base_index(int k) {
+    return k == 8 ? 0 : (k == 4 ? 1 : 2);
+}
+
+// reads sign-extended k-Byte element (k = 1, 2, 4, 8)
+static ValueBuffer block_get_elem(ByteArr arr, int k) {
+    ValueBuffer b8;
+    WordBuffer b4;
+    HwordBuffer b2;
+
+    switch (k) {
+    case 8:
+        memcpy(&b8, arr, 8);
+        return b8;
+    case 4:
+        memcpy(&b4, arr, 4);
+        return b4;
+    case 2:
+        memcpy(&b2, arr, 2);
+        return b2;
+    default:
+        return (ByteBuffer)arr[0];
+    }
+}
+
+static Bool block_fits(ValueBuffer val, int d) {
+    switch (d) {
+    case 1:
+        return val == (ByteBuffer)val;
+    case 2:
+        return val == (HwordBuffer)val;
+    default:
+        return val == (WordBuffer)val;
+    }
+}
+
+// returns bits of payload and selection stream of the sub-line with given encoding (-1: infeasible)
+static int block_encoding_bits(ByteArr subline, int subline_size, ValueBuffer base, int encoding) {
+    int k = block_k[encoding], d = block_d[encoding];
+    ValueBuffer buffer;
+
+    for (int i = 0; i < subline_size; i += k) {
+        buffer = block_get_elem(subline + i, k);
+        if (!block_fits((ValueBuffer)((uint64_t)buffer - base), d) && !block_fits(buffer, d))
+            return -1;
+    }
+
+    return (subline_size / k) * (d * BYTE_BITWIDTH + 1);
+}
+
+CompressionResult block_bdi_compression(CacheLine original) {
+    return block_bdi_compression_subline(original, BLOCK_SUBLINE_SIZ);
+}
+
+CompressionResult block_bdi_compression_subline(CacheLine original, int subline_size) {
+    CompressionResult result;
+    CacheLine compressed;
+    MetaData tag_overhead = make_memory_chunk(3, 0);
+    ValueBuffer bases[3] = {0, 0, 0};
+    ValueBuffer buffer, base;
+    Bool base_found[3] = {FALSE, FALSE, FALSE};
+    Byte base_mask = 0;
+    int subline_num, best_bits, bits, k, d;
+    int header_size, encoding_pivot, selection_pivot, payload_offset, compressed_size;
+    int *encodings;
+
+#ifdef VERBOSE
+    printf("Compressing with block mode BDI algorithm...\n");
+#endif
+
+    result.compression_type = "Block mode BDI(Base Delta Immediate)";
+    result.original = original;
+    set_value_bitwise(tag_overhead.body, subline_size, 1, 16);
+    tag_overhead.valid_bitwidth = 17;
+
+    if (subline_size > original.size) subline_size = original.size;
+
+    if (subline_size % DWORDSIZ != 0 || original.size % subline_size != 0) {
+#ifdef VERBOSE
+        printf("failed due to unsupported block size (block: %dBytes  sub-line: %dBytes)\n", original.size, subline_size);
+#endif
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+        result.tag_overhead = tag_overhead;
+        return result;
+    }
+
+    subline_num = original.size / subline_size;
+    encodings = (int *)malloc(sizeof(int) * subline_num);
+
+    // 1. Find out shared bases (first non-zero element of each element size)
+    for (int i = 0; i < original.size; i += 2) {
+        for (int b = 0, k = 8; k >= 2; b++, k /= 2) {
+            if (base_found[b] || i % k != 0) continue;
+            buffer = block_get_elem(original.body + i, k);
+            if (buffer != 0) {
+                bases[b] = buffer;
+                base_found[b] = TRUE;
+            }
+        }
+        if (base_found[0] && base_found[1] && base_found[2]) break;
+    }
+
+    // 2. Select the smallest encoding of each sub-line
+    for (int s = 0; s < subline_num; s++) {
+        ByteArr subline = original.body + s * subline_size;
+
+        encodings[s] = BLOCK_UNCOMPRESSED;
+        best_bits = subline_size * BYTE_BITWIDTH;
+
+        for (bits = 0; bits < subline_size && subline[bits] == 0; bits++) {}
+        if (bits == subline_size) {
+            encodings[s] = 0;
+            continue;
+        }
+
+        base = block_get_elem(subline, 8);
+        for (bits = 8; bits < subline_size && block_get_elem(subline + bits, 8) == base; bits += 8) {}
+        if (bits == subline_size && 64 < best_bits) {
+            encodings[s] = 1;
+            best_bits = 64;
+        }
+
+        for (int encoding = 2; encoding < 8; encoding++) {
+            bits = block_encoding_bits(subline, subline_size, bases[block_base_index(block_k[encoding])], encoding);
+            if (bits >= 0 && bits < best_bits) {
+                encodings[s] = encoding;
+                best_bits = bits;
+            }
+        }
+
+        if (encodings[s] >= 2 && encodings[s] < 8)
+            base_mask |= 1 << block_base_index(block_k[encodings[s]]);
+
+#ifdef VERBOSE
+        printf("[SUBLINE %2d] encoding: %d  bits: %d\n", s, encodings[s], best_bits);
+#endif
+    }
+
+    // 3. Calculate the layout of segmented streams
+    header_size = 1;
+    for (int b = 0, k = 8; k >= 2; b++, k /= 2)
+        if (base_mask & (1 << b)) header_size += k;
+
+    encoding_pivot = header_size * BYTE_BITWIDTH;
+    selection_pivot = encoding_pivot + ((subline_num * BLOCK_ENCODING_BITS + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH) * BYTE_BITWIDTH;
+    payload_offset = selection_pivot;
+    for (int s = 0; s < subline_num; s++)
+        if (encodings[s] >= 2 && encodings[s] < 8)
+            payload_offset += subline_size / block_k[encodings[s]];
+    payload_offset = (payload_offset + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+
+    compressed_size = payload_offset;
+    for (int s = 0; s < subline_num; s++) {
+        if (encodings[s] == 1)
+            compressed_size += 8;
+        else if (encodings[s] == BLOCK_UNCOMPRESSED)
+            compressed_size += subline_size;
+        else if (encodings[s] != 0)
+            compressed_size += (subline_size / block_k[encodings[s]]) * block_d[encodings[s]];
+    }
+
+    if (compressed_size >= original.size) {
+#ifdef VERBOSE
+        printf("compression failed (compressed size: %dBytes)\n", compressed_size);
+#endif
+        free(encodings);
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+        result.tag_overhead = tag_overhead;
+        return result;
+    }
+
+    // 4. Write header and streams
+    compressed = make_memory_chunk(compressed_size, 0);
+    compressed.body[0] = base_mask;
+    for (int b = 0, k = 8, offset = 1; k >= 2; b++, k /= 2) {
+        if (base_mask & (1 << b)) {
+            memcpy(compressed.body + offset, &bases[b], k);
+            offset += k;
+        }
+    }
+
+    for (int s = 0; s < subline_num; s++) {
+        ByteArr subline = original.body + s * subline_size;
+
+        set_value_bitwise(compressed.body, encodings[s], encoding_pivot + s * BLOCK_ENCODING_BITS, BLOCK_ENCODING_BITS);
+
+        switch (encodings[s]) {
+        case 0:
+            break;
+
+        case 1:
+            memcpy(compressed.body + payload_offset, subline, 8);
+            payload_offset += 8;
+            break;
+
+        case BLOCK_UNCOMPRESSED:
+            memcpy(compressed.body + payload_offset, subline, subline_size);
+            payload_offset += subline_size;
+            break;
+
+        default:
+            k = block_k[encodings[s]];
+            d = block_d[encodings[s]];
+            base = bases[block_base_index(k)];
+            for (int i = 0; i < subline_size; i += k) {
+                buffer = block_get_elem(subline + i, k);
+                if (!block_fits((ValueBuffer)((uint64_t)buffer - base), d)) {
+                    set_value_bitwise(compressed.body, 1, selection_pivot, 1);  // implicit zero base
+                } else {
+                    buffer = (ValueBuffer)((uint64_t)buffer - base);
+                }
+                memcpy(compressed.body + payload_offset, &buffer, d);
+                payload_offset += d;
+                selection_pivot += 1;
+            }
+            break;
+        }
+    }
+
+    free(encodings);
+
+    compressed.valid_bitwidth = compressed_size * BYTE_BITWIDTH;
+    set_value_bitwise(tag_overhead.body, 1, 0, 1);
+    result.compressed = compressed;
+    result.is_compressed = TRUE;
+    result.tag_overhead = tag_overhead;
+
+#ifdef VERBOSE
+    printf("compression completed (compressed size: %dBytes)\n", compressed_size);
+#endif
+
+    return result;
+}
+
+DecompressionResult block_bdi_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result;
+    CacheLine original = make_memory_chunk(original_size, 0);
+    ValueBuffer bases[3] = {0, 0, 0};
+    ValueBuffer buffer;
+    Byte base_mask;
+    int subline_size = get_value_bitwise(tag_overhead.body, 1, 16);
+    int subline_num, encoding, k, d, offset;
+    int encoding_pivot, selection_pivot, payload_offset;
+
+#ifdef VERBOSE
+    printf("Decompressing with block mode BDI algorithm...\n");
+#endif
+
+    result.compression_type = "Block mode BDI(Base Delta Immediate)";
+    result.compressed = compressed;
+    result.original = original;
+    result.is_decompressed = TRUE;
+
+    if (get_value_bitwise(tag_overhead.body, 0, 1) == 0) {
+        memcpy(original.body, compressed.body, original_size);
+        return result;
+    }
+
+    if (subline_size > original_size) subline_size = original_size;
+    subline_num = original_size / subline_size;
+
+    // 1. Read header
+    base_mask = compressed.body[0];
+    offset = 1;
+    for (int b = 0, k = 8; k >= 2; b++, k /= 2) {
+        if (base_mask & (1 << b)) {
+            bases[b] = block_get_elem(compressed.body + offset, k);
+            offset += k;
+        }
+    }
+
+    // 2. Locate streams
+    encoding_pivot = offset * BYTE_BITWIDTH;
+    selection_pivot = encoding_pivot + ((subline_num * BLOCK_ENCODING_BITS + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH) * BYTE_BITWIDTH;
+    payload_offset = selection_pivot;
+    for (int s = 0; s < subline_num; s++) {
+        encoding = get_value_bitwise(compressed.body, encoding_pivot + s * BLOCK_ENCODING_BITS, BLOCK_ENCODING_BITS);
+        if (encoding >= 2 && encoding < 8)
+            payload_offset += subline_size / block_k[encoding];
+    }
+    payload_offset = (payload_offset + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+
+    // 3. Restore sub-lines
+    for (int s = 0; s < subline_num; s++) {
+        ByteArr subline = original.body + s * subline_size;
+        encoding = get_value_bitwise(compressed.body, encoding_pivot + s * BLOCK_ENCODING_BITS, BLOCK_ENCODING_BITS);
+
+        switch (encoding) {
+        case 0:
+            break;
+
+        case 1:
+            for (int i = 0; i < subline_size; i += 8)
+                memcpy(subline + i, compressed.body + payload_offset, 8);
+            payload_offset += 8;
+            break;
+
+        case BLOCK_UNCOMPRESSED:
+            memcpy(subline, compressed.body + payload_offset, subline_size);
+            payload_offset += subline_size;
+            break;
+
+        default:
+            k = block_k[encoding];
+            d = block_d[encoding];
+            for (int i = 0; i < subline_size; i += k) {
+                buffer = block_get_elem(compressed.body + payload_offset, d);
+                if (get_value_bitwise(compressed.body, selection_pivot, 1) == 0)
+                    buffer = (ValueBuffer)((uint64_t)buffer + bases[block_base_index(k)]);
+                memcpy(subline + i, &buffer, k);
+                payload_offset += d;
+                selection_pivot += 1;
+            }
+            break;
+        }
+    }
+
+#ifdef VERBOSE
+    printf("decompression completed\n");
+#endif
+
+    return result;
+}
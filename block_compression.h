@@ -0,0 +1,20 @@
+#ifndef BLOCK_COMPRESSION
+#define BLOCK_COMPRESSION
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for page-scale block mode
+#define PAGE4KSIZ            4096  // 4KB page
+#define BLOCK_SUBLINE_SIZ    64    // default sub-line size of block mode
+#define BLOCK_ENCODING_BITS  4     // bitwidth of per sub-line encoding
+#define BLOCK_UNCOMPRESSED   15    // encoding of uncompressed sub-line
+
+// Functions for page-scale block mode of BDI algorithm
+CompressionResult block_bdi_compression(CacheLine original);                                                   // Block mode with default sub-line size
+CompressionResult block_bdi_compression_subline(CacheLine original, int subline_size);                         // Block mode BDI with bases shared across sub-lines
+DecompressionResult block_bdi_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);  // Block mode BDI decompression
+
+#endif
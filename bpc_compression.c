@@ -0,0 +1,323 @@
+#include "bpc_compression.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+ * Functions for BPC algorithm
+ *   BPC(Bit-Plane Compression) transforms the cacheline into delta values of 32bit words,
+ *   transposes those deltas into bit-planes and XORs adjacent planes (DBX). Since DNN data and
+ *   other homogeneously typed data share their high-order bits, most of the DBX planes become
+ *   zero and are encoded with run-length and frequent pattern codewords.
+ *
+ * Functions:
+ *   bpc_compression: BPC compression algorithm
+ *   bpc_decompression: BPC decompression algorithm
+ *   bpc_delta_bitplane: Delta-BitPlane transform with movemask-style transpose kernel
+ *
+ * Codewords (written MSB first)
+ *   base word: 000 (zero), 001+4bits, 010+8bits, 011+16bits, 1+32bits (sign-extended values)
+ *   DBX plane: 01+5bits (run of 2-33 zero DBX), 001 (single zero DBX), 00000 (all ones),
+ *              00001 (DBX!=0 but DBP=0), 00010+pos (two consecutive ones), 00011+pos (single one),
+ *              1+n bits (uncompressed plane)
+ *
+ * Note
+ *   This algorithm is reference to the paper of ISCA16 conference
+ *   url: https://ieeexplore.ieee.org/document/7551404
+ */
+
+static void bpc_put_code(ByteArr arr, ValueBuffer code, int *pivot, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        if ((code >> i) & 1)
+            arr[*pivot / BYTE_BITWIDTH] |= 1 << (*pivot % BYTE_BITWIDTH);
+        *pivot += 1;
+    }
+}
+
+static ValueBuffer bpc_get_code(ByteArr arr, int *pivot, int width) {
+    ValueBuffer code = 0;
+    for (int i = 0; i < width; i++) {
+        code = (code << 1) | ((arr[*pivot / BYTE_BITWIDTH] >> (*pivot % BYTE_BITWIDTH)) & 1);
+        *pivot += 1;
+    }
+    return code;
+}
+
+int bpc_delta_bitplane(CacheLine original, uint32_t *dbp) {
+    uint32_t words[BPC_MAX_DELTA_NUM + 1] = {0};  // zero padded so that the kernel always reads full vectors
+    int delta_num = original.size / WORDSIZ - 1;
+    uint32_t plane_mask;
+
+    if (original.size % WORDSIZ != 0 || delta_num < 1 || delta_num > BPC_MAX_DELTA_NUM)
+        return 0;
+
+    memcpy(words, original.body, original.size);
+    memset(dbp, 0, sizeof(uint32_t) * BPC_PLANE_NUM);
+
+    // Bit 32 of the delta is the sign of the 33bit subtraction, which is the 32bit sign bit
+    // inverted whenever the subtraction overflows: d ^ ((a ^ b) & (a ^ d))
+#if defined(__AVX2__)
+    for (int g = 0; g < delta_num; g += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(words + g + 1));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(words + g));
+        __m256i d = _mm256_sub_epi32(a, b);
+        __m256i s = _mm256_xor_si256(d, _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, d)));
+
+        dbp[32] |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(s)) << g;
+        for (int p = 31; p >= 0; p--) {
+            dbp[p] |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(d)) << g;
+            d = _mm256_add_epi32(d, d);  // move next bit-plane into sign bit
+        }
+    }
+#elif defined(__SSE2__)
+    for (int g = 0; g < delta_num; g += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(words + g + 1));
+        __m128i b = _mm_loadu_si128((const __m128i *)(words + g));
+        __m128i d = _mm_sub_epi32(a, b);
+        __m128i s = _mm_xor_si128(d, _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, d)));
+
+        dbp[32] |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(s)) << g;
+        for (int p = 31; p >= 0; p--) {
+            dbp[p] |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(d)) << g;
+            d = _mm_add_epi32(d, d);  // move next bit-plane into sign bit
+        }
+    }
+#else
+    for (int i = 0; i < delta_num; i++) {
+        ValueBuffer delta = (ValueBuffer)(WordBuffer)words[i + 1] - (ValueBuffer)(WordBuffer)words[i];
+        for (int p = 0; p < BPC_PLANE_NUM; p++)
+            dbp[p] |= (uint32_t)((delta >> p) & 1) << i;
+    }
+#endif
+
+    // mask out the padded lanes
+    plane_mask = delta_num == 32 ? 0xffffffff : (((uint32_t)1 << delta_num) - 1);
+    for (int p = 0; p < BPC_PLANE_NUM; p++)
+        dbp[p] &= plane_mask;
+
+    return delta_num;
+}
+
+CompressionResult bpc_compression(CacheLine original) {
+    CompressionResult result;
+    CacheLine compressed = make_memory_chunk(original.size * 2, 0);
+    MetaData tag_overhead = make_memory_chunk(1, 0);  // 1bit flag identifying whether the cacheline is compressed
+    uint32_t dbp[BPC_PLANE_NUM], dbx, plane_mask;
+    WordBuffer base;
+    int delta_num, pos_width, pivot = 0, zeros_run = 0;
+
+#ifdef VERBOSE
+    printf("Compressing with BPC algorithm...\n");
+#endif
+
+    result.compression_type = "BPC(Bit-Plane Compression)";
+    result.original = original;
+
+    delta_num = bpc_delta_bitplane(original, dbp);
+
+    if (delta_num == 0) {
+#ifdef VERBOSE
+        printf("failed due to unsupported cacheline size (%dBytes)\n", original.size);
+#endif
+        remove_memory_chunk(compressed);
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+        tag_overhead.valid_bitwidth = 1;
+        result.tag_overhead = tag_overhead;
+        return result;
+    }
+
+    plane_mask = delta_num == 32 ? 0xffffffff : (((uint32_t)1 << delta_num) - 1);
+    for (pos_width = 1; (1 << pos_width) < delta_num; pos_width++) {}
+
+    // 1. Encode base word
+    base = (WordBuffer)get_value(original.body, 0, WORDSIZ);
+    if (base == 0) {
+        bpc_put_code(compressed.body, 0b000, &pivot, 3);
+    } else if (base == SIGNEX(base & 0xf, 3)) {
+        bpc_put_code(compressed.body, 0b001, &pivot, 3);
+        bpc_put_code(compressed.body, base & 0xf, &pivot, 4);
+    } else if (base == (ByteBuffer)(base & 0xff)) {
+        bpc_put_code(compressed.body, 0b010, &pivot, 3);
+        bpc_put_code(compressed.body, base & 0xff, &pivot, 8);
+    } else if (base == (HwordBuffer)(base & 0xffff)) {
+        bpc_put_code(compressed.body, 0b011, &pivot, 3);
+        bpc_put_code(compressed.body, base & 0xffff, &pivot, 16);
+    } else {
+        bpc_put_code(compressed.body, 0b1, &pivot, 1);
+        bpc_put_code(compressed.body, (uint32_t)base, &pivot, 32);
+    }
+
+    // 2. Encode DBX planes from the MSB plane
+    for (int p = BPC_PLANE_NUM - 1; p >= 0; p--) {
+        dbx = (p == BPC_PLANE_NUM - 1) ? dbp[p] : (dbp[p] ^ dbp[p + 1]);
+
+#ifdef VERBOSE
+        printf("[PLANE %2d] dbp: 0x%08x  dbx: 0x%08x\n", p, dbp[p], dbx);
+#endif
+
+        if (dbx == 0) {
+            zeros_run += 1;
+            if (p > 0) continue;
+        }
+
+        if (zeros_run == 1) {
+            bpc_put_code(compressed.body, 0b001, &pivot, 3);
+        } else if (zeros_run > 1) {
+            bpc_put_code(compressed.body, 0b01, &pivot, 2);
+            bpc_put_code(compressed.body, zeros_run - 2, &pivot, 5);
+        }
+        zeros_run = 0;
+
+        if (dbx == 0) break;  // zeros run reached the last plane
+
+        if (dbx == plane_mask) {
+            bpc_put_code(compressed.body, 0b00000, &pivot, 5);
+        } else if (dbp[p] == 0) {
+            bpc_put_code(compressed.body, 0b00001, &pivot, 5);
+        } else if (__builtin_popcount(dbx) == 2 && (dbx & (dbx >> 1)) != 0) {
+            bpc_put_code(compressed.body, 0b00010, &pivot, 5);
+            bpc_put_code(compressed.body, __builtin_ctz(dbx), &pivot, pos_width);
+        } else if (__builtin_popcount(dbx) == 1) {
+            bpc_put_code(compressed.body, 0b00011, &pivot, 5);
+            bpc_put_code(compressed.body, __builtin_ctz(dbx), &pivot, pos_width);
+        } else {
+            bpc_put_code(compressed.body, 0b1, &pivot, 1);
+            bpc_put_code(compressed.body, dbx, &pivot, delta_num);
+        }
+
+        if (pivot >= original.size * BYTE_BITWIDTH) break;  // not compressible anymore
+    }
+
+    int compressed_size = ceil((double)pivot / BYTE_BITWIDTH);
+
+    if (compressed_size < original.size) {
+        compressed.size = compressed_size;
+        compressed.valid_bitwidth = pivot;
+        result.compressed = compressed;
+        result.is_compressed = TRUE;
+        set_value_bitwise(tag_overhead.body, 1, 0, 1);
+    } else {
+#ifdef VERBOSE
+        printf("compression failed (compressed size: %dBytes)\n", compressed_size);
+#endif
+        remove_memory_chunk(compressed);
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+    }
+
+    tag_overhead.valid_bitwidth = 1;
+    result.tag_overhead = tag_overhead;
+
+#ifdef VERBOSE
+    printf("compression completed\n");
+#endif
+
+    return result;
+}
+
+DecompressionResult bpc_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result;
+    CacheLine original = make_memory_chunk(original_size, 0);
+    uint32_t dbp[BPC_PLANE_NUM], dbx = 0, plane_mask, word;
+    ValueBuffer delta;
+    int delta_num = original_size / WORDSIZ - 1;
+    int pos_width, pivot = 0, zeros_run;
+
+#ifdef VERBOSE
+    printf("Decompressing with BPC algorithm...\n");
+#endif
+
+    result.compression_type = "BPC(Bit-Plane Compression)";
+    result.compressed = compressed;
+
+    if (get_value_bitwise(tag_overhead.body, 0, 1) == 0) {
+        memcpy(original.body, compressed.body, original_size);
+        result.original = original;
+        result.is_decompressed = TRUE;
+        return result;
+    }
+
+    plane_mask = delta_num == 32 ? 0xffffffff : (((uint32_t)1 << delta_num) - 1);
+    for (pos_width = 1; (1 << pos_width) < delta_num; pos_width++) {}
+
+    // 1. Decode base word
+    if (bpc_get_code(compressed.body, &pivot, 1)) {
+        word = bpc_get_code(compressed.body, &pivot, 32);
+    } else {
+        switch (bpc_get_code(compressed.body, &pivot, 2)) {
+        case 0:
+            word = 0;
+            break;
+        case 1:
+            word = bpc_get_code(compressed.body, &pivot, 4);
+            word = SIGNEX(word, 3);
+            break;
+        case 2:
+            word = (ByteBuffer)bpc_get_code(compressed.body, &pivot, 8);
+            break;
+        default:
+            word = (HwordBuffer)bpc_get_code(compressed.body, &pivot, 16);
+            break;
+        }
+    }
+    set_value(original.body, word, 0, WORDSIZ);
+
+    // 2. Decode DBX planes and restore DBP planes from the MSB plane
+    for (int p = BPC_PLANE_NUM - 1; p >= 0;) {
+        zeros_run = 0;
+
+        if (bpc_get_code(compressed.body, &pivot, 1)) {
+            dbx = bpc_get_code(compressed.body, &pivot, delta_num);
+        } else if (bpc_get_code(compressed.body, &pivot, 1)) {
+            zeros_run = bpc_get_code(compressed.body, &pivot, 5) + 2;
+        } else if (bpc_get_code(compressed.body, &pivot, 1)) {
+            zeros_run = 1;
+        } else {
+            switch (bpc_get_code(compressed.body, &pivot, 2)) {
+            case 0:
+                dbx = plane_mask;
+                break;
+            case 1:
+                dbp[p] = 0;  // DBX!=0 but DBP=0
+                p -= 1;
+                continue;
+            case 2:
+                dbx = (uint32_t)0b11 << bpc_get_code(compressed.body, &pivot, pos_width);
+                break;
+            default:
+                dbx = (uint32_t)0b1 << bpc_get_code(compressed.body, &pivot, pos_width);
+                break;
+            }
+        }
+
+        if (zeros_run > 0) {
+            for (; zeros_run > 0 && p >= 0; zeros_run--, p--)
+                dbp[p] = (p == BPC_PLANE_NUM - 1) ? 0 : dbp[p + 1];
+            continue;
+        }
+
+        dbp[p] = (p == BPC_PLANE_NUM - 1) ? dbx : (dbx ^ dbp[p + 1]);
+        p -= 1;
+    }
+
+    // 3. Transpose bit-planes back into deltas and accumulate words
+    for (int i = 0; i < delta_num; i++) {
+        delta = 0;
+        for (int p = 0; p < BPC_PLANE_NUM; p++)
+            delta |= (ValueBuffer)((dbp[p] >> i) & 1) << p;
+        word += (uint32_t)delta;  // 33bit delta wraps around within 32bit words
+        set_value(original.body, word, (i + 1) * WORDSIZ, WORDSIZ);
+    }
+
+#ifdef VERBOSE
+    printf("decompression completed\n");
+#endif
+
+    result.original = original;
+    result.is_decompressed = TRUE;
+
+    return result;
+}
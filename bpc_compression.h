@@ -0,0 +1,18 @@
+#ifndef BPC_COMPRESSION
+#define BPC_COMPRESSION
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for bit-plane transformation
+#define BPC_PLANE_NUM      33  // delta of two 32bit words needs 33bits
+#define BPC_MAX_DELTA_NUM  32  // each bit-plane is held in 32bit buffer (cacheline up to 132Bytes)
+
+// Functions for BPC(Bit-Plane Compression) algorithm
+CompressionResult bpc_compression(CacheLine original);                                                  // BPC compression algorithm
+DecompressionResult bpc_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);  // BPC decompression algorithm
+int bpc_delta_bitplane(CacheLine original, uint32_t *dbp);                                              // Delta-BitPlane transform (returns number of deltas)
+
+#endif
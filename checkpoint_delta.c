@@ -0,0 +1,157 @@
+#include "checkpoint_delta.h"
+
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+/*
+ * Functions for checkpoint delta
+ *   Fine-tuned models differ slightly from their pretrained base, so a variant stored as its delta
+ *   against the base is mostly zeros or small values, while each file compressed alone is not.
+ *   Each layer is compressed as its delta against the layer of a reference model at the same file
+ *   offset, either bitwise XOR (DELTA_XOR) or wrapping subtraction of little endian integer
+ *   elements (DELTA_SUBTRACT, e.g. 4Bytes for fp32 weights). Both deltas are lossless: the layer is
+ *   the reference XOR delta, or the reference plus delta.
+ *
+ *   The reference file is mapped and the delta of each block is computed in place when the block
+ *   is compressed, so layers are streamed without loading either file. Bytes after the end of the
+ *   reference are compared against zeros (delta is the layer itself). On Windows (no mmap), the
+ *   reference file is read into memory with fread instead.
+ *
+ * Functions:
+ *   open_delta_reference: maps reference file (body is NULL on failure)
+ *   close_delta_reference: unmaps reference file
+ *   checkpoint_delta: replaces block at file offset with its delta against the reference (in place)
+ *
+ * Note
+ *   Block offsets of DELTA_SUBTRACT must be aligned to the element size, and the host is assumed to
+ *   be little endian (as the layer files)
+ */
+
+#define DELTA_SUBTRACT_ELEMENTS(type, block, ref, i, end) \
+    for (; (i) + (long)sizeof(type) <= (end); (i) += sizeof(type)) { \
+        type value, base; \
+        memcpy(&value, (block) + (i), sizeof(type)); \
+        memcpy(&base, (ref) + (i), sizeof(type)); \
+        value -= base; \
+        memcpy((block) + (i), &value, sizeof(type)); \
+    }
+
+DeltaReference open_delta_reference(char const *filename, int mode, int element_size) {
+    DeltaReference reference;
+#ifdef _WIN32
+    FILE *fp;
+#else
+    struct stat st;
+    int fd;
+#endif
+
+    reference.body = NULL;
+    reference.size = 0;
+    reference.mode = mode;
+    reference.element_size = element_size;
+
+    if (mode != DELTA_XOR && mode != DELTA_SUBTRACT) {
+        fprintf(stderr, "[ERROR] Invalid delta mode %d\n", mode);
+        return reference;
+    }
+    if (mode == DELTA_SUBTRACT && element_size != 1 && element_size != 2 && element_size != 4 && element_size != 8) {
+        fprintf(stderr, "[ERROR] Invalid delta element size %d\n", element_size);
+        return reference;
+    }
+
+#ifdef _WIN32
+    fp = fopen(filename, "rb");
+    if (fp != NULL) {
+        fseek(fp, 0, SEEK_END);
+        reference.size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+    }
+    if (fp == NULL || reference.size <= 0) {
+        fprintf(stderr, "[ERROR] Opening reference file '%s' failed\n", filename);
+        if (fp != NULL) fclose(fp);
+        reference.size = 0;
+        return reference;
+    }
+
+    reference.body = (ByteArr)malloc(reference.size);
+    if (fread(reference.body, 1, reference.size, fp) != (size_t)reference.size) {
+        fprintf(stderr, "[ERROR] Reading reference file '%s' failed\n", filename);
+        free(reference.body);
+        reference.body = NULL;
+        reference.size = 0;
+    }
+    fclose(fp);
+#else
+    fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "[ERROR] Opening reference file '%s' failed\n", filename);
+        if (fd >= 0) close(fd);
+        return reference;
+    }
+
+    reference.body = (ByteArr)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (reference.body == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] Mapping reference file '%s' failed\n", filename);
+        reference.body = NULL;
+        return reference;
+    }
+    reference.size = st.st_size;
+#endif
+
+#ifdef VERBOSE
+    printf("reference '%s' mapped (size: %ldBytes)\n", filename, reference.size);
+#endif
+
+    return reference;
+}
+
+void close_delta_reference(DeltaReference reference) {
+    if (reference.body == NULL)
+        return;
+#ifdef _WIN32
+    free(reference.body);
+#else
+    munmap(reference.body, reference.size);
+#endif
+}
+
+void checkpoint_delta(DeltaReference reference, ByteArr block, long offset, long size) {
+    ByteArr ref = reference.body + offset;
+    long common = reference.size - offset;  // bytes of the block covered by the reference
+    long i = 0;
+    uint64_t value = 0, base = 0;
+
+    if (reference.body == NULL || common <= 0)
+        return;
+    if (common > size)
+        common = size;
+
+    if (reference.mode == DELTA_XOR) {
+        for (i = 0; i < common; i++)
+            block[i] ^= ref[i];
+        return;
+    }
+
+    switch (reference.element_size) {
+        case 1: DELTA_SUBTRACT_ELEMENTS(uint8_t, block, ref, i, common); break;
+        case 2: DELTA_SUBTRACT_ELEMENTS(uint16_t, block, ref, i, common); break;
+        case 4: DELTA_SUBTRACT_ELEMENTS(uint32_t, block, ref, i, common); break;
+        case 8: DELTA_SUBTRACT_ELEMENTS(uint64_t, block, ref, i, common); break;
+    }
+
+    // element cut by the end of the reference or the block (lower bytes of the difference only depend on lower bytes)
+    if (i < common) {
+        long valid = size - i < reference.element_size ? size - i : reference.element_size;
+        memcpy(&value, block + i, valid);
+        memcpy(&base, ref + i, common - i);
+        value -= base;
+        memcpy(block + i, &value, valid);
+    }
+}
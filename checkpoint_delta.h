@@ -0,0 +1,26 @@
+#ifndef CHECKPOINT_DELTA
+#define CHECKPOINT_DELTA
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for checkpoint delta
+#define DELTA_XOR              0  // bitwise XOR against the reference
+#define DELTA_SUBTRACT         1  // wrapping subtraction of little endian integer elements
+#define DELTA_DEFAULT_ELEMENT  4  // element size of subtraction (fp32/int32 weights)
+
+typedef struct {
+    ByteArr  body;          // mapped (read on Windows) reference file (NULL if not opened)
+    long     size;          // size of the reference file
+    int      mode;          // DELTA_XOR or DELTA_SUBTRACT
+    int      element_size;  // element size of subtraction (1, 2, 4 or 8Bytes)
+} DeltaReference;
+
+// Functions for checkpoint delta (layer compressed as its delta against a reference model)
+DeltaReference open_delta_reference(char const *filename, int mode, int element_size);  // maps reference file (body is NULL on failure)
+void close_delta_reference(DeltaReference reference);                                    // unmaps reference file
+void checkpoint_delta(DeltaReference reference, ByteArr block, long offset, long size);  // replaces block at file offset with its delta (in place)
+
+#endif
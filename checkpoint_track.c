@@ -0,0 +1,118 @@
+#include "checkpoint_track.h"
+
+
+/*
+ * Functions for checkpoint tracking
+ *   Compressibility of a layer is tracked over a sequence of checkpoints (e.g. epochs of training)
+ *   without compressing every checkpoint in full. The track keeps the hash of each line at the
+ *   last checkpoint, together with the compressed size and encoding of each line for every
+ *   algorithm. At the next checkpoint, lines are hashed again and only lines whose hash changed
+ *   have to be compressed: record_line_result replaces the size and encoding of a line and keeps
+ *   the total size and encoding mix of the layer up to date, so both are available without
+ *   visiting unchanged lines.
+ *
+ *   If the number of lines of the layer changes (e.g. the layer is reshaped), the track is reset
+ *   and every line is reported as changed.
+ *
+ * Functions:
+ *   make_layer_track: allocates empty track
+ *   remove_layer_track: removes track
+ *   update_layer_track: hashes lines and finds lines changed since the last checkpoint
+ *   record_line_result: replaces compressed size and encoding of a line
+ *   layer_track_ratio: compression ratio of the layer at the last checkpoint
+ *
+ * Note
+ *   Lines are compared by 64bit hash (line_hash64), so a changed line is missed only on a hash
+ *   collision. Lines of the last checkpoint are not kept.
+ */
+
+LayerTrack make_layer_track(int line_size, int algo_num) {
+    LayerTrack track;
+
+    track.line_num = 0;
+    track.line_size = line_size;
+    track.algo_num = algo_num;
+    track.hashes = NULL;
+    track.sizes = NULL;
+    track.encodings = NULL;
+    track.changed = NULL;
+    track.changed_num = 0;
+    track.checkpoint_num = 0;
+    track.total_sizes = (long *)calloc(algo_num, sizeof(long));
+    track.encoding_counts = (long *)calloc((long)algo_num * TRACK_ENCODING_NUM, sizeof(long));
+
+    return track;
+}
+
+void remove_layer_track(LayerTrack track) {
+    free(track.hashes);
+    free(track.sizes);
+    free(track.encodings);
+    free(track.changed);
+    free(track.total_sizes);
+    free(track.encoding_counts);
+}
+
+static void reset_layer_track(LayerTrack *track, long line_num) {
+    long cells = (long)track->algo_num * (line_num > 0 ? line_num : 1);
+
+    free(track->hashes);
+    free(track->sizes);
+    free(track->encodings);
+    free(track->changed);
+
+    track->line_num = line_num;
+    track->hashes = (uint64_t *)malloc(sizeof(uint64_t) * (line_num > 0 ? line_num : 1));
+    track->sizes = (int *)calloc(cells, sizeof(int));
+    track->encodings = (int *)malloc(sizeof(int) * cells);
+    track->changed = (long *)malloc(sizeof(long) * (line_num > 0 ? line_num : 1));
+    for (long i = 0; i < cells; i++)
+        track->encodings[i] = TRACK_NO_ENCODING;
+
+    memset(track->total_sizes, 0, sizeof(long) * track->algo_num);
+    memset(track->encoding_counts, 0, sizeof(long) * track->algo_num * TRACK_ENCODING_NUM);
+}
+
+long update_layer_track(LayerTrack *track, ByteArr image, long line_num) {
+    Bool reset = track->checkpoint_num == 0 || track->line_num != line_num;
+    uint64_t hash;
+
+    if (reset) {
+#ifdef VERBOSE
+        if (track->checkpoint_num > 0)
+            printf("layer resized (%ld -> %ld lines), track is reset\n", track->line_num, line_num);
+#endif
+        reset_layer_track(track, line_num);
+    }
+
+    track->changed_num = 0;
+    for (long l = 0; l < line_num; l++) {
+        hash = line_hash64(image + l * track->line_size, track->line_size);
+        if (reset || hash != track->hashes[l])
+            track->changed[track->changed_num++] = l;
+        track->hashes[l] = hash;
+    }
+    track->checkpoint_num += 1;
+
+    return track->changed_num;
+}
+
+void record_line_result(LayerTrack *track, int algo, long line, int size, int encoding) {
+    long cell = (long)algo * track->line_num + line;
+    long *counts = track->encoding_counts + (long)algo * TRACK_ENCODING_NUM;
+
+    track->total_sizes[algo] += size - track->sizes[cell];
+    if (track->encodings[cell] >= 0 && track->encodings[cell] < TRACK_ENCODING_NUM)
+        counts[track->encodings[cell]] -= 1;
+    if (encoding >= 0 && encoding < TRACK_ENCODING_NUM)
+        counts[encoding] += 1;
+
+    track->sizes[cell] = size;
+    track->encodings[cell] = encoding;
+}
+
+double layer_track_ratio(LayerTrack const *track, int algo) {
+    if (track->total_sizes[algo] <= 0)
+        return 0;
+    return (double)track->line_num * track->line_size / track->total_sizes[algo];
+}
@@ -0,0 +1,35 @@
+#ifndef CHECKPOINT_TRACK
+#define CHECKPOINT_TRACK
+
+#include "compression.h"
+#include "line_dedup.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for checkpoint tracking
+#define TRACK_ENCODING_NUM  16  // encodings counted in encoding mix (0 ~ 15, other encodings are not counted)
+#define TRACK_NO_ENCODING   -1  // encoding of lines without encoding (not counted in encoding mix)
+
+typedef struct {
+    long       line_num;         // number of lines of the layer at the last checkpoint
+    int        line_size;        // size of lines
+    int        algo_num;         // number of tracked algorithms
+    uint64_t  *hashes;           // hash of each line at the last checkpoint
+    int       *sizes;            // compressed size of each line of each algorithm (algo_num x line_num)
+    int       *encodings;        // encoding of each line of each algorithm (algo_num x line_num)
+    long      *total_sizes;      // total compressed size of the layer of each algorithm
+    long      *encoding_counts;  // number of lines of each encoding of each algorithm (algo_num x TRACK_ENCODING_NUM)
+    long      *changed;          // indices of lines changed at the last update (ascending)
+    long       changed_num;      // number of lines changed at the last update
+    int        checkpoint_num;   // number of checkpoints tracked
+} LayerTrack;
+
+// Functions for checkpoint tracking
+LayerTrack make_layer_track(int line_size, int algo_num);                                        // allocates empty track (every line is changed at the first update)
+void remove_layer_track(LayerTrack track);                                                       // removes track
+long update_layer_track(LayerTrack *track, ByteArr image, long line_num);                        // finds lines changed since the last checkpoint (returns number of changed lines)
+void record_line_result(LayerTrack *track, int algo, long line, int size, int encoding);         // replaces compressed size and encoding of a line
+double layer_track_ratio(LayerTrack const *track, int algo);                                     // compression ratio of the layer at the last checkpoint
+
+#endif
@@ -1,5 +1,9 @@
 #include "compression.h"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 /* 
  * Functions for managing ByteArr and ValueBuffer 
  *   ByteArr is literally a structure for byte array representing memory block.
@@ -20,9 +24,17 @@ void set_value(ByteArr arr, ValueBuffer val, int offset, int size) {
 }
 
 void set_value_bitwise(ByteArr arr, ValueBuffer val, int offset, int size) {
-    ValueBuffer mask = 1;
-    for (int i = 0; i < size; i++) {
-        arr[(i + offset) / BYTE_BITWIDTH] |= ((val & (mask << i)) >> i) << ((i + offset) % BYTE_BITWIDTH);
+    uint64_t bits = size < 64 ? (uint64_t)val & ((1ULL << size) - 1) : (uint64_t)val;
+    int index = offset / BYTE_BITWIDTH, shift = offset % BYTE_BITWIDTH;
+
+    if (size <= 0) return;
+
+    // bytes are ORed at once (only the bytes covering [offset, offset+size) are touched)
+    arr[index] |= (Byte)(bits << shift);
+    bits >>= BYTE_BITWIDTH - shift;
+    for (int rest = size - (BYTE_BITWIDTH - shift); rest > 0; rest -= BYTE_BITWIDTH) {
+        arr[++index] |= (Byte)bits;
+        bits >>= BYTE_BITWIDTH;
     }
 }
 
@@ -217,6 +229,7 @@ MemoryChunk file2memorychunk(char const *filename, int offset, int size) {
  *   bdi_compression: BDI compression algorithm
  *   bdi_decompression : BDI decompression algorithm
  *   bdi_compressing_unit: actually compresses given cacheline with certain encoding
+ *   bdi_delta_check: checks that every k-byte element fits in d-byte delta against given base
  * 
  * Note
  *   This algorithm is reference to the paper of PACT12 conference
@@ -248,6 +261,7 @@ CompressionResult bdi_compression(CacheLine original) {
             result.tag_overhead = tag_overhead;
             return result;
         }
+        remove_memory_chunk(compressed);
     }
 
     result.compressed = copy_memory_chunk(original);
@@ -356,10 +370,8 @@ DecompressionResult bdi_decompression(CacheLine compressed, MetaData tag_overhea
 
 CacheLine bdi_compressing_unit(CacheLine original, int encoding) {
     ValueBuffer base = 0;
-    ValueBuffer buffer, delta, mask;
     int k, d;
     int compressed_siz = 0;
-    Bool initial, flag = TRUE;
     CacheLine result;
 
     // 0. Select mode by given encoding (MUX)
@@ -457,8 +469,31 @@ CacheLine bdi_compressing_unit(CacheLine original, int encoding) {
     compressed_siz = k;
 
     // 2. Calculate delta values and check if this cache line is compressible
+    if (bdi_delta_check(original, base, k, d, result.body + compressed_siz) == FALSE) {
+        remove_memory_chunk(result);
+        result = copy_memory_chunk(original);
+        return result;
+    }
+    compressed_siz += ((original.size + k - 1) / k) * d;
+
+#ifdef VERBOSE
+    printf("compression completed\n");
+#endif
+
+    result.size = compressed_siz;
+    return result;
+}
+
+Bool bdi_delta_check(CacheLine original, ValueBuffer base, int k, int d, ByteArr deltas) {
+    ValueBuffer buffer, delta;
+    ValueBuffer byte_mask = 0x00;
+
+    if (d >= 1) byte_mask += 0xff;
+    if (d >= 2) byte_mask += 0xff00;
+    if (d >= 4) byte_mask += 0xffff0000;
+
     for (int i = 0; i < original.size; i += k) {
-        // 2-1. Split byte array into k-byte array and extract each value
+        // 1. Split byte array into k-byte array and extract each value
         buffer = get_value(original.body, i, k);
         delta = buffer - base;
 
@@ -466,36 +501,20 @@ CacheLine bdi_compressing_unit(CacheLine original, int encoding) {
         printf("[ITER %2d] base: 0x%016llx  buffer: 0x%016llx  delta: 0x%016llx\n", i/k, base, buffer, delta);
 #endif
 
-        // 2-2. Check whether calculated delta value is sign-extended within d-Bytes
-        ValueBuffer byte_mask = 0x00;
-        if (d >= 1) byte_mask += 0xff;
-        if (d >= 2) byte_mask += 0xff00;
-        if (d >= 4) byte_mask += 0xffff0000;
+        // 2. Check whether calculated delta value is sign-extended within d-Bytes
         if (delta != SIGNEX(delta & byte_mask, (d * BYTE_BITWIDTH) - 1)) {
-            flag = FALSE;
-        }
-
-        // 2-3 Copy shrinked delta value to compressed memory block
-        if (flag == FALSE) {
 #ifdef VERBOSE
             printf("iteration terminated (not compressible)\n");
 #endif
-            remove_memory_chunk(result);
-            result = copy_memory_chunk(original);
-            return result;
-        } else {
-            mask = 1;
-            set_value(result.body, delta, compressed_siz, d);
-            compressed_siz += d;
+            return FALSE;
         }
-    }
 
-#ifdef VERBOSE
-    printf("compression completed\n");
-#endif
+        // 3. Copy shrinked delta value to compressed memory block
+        if (deltas != NULL)
+            set_value(deltas, delta, (i / k) * d, d);
+    }
 
-    result.size = compressed_siz;
-    return result;
+    return TRUE;
 }
 
 
@@ -512,7 +531,9 @@ CacheLine bdi_compressing_unit(CacheLine original, int encoding) {
 CompressionResult fpc_compression(CacheLine original) {
     CompressionResult result;
     CacheLine compressed = make_memory_chunk(original.size * 2, 0);
-    MetaData tag_overhead = make_memory_chunk(4, 0);
+    MetaData tag_overhead = make_memory_chunk(ceil((double)original.size * 3 / BYTE_BITWIDTH), 0);  // 3bits prefix per byte at most
+    Byte mask_buffer[ZERO_RUN_MASK_SIZ];
+    ByteArr nonzero_mask = original.size / BYTE_BITWIDTH < ZERO_RUN_MASK_SIZ ? mask_buffer : (ByteArr)malloc(original.size / BYTE_BITWIDTH + 1);
     WordBuffer buffer, mask = 1;
     HwordBuffer lsb, msb;
     Bool compressed_flag, repeating_flag;
@@ -529,14 +550,15 @@ CompressionResult fpc_compression(CacheLine original) {
 
     result.compression_type = "FPC(Frequent Pattern Compression";
     result.original = original;
-    
+    zero_vec_mask(original, nonzero_mask);  // zero runs are found with the bitmap of nonzero bytes
 
     for (int i = 0; i < original.size;) {
 #ifdef VERBOSE
         printf("[ITER] cursor position: %d  pivot: %d\n", i, pivot);
         printf("prefix 0 (zero run): ");
 #endif
-        for (zeros_len = 0; (get_value(original.body, i + zeros_len, 1) & 0xff) == 0x00 && zeros_len < 8; zeros_len++) {}
+        zeros_len = zero_run_length(nonzero_mask, original.size, i);
+        if (zeros_len > 8) zeros_len = 8;
         if (zeros_len > 0) {
 #ifdef VERBOSE
             printf("succeed (len: %d)\n", zeros_len);
@@ -550,7 +572,7 @@ CompressionResult fpc_compression(CacheLine original) {
         }
 
         compressed_flag = FALSE;
-        buffer = get_value(original.body, i, 4);
+        buffer = get_value(original.body, i, (original.size - i) < 4 ? (original.size - i) : 4);  // last word can be truncated after zeros run
         i += 4;
 
         for (int prefix = 1; prefix < 8 && compressed_flag == FALSE; prefix++) {
@@ -700,6 +722,8 @@ CompressionResult fpc_compression(CacheLine original) {
     }
 
     int compressed_size = ceil((double)pivot / BYTE_BITWIDTH);
+    if (nonzero_mask != mask_buffer)
+        free(nonzero_mask);
 
     if (compressed_size < original.size) {
         compressed.size = compressed_size;
@@ -712,6 +736,7 @@ CompressionResult fpc_compression(CacheLine original) {
 #ifdef VERBOSE
         printf("compression failed (compressed size: %dBytes)\n", compressed_size);
 #endif
+        remove_memory_chunk(compressed);
         result.compressed = copy_memory_chunk(original);
         result.is_compressed = FALSE;
         tag_overhead.valid_bitwidth = 0;
@@ -882,215 +907,209 @@ DecompressionResult fpc_decompression(CacheLine compressed, MetaData tag_overhea
  *   bdi_twobase_compression: BDI compression algorithm with two bases
  *   bdi_twobase_decompression : BDI decompression algorithm with two bases
  *   bdi_twobase_compressing_unit: actually compresses given cacheline with certain encoding
+ *   bdi_twobase_scan: smallest delta size of given base size (single pass over the line)
  * 
  * Note
  *   This algorithm is reference to the paper of PACT12 conference
  *   url: https://users.ece.cmu.edu/~omutlu/pub/bdi-compression_pact12.pdf
+ *
+ *   Each element is encoded against the first element (explicit base) or against zero (implicit
+ *   base), whichever fits. Instead of trying every encoding, one pass per base size (8, 4, 2Bytes)
+ *   finds the smallest delta size every element fits in for both bases at once, and the smallest
+ *   feasible encoding is selected. Deltas of 4Bytes and 2Bytes elements wrap around the element.
  */
 
-CompressionResult bdi_twobase_compression(CacheLine original) {
-    CompressionResult result;
-    MetaData tag_overhead = make_memory_chunk(2, 0);  // 2Bytes of tag overhead with its valid bitwidth of 11bits
-    CacheLine compressed = make_memory_chunk(original.size, 0);  // initialize compressed cacheline with the size of original cacheline
-    Bool is_compressed;
-
-#ifdef VERBOSE
-    printf("Compressing with BDI algorithm with two bases...\n");
-#endif
-
-    result.compression_type = "BDI(Base Delta Immediate) with two bases";
-    result.original = original;
+static ValueBuffer bdi_twobase_element(ByteArr body, int k) {
+    int64_t dword;
+    int32_t word;
+    int16_t hword;
 
-    for (int encoding = 0; encoding < 16; encoding++) {
-        is_compressed = bdi_twobase_compressing_unit(original, &compressed, &tag_overhead, encoding);
-        if (is_compressed == TRUE) {
-            result.is_compressed = TRUE;
-            break;
-        }
+    switch (k) {
+    case 8:  memcpy(&dword, body, 8); return dword;
+    case 4:  memcpy(&word, body, 4);  return word;
+    default: memcpy(&hword, body, 2); return hword;
     }
+}
 
-    result.compressed = compressed;
-    result.tag_overhead = tag_overhead;
+static ValueBuffer bdi_twobase_delta(ValueBuffer buffer, ValueBuffer base, int k) {
+    uint64_t delta = (uint64_t)buffer - (uint64_t)base;
 
-    if (result.is_compressed == FALSE) {
-        remove_memory_chunk(compressed);
-        result.compressed = copy_memory_chunk(original);
-        result.tag_overhead.valid_bitwidth = 0;
+    switch (k) {
+    case 8:  return (ValueBuffer)delta;
+    case 4:  return (WordBuffer)(uint32_t)delta;
+    default: return (HwordBuffer)(uint16_t)delta;
     }
+}
 
-    return result;
+static int bdi_twobase_width(ValueBuffer value) {
+    if (value == (ByteBuffer)value)  return 1;
+    if (value == (HwordBuffer)value) return 2;
+    if (value == (WordBuffer)value)  return 4;
+    return 8;
 }
 
+static int bdi_twobase_encoding(int k, int d) {
+    if (d == 1) return k == 8 ? 2 : k == 4 ? 3 : 4;
+    if (d == 2) return k == 8 ? 5 : 6;
+    return 7;
+}
 
-Bool bdi_twobase_compressing_unit(CacheLine original, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding) {
-    ValueBuffer buffer, base, delta, mask;
-    int k, d, segment_num, compressed_size;
-    Bool is_compressed = FALSE;
+int bdi_twobase_scan(CacheLine original, int k, Bool *all_zero, Bool *all_same) {
+    ValueBuffer base, buffer, bits = 0, differ = 0;
+    int width, zero_width, d = 1;
 
-    switch (encoding) {
-    case 0:  // Zeros (encoding 0)
-#ifdef VERBOSE
-        printf("encoding %d: ", encoding);
-#endif
-        is_compressed = TRUE;
-        for (int i = 0; i < original.size; i++) {
-            buffer = get_value(original.body, i, 1);
-            if (buffer != 0) {
-                is_compressed = FALSE;
-                break;
-            }
-        }
+    base = bdi_twobase_element(original.body, k);
 
-        if (is_compressed) {
-#ifdef VERBOSE
-            printf("succeed\n");
-#endif
-            compressed->size = 1;
-            compressed->valid_bitwidth = 8;
-            set_value_bitwise(tag_overhead->body, 0, encoding, 4);
-            set_value_bitwise(tag_overhead->body, 1, 4, 7);
-            tag_overhead->valid_bitwidth = 11;
-            return TRUE;
-        }
-#ifdef VERBOSE
-        else 
-            printf("failed\n");
-#endif
+    for (int i = 0; i < original.size; i += k) {
+        buffer = bdi_twobase_element(original.body + i, k);
+        width = bdi_twobase_width(bdi_twobase_delta(buffer, base, k));
+        zero_width = bdi_twobase_width(buffer);  // implicit zero base
+        if (zero_width < width)
+            width = zero_width;
+        if (width > d)
+            d = width;
+        bits |= buffer;
+        differ |= buffer ^ base;
+    }
 
-        return FALSE;
-    
-    case 1:  // Repeating values (encoding 1)
-#ifdef VERBOSE
-        printf("encoding %d: ", encoding);
-#endif
-        is_compressed = TRUE;
-        base = get_value(original.body, 0, 8);
-        for (int i = 0; i < original.size; i += 8) {
-            buffer = get_value(original.body, i, 8);
-            if (buffer != base) {
-                is_compressed = FALSE;
-                break;
+    if (all_zero != NULL) *all_zero = bits == 0;
+    if (all_same != NULL) *all_same = differ == 0;
+
+    return d;
+}
+
+static void bdi_twobase_write(CacheLine original, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding, int k, int d) {
+    ValueBuffer base, buffer, delta;
+    int compressed_size = encoding == 0 ? 1 : encoding == 1 ? 8 : k + (original.size / k) * d;
+
+    memset(compressed->body, 0, compressed_size);
+    memset(tag_overhead->body, 0, tag_overhead->size);
+
+    if (encoding == 1) {
+        set_value(compressed->body, get_value(original.body, 0, 8), 0, 8);
+    } else if (encoding > 1) {
+        base = bdi_twobase_element(original.body, k);
+        set_value(compressed->body, base, 0, k);
+
+        for (int i = 0, j = 0; i < original.size; i += k, j++) {
+            buffer = bdi_twobase_element(original.body + i, k);
+            delta = bdi_twobase_delta(buffer, base, k);
+            if (bdi_twobase_width(delta) <= d) {
+                set_value(compressed->body, delta, k + (j * d), d);
+            } else {
+                set_value(compressed->body, buffer, k + (j * d), d);
+                set_value_bitwise(tag_overhead->body, 1, 11 + j, 1);  // implicit zero base
             }
         }
+    }
+
+    compressed->size = compressed_size;
+    compressed->valid_bitwidth = compressed_size * BYTE_BITWIDTH;
+    set_value_bitwise(tag_overhead->body, encoding, 0, 4);
+    set_value_bitwise(tag_overhead->body, ceil((double)compressed_size / BYTE_BITWIDTH), 4, 7);
+    tag_overhead->valid_bitwidth = encoding > 1 ? 11 + (original.size / k) : 11;
 
-        if (is_compressed) {
-            compressed->size = 8;
-            compressed->valid_bitwidth = 64;
-            set_value(compressed->body, base, 0, 8);
-            set_value_bitwise(tag_overhead->body, 0, encoding, 4);
-            set_value_bitwise(tag_overhead->body, 1, 4, 7);
-            tag_overhead->valid_bitwidth = 11;
 #ifdef VERBOSE
-            printf("succeed\n");
+    printf("encoding %d succeed (size: %dBytes)\n", encoding, compressed->size);
 #endif
-        }
+}
+
+CompressionResult bdi_twobase_compression(CacheLine original) {
+    CompressionResult result;
+    MetaData tag_overhead = make_memory_chunk(ceil((double)(11 + original.size / 2) / BYTE_BITWIDTH), 0);  // 11bits of tag overhead followed by base selection bits
+    CacheLine compressed = make_memory_chunk(original.size, 0);  // initialize compressed cacheline with the size of original cacheline
+    const int base_sizes[3] = {8, 4, 2};
+    int best_encoding = -1, best_size = original.size, best_k = 0, best_d = 0, size, d;
+    Bool all_zero = FALSE, all_same = FALSE;
+
 #ifdef VERBOSE
-        else
-            printf("failed\n");
+    printf("Compressing with BDI algorithm with two bases...\n");
 #endif
 
-        return FALSE;
+    result.compression_type = "BDI(Base Delta Immediate) with two bases";
+    result.original = original;
 
-    case 2:  // Base8-delta1 (encoding 2)
-        k = 8;
-        d = 1;
+    for (int b = 0; b < 3; b++) {
+        int k = base_sizes[b];
+        if (original.size % k != 0)
+            continue;
 
-        break;
+        d = bdi_twobase_scan(original, k, k == 8 ? &all_zero : NULL, k == 8 ? &all_same : NULL);
+        if (k == 8 && all_zero) {
+            best_encoding = 0;
+            best_size = 1;
+            break;
+        }
+        if (k == 8 && all_same && 8 < best_size) {
+            best_encoding = 1;
+            best_size = 8;
+        }
 
-    case 3:  // Base8-delta2 (encoding 3)
-        k = 4;
-        d = 1;
+        // smallest feasible delta size of this base size (ties keep the smaller encoding number)
+        size = k + (original.size / k) * d;
+        if (d <= 4 && (size < best_size || (size == best_size && bdi_twobase_encoding(k, d) < best_encoding))) {
+            best_encoding = bdi_twobase_encoding(k, d);
+            best_size = size;
+            best_k = k;
+            best_d = d;
+        }
+    }
 
-        break;
+#ifdef VERBOSE
+    printf("selected encoding: %d (size: %dBytes)\n", best_encoding, best_size);
+#endif
 
-    case 4:  // Base8-delta4 (encoding 4)
-        k = 2;
-        d = 1;
+    result.tag_overhead = tag_overhead;
 
-        break;
+    if (best_encoding < 0) {
+        remove_memory_chunk(compressed);
+        result.compressed = copy_memory_chunk(original);
+        result.tag_overhead.valid_bitwidth = 0;
+        result.is_compressed = FALSE;
+        return result;
+    }
 
-    case 5:  // Base4-delta1 (encoding 5)
-        k = 8;
-        d = 2;
+    bdi_twobase_write(original, &compressed, &result.tag_overhead, best_encoding, best_k, best_d);
+    result.compressed = compressed;
+    result.is_compressed = TRUE;
 
-        break;
-    
-    case 6:  // Base4-delta2 (encoding 6)
-        k = 4;
-        d = 2;
+    return result;
+}
 
-        break;
 
-    case 7:  // Base2-delta1 (encoding 7)
-        k = 8;
-        d = 4;
+Bool bdi_twobase_compressing_unit(CacheLine original, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding) {
+    Bool all_zero, all_same;
+    int k, d;
 
-        break;
-    
-    default:
-        k = 8;
-        d = 1;
+    switch (encoding) {
+    case 0:  // Zeros (encoding 0)
+    case 1:  // Repeating values (encoding 1)
+        if (original.size % 8 != 0 || original.size <= (encoding == 0 ? 1 : 8))
+            return FALSE;
+        bdi_twobase_scan(original, 8, &all_zero, &all_same);
+        if (encoding == 0 ? !all_zero : !all_same)
+            return FALSE;
+        bdi_twobase_write(original, compressed, tag_overhead, encoding, 8, 0);
+        return TRUE;
 
-        break;
+    case 2:  k = 8; d = 1; break;  // Base8-delta1 (encoding 2)
+    case 3:  k = 4; d = 1; break;  // Base4-delta1 (encoding 3)
+    case 4:  k = 2; d = 1; break;  // Base2-delta1 (encoding 4)
+    case 5:  k = 8; d = 2; break;  // Base8-delta2 (encoding 5)
+    case 6:  k = 4; d = 2; break;  // Base4-delta2 (encoding 6)
+    case 7:  k = 8; d = 4; break;  // Base8-delta4 (encoding 7)
+    default: return FALSE;
     }
 
 #ifdef VERBOSE
     printf("encoding %d (Base%d-Delta%d)\n", encoding, k, d);
 #endif
 
-    compressed_size = k;
-    is_compressed = TRUE;
-    mask = 0;
-
-    if (d >= 1) mask += 0xff;
-    if (d >= 2) mask += 0xff00;
-    if (d >= 4) mask += 0xffff0000;
-
-    base = get_value(original.body, 0, k);
-    set_value(compressed->body, base, 0, k);
-
-    for (int i = 0, j = 0; i < original.size; i += k) {
-        buffer = get_value(original.body, i, k);
-        delta = buffer - base;
-        if (k < 8) delta = SIGNEX(delta, (k * BYTE_BITWIDTH - 1));
-#ifdef VERBOSE
-        printf("[ITER %2d] base: 0x%016llx  buffer: 0x%016llx  delta: 0x%016llx\n", i/k, base, buffer, delta);
-#endif
-        if (SIGNEX(delta & mask, (d * BYTE_BITWIDTH) - 1) == delta) {
-#ifdef VERBOSE
-            printf(">>> delta is %dByte sign extended\n", d);
-#endif
-            set_value(compressed->body, delta, k + (j * d), d);
-        } else if (SIGNEX(buffer & mask, d * (BYTE_BITWIDTH) - 1) == buffer) {
-#ifdef VERBOSE
-            printf(">>> delta is not %dByte sign extended but buffer is %dByte sign extended\n", d, d);
-#endif
-            set_value(compressed->body, buffer, k + (j * d), d);
-            set_value_bitwise(tag_overhead->body, 1, 11 + j, 1);
-        } else {
-            is_compressed = FALSE;
-            break;
-        }
-
-        compressed_size += d;
-        j += 1;
-    }
-
-    if (is_compressed == TRUE) {
-        compressed->size = compressed_size;
-        compressed->valid_bitwidth = compressed_size * 8;
-        tag_overhead->valid_bitwidth = 11 + (original.size / k);
-#ifdef VERBOSE
-        printf("encoding %d succeed (size: %dBytes)\n", encoding, compressed->size);
-#endif
-    }
-#ifdef VERBOSE
-    else {
-        printf("encoding %d failed\n", encoding);
-    }
-#endif
+    if (original.size % k != 0 || k + (original.size / k) * d >= original.size || bdi_twobase_scan(original, k, NULL, NULL) > d)
+        return FALSE;
 
-    return is_compressed;
+    bdi_twobase_write(original, compressed, tag_overhead, encoding, k, d);
+    return TRUE;
 }
 
 DecompressionResult bdi_twobase_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
@@ -1100,7 +1119,7 @@ DecompressionResult bdi_twobase_decompression(CacheLine compressed, MetaData tag
     int k, d;
     int encoding = get_value_bitwise(tag_overhead.body, 0, 4);
     int segment_num = get_value_bitwise(tag_overhead.body, 4, 7);
-    int selection, sel_mask = 1;
+    int selection;
 
 #ifdef VERBOSE
     printf("Decompressing with BDI algorithm...\n");
@@ -1179,11 +1198,11 @@ DecompressionResult bdi_twobase_decompression(CacheLine compressed, MetaData tag
     }
 
     base = get_value(compressed.body, 0, k);
-    selection = get_value_bitwise(tag_overhead.body, 11, original_size / k);
 
     for (int i = 0; i < original.size / k; i++) {
         buffer = get_value(compressed.body, k + (d*i), d);
-        if (selection & (sel_mask << i))
+        selection = get_value_bitwise(tag_overhead.body, 11 + i, 1);  // lines can have more than 32 elements
+        if (selection)
             set_value(original.body, SIGNEX(buffer, (d * BYTE_BITWIDTH)-1), i * k, k);
         else
             set_value(original.body, SIGNEX(buffer, (d * BYTE_BITWIDTH)-1) + base, i * k, k);
@@ -1204,17 +1223,44 @@ DecompressionResult bdi_twobase_decompression(CacheLine compressed, MetaData tag
  *   bdi_zr_compression: BDI compression algorithm with zeros run detection
  *   bdi_zr_decompression : BDI decompression algorithm with zeros run detection
  *   bdi_zr_compressing_unit: actually compresses given cacheline with certain encoding
+ *   bdi_zr_detector: shifting information (trailing zero bytes of each element) of given encoding
  * 
  * Note
  *   This algorithm is reference to the paper of PACT12 conference
  *   url: https://users.ece.cmu.edu/~omutlu/pub/bdi-compression_pact12.pdf
+ *
+ *   Trailing zero bytes of each element are counted with bit scan over the bitmap of nonzero
+ *   bytes (zero_vec_mask), which is built once per line. Compressing unit writes shifting
+ *   information while checking deltas, so the line is read once per encoding.
  */
 
+static int bdi_zr_trailing_zeros(ByteArr nonzero_mask, int index, int k) {
+    Byte bits = (nonzero_mask[index / BYTE_BITWIDTH] >> (index % BYTE_BITWIDTH)) & ((1 << k) - 1);  // element never crosses a bitmap byte
+    return bits ? __builtin_ctz(bits) : k;
+}
+
+static int bdi_zr_element_size(int encoding) {
+    switch (encoding) {
+    case 2:
+    case 5:
+    case 7:
+        return 8;
+    case 3:
+    case 6:
+        return 4;
+    case 4:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
 CompressionResult bdi_zr_compression(CacheLine original) {
     CompressionResult result;
-    MetaData shifting;  // Maximum size of shifting bits are 16Bytes
     MetaData tag_overhead = make_memory_chunk(2, 0);  // 2Bytes of tag overhead with its valid bitwidth of 11bits
     CacheLine compressed = make_memory_chunk(original.size, 0);  // initialize compressed cacheline with the size of original cacheline
+    Byte mask_buffer[ZERO_RUN_MASK_SIZ];
+    ByteArr nonzero_mask = original.size / BYTE_BITWIDTH < ZERO_RUN_MASK_SIZ ? mask_buffer : (ByteArr)malloc(original.size / BYTE_BITWIDTH + 1);
     Bool is_compressed;
 
 #ifdef VERBOSE
@@ -1224,20 +1270,22 @@ CompressionResult bdi_zr_compression(CacheLine original) {
     result.compression_type = "BDI(Base Delta Immediate) with zeros run";
     result.original = original;
 
+    zero_vec_mask(original, nonzero_mask);
+
     for (int encoding = 0; encoding < 8; encoding++) {
-        shifting = bdi_zr_detector(original, encoding);
 #ifdef VERBOSE
         printf("[INITIAL] compressing with encoding %d\n", encoding);
-        printf("shifting: ");
-        print_memory_chunk_bitwise(shifting);
-        printf("\n");
 #endif
-        is_compressed = bdi_zr_compressing_unit(original, &compressed, &shifting, &tag_overhead, encoding);
+        memset(compressed.body, 0, original.size);  // clear writes of failed encodings
+        is_compressed = bdi_zr_compressing_unit(original, nonzero_mask, &compressed, &tag_overhead, encoding);
         if (is_compressed) break;
-        remove_memory_chunk(shifting);
     }
 
+    if (nonzero_mask != mask_buffer)
+        free(nonzero_mask);
+
     result.compressed = compressed;
+    result.is_compressed = is_compressed;
     result.tag_overhead = tag_overhead;
 
     if (result.is_compressed == FALSE) {
@@ -1250,84 +1298,37 @@ CompressionResult bdi_zr_compression(CacheLine original) {
 }
 
 MemoryChunk bdi_zr_detector(CacheLine original, int encoding) {
-    MemoryChunk shifting = make_memory_chunk(16, 0);
-    ValueBuffer base, buffer;
-    int k, zeros_cnt, shift_block_size;
-    int offset = 0;
+    MemoryChunk shifting;
+    ByteArr nonzero_mask;
+    int k = bdi_zr_element_size(encoding), zeros_cnt, shift_block_size;
 
-    switch (encoding) {
-    case 0:
-    case 1:
+    if (k == 0) {
+        shifting = make_memory_chunk(1, 0);
         shifting.size = 0;
         shifting.valid_bitwidth = 0;
         return shifting;
-
-    case 2:
-    case 5:
-    case 7:
-        k = 8;
-        break;
-    
-    case 3:
-    case 6:
-        k = 4;
-        break;
-
-    case 4:
-        k = 2;
-        break;
-    
-    default:
-        break;
-    }
-
-    shift_block_size = (int)log2((double)k) + 1;
-    shifting.size = (int)((original.size / k) * ((double)shift_block_size / BYTE_BITWIDTH));
-    shifting.valid_bitwidth = shifting.size * BYTE_BITWIDTH;
-
-    base = get_value(original.body, 0, k);
-    zeros_cnt = 0;
-
-    for (zeros_cnt = 0; zeros_cnt < k; zeros_cnt++) {
-        if ((base & ((ValueBuffer)0xff << (zeros_cnt * BYTE_BITWIDTH)))) {
-            break;
-        }
     }
 
-    if (zeros_cnt > 0) {
-        set_value_bitwise(shifting.body, 1, 0, 1);
-        set_value_bitwise(shifting.body, zeros_cnt-1, 1, shift_block_size-1);
-    }
-
-    offset += shift_block_size;
-
-    for (int i = k; i < original.size; i += k) {
-        buffer = get_value(original.body, i, k);
-
-        for (zeros_cnt = 0; zeros_cnt < k; zeros_cnt++) {
-            if ((buffer & ((ValueBuffer)0xff << (zeros_cnt * BYTE_BITWIDTH)))) {
-                break;
-            } 
-        }
-
-        if (zeros_cnt > 0) {
-            set_value_bitwise(shifting.body, 1, offset, 1);
-            set_value_bitwise(shifting.body, zeros_cnt-1, offset+1, shift_block_size-1);
-        }
-
-        // printf("[TEST] buffer: 0x%016llx  zeros_cnt: %d  offset: %d\n", buffer, zeros_cnt, offset);
+    shift_block_size = __builtin_ctz(k) + 1;  // log2(k) + 1
+    shifting = make_memory_chunk(ceil((double)(original.size / k) * shift_block_size / BYTE_BITWIDTH), 0);  // sized by the line (e.g. 4KB page)
+    nonzero_mask = (ByteArr)malloc(original.size / BYTE_BITWIDTH + 1);
+    zero_vec_mask(original, nonzero_mask);
 
-        offset += shift_block_size;
+    for (int i = 0; i < original.size; i += k) {
+        zeros_cnt = bdi_zr_trailing_zeros(nonzero_mask, i, k);
+        if (zeros_cnt > 0)
+            set_value_bitwise(shifting.body, 1 | ((zeros_cnt - 1) << 1), (i / k) * shift_block_size, shift_block_size);
     }
 
+    free(nonzero_mask);
     return shifting;
 }
 
-Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryChunk *shifting, MemoryChunk *tag_overhead, int encoding) {
+Bool bdi_zr_compressing_unit(CacheLine original, ByteArr nonzero_mask, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding) {
     ValueBuffer base, buffer, delta, mask;
     MemoryChunk extendinfo;
     int extendinfo_offset;
-    int k, d, zeros_cnt, zeros_cnt_bitwidth, offset, shift_bit, compressed_size;
+    int k, d, zeros_cnt, zeros_cnt_bitwidth, shifting_size, compressed_size;
 
     switch (encoding) {
     case 0:
@@ -1357,45 +1358,40 @@ Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryCh
     case 2:
         k = 8;
         d = 1;
-        zeros_cnt_bitwidth = 3;
         break;
 
     case 3:
         k = 4;
         d = 1;
-        zeros_cnt_bitwidth = 2;
         break;
 
     case 4:
         k = 2;
         d = 1;
-        zeros_cnt_bitwidth = 1;
         break;
 
     case 5:
         k = 8;
         d = 2;
-        zeros_cnt_bitwidth = 3;
         break;
 
     case 6:
         k = 4;
         d = 2;
-        zeros_cnt_bitwidth = 2;
         break;
 
     case 7:
         k = 8;
         d = 4;
-        zeros_cnt_bitwidth = 3;
         break;
     
     default:
-        break;
+        return FALSE;
     }
 
-    offset = 0;
-    compressed_size = shifting->size;
+    zeros_cnt_bitwidth = __builtin_ctz(k);  // log2(k) bits for (trailing zero bytes - 1)
+    shifting_size = ceil((double)(original.size / k) * (zeros_cnt_bitwidth + 1) / BYTE_BITWIDTH);  // shifting information is the head of compressed line
+    compressed_size = shifting_size;
     extendinfo = make_memory_chunk(ceil((double)original.size / (k * BYTE_BITWIDTH)), 0);
     mask = 0;
 
@@ -1404,53 +1400,57 @@ Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryCh
     if (d >= 4) mask += 0xffff0000;
 
     base = get_value(original.body, 0, k);
-    shift_bit = get_value_bitwise(shifting->body, 0, 1);
+    zeros_cnt = bdi_zr_trailing_zeros(nonzero_mask, 0, k);
 
 #ifdef VERBOSE
-    printf("[ITER 0] base: 0x%016llx  shift_bit: %d\n", base, shift_bit != 0);
+    printf("[ITER 0] base: 0x%016llx  zeros_cnt: %d\n", base, zeros_cnt);
 #endif
 
-    if (shift_bit != 0) {
-        zeros_cnt = get_value_bitwise(shifting->body, 1, zeros_cnt_bitwidth);
-        base = base >> ((zeros_cnt + 1) * BYTE_BITWIDTH);
+    if (zeros_cnt > 0) {
+        set_value_bitwise(compressed->body, 1 | ((zeros_cnt - 1) << 1), 0, zeros_cnt_bitwidth + 1);
+        base = zeros_cnt < 8 ? base >> (zeros_cnt * BYTE_BITWIDTH) : 0;
 #ifdef VERBOSE
-    printf(">>> shift base %dBytes -> base: 0x%016llx\n", zeros_cnt+1, base);
-    printf(">>> current compressed size: %dBytes  shifting offset: %dbits\n", compressed_size, offset);
+        printf(">>> shift base %dBytes -> base: 0x%016llx\n", zeros_cnt, base);
+        printf(">>> current compressed size: %dBytes\n", compressed_size);
 #endif
+        if (compressed_size + k > original.size) {
+            remove_memory_chunk(extendinfo);
+            return FALSE;
+        }
         set_value(compressed->body, base, compressed_size, k);
         compressed_size += k;
     }
 
-    offset += 1 + zeros_cnt_bitwidth;
     extendinfo_offset = 1;
 
     for (int i = k; i < original.size; i += k) {
         buffer = get_value(original.body, i, k);
-        shift_bit = get_value_bitwise(shifting->body, offset, 1);
+        zeros_cnt = bdi_zr_trailing_zeros(nonzero_mask, i, k);
 #ifdef VERBOSE
-        printf("[ITER %d] buffer: 0x%016llx  shift_bit: %d\n", i/k, buffer, shift_bit != 0);
+        printf("[ITER %d] buffer: 0x%016llx  zeros_cnt: %d\n", i/k, buffer, zeros_cnt);
 #endif
 
-        if (shift_bit != 0) {
-            zeros_cnt = get_value_bitwise(shifting->body, offset+1, zeros_cnt_bitwidth);
-            if (zeros_cnt == (k - 1)) {
+        if (zeros_cnt > 0) {
+            set_value_bitwise(compressed->body, 1 | ((zeros_cnt - 1) << 1), (i / k) * (zeros_cnt_bitwidth + 1), zeros_cnt_bitwidth + 1);
+            if (zeros_cnt == k) {
 #ifdef VERBOSE
                 printf(">>> do not save delta due to zero value\n");
-                printf(">>> current compressed size: %dBytes  shifting offset: %dbits\n", compressed_size, offset);
 #endif
-                offset += zeros_cnt_bitwidth + 1;
                 continue;
             }
-            buffer = buffer >> ((zeros_cnt + 1) * BYTE_BITWIDTH);
+            buffer = buffer >> (zeros_cnt * BYTE_BITWIDTH);
 #ifdef VERBOSE
-            printf(">>> shift buffer %dBytes -> base: 0x%016llx\n", zeros_cnt+1, base);
-            printf(">>> current compressed size: %dBytes  shifting offset: %dbits\n", compressed_size, offset);
+            printf(">>> shift buffer %dBytes -> buffer: 0x%016llx\n", zeros_cnt, buffer);
 #endif
         }
 
-        offset += zeros_cnt_bitwidth + 1;
         delta = buffer - base;
 
+        if (compressed_size + d > original.size) {  // compressed line cannot be larger than original line
+            remove_memory_chunk(extendinfo);
+            return FALSE;
+        }
+
 #ifdef VERBOSE
         printf("base: 0x%016llx  buffer: 0x%016llx  delta: 0x%016llx  extended: 0x%016llx\n", base, buffer, delta, SIGNEX(delta & mask, (d * BYTE_BITWIDTH) - 1));
 #endif
@@ -1458,19 +1458,20 @@ Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryCh
             set_value(compressed->body, delta, compressed_size, d);
             compressed_size += d;
 #ifdef VERBOSE
-            printf(">>> current compressed size: %dBytes  shifting offset: %dbits (extended with zero pad)\n", compressed_size, offset);
+            printf(">>> current compressed size: %dBytes (extended with zero pad)\n", compressed_size);
 #endif
         } else if ((delta & (~mask)) == (~mask)) {
             set_value_bitwise(extendinfo.body, 1, extendinfo_offset, 1);
             set_value(compressed->body, delta, compressed_size, d);
             compressed_size += d;
 #ifdef VERBOSE
-            printf(">>> current compressed size: %dBytes  shifting offset: %dbits (extended with 1)\n", compressed_size, offset);
+            printf(">>> current compressed size: %dBytes (extended with 1)\n", compressed_size);
 #endif
         } else {
 #ifdef VERBOSE
             printf("failed\n");
 #endif
+            remove_memory_chunk(extendinfo);
             return FALSE;
         }
 
@@ -1478,15 +1479,14 @@ Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryCh
     }
 
     // copy extension information to compressed array
-    for (int i = 0; i < extendinfo.size; i++)
-        set_value(compressed->body, extendinfo.body[i], i + compressed_size, 1);
+    if (compressed_size + extendinfo.size > original.size) {
+        remove_memory_chunk(extendinfo);
+        return FALSE;
+    }
+    memcpy(compressed->body + compressed_size, extendinfo.body, extendinfo.size);
     compressed_size += extendinfo.size;
     remove_memory_chunk(extendinfo);
 
-    // copy shifting information to compressed array
-    for (int i = 0; i < shifting->size; i++) 
-        set_value(compressed->body, shifting->body[i], i, 1);
-
     compressed->size = compressed_size;
     compressed->valid_bitwidth = compressed_size * BYTE_BITWIDTH;
 
@@ -1511,14 +1511,159 @@ Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryCh
  *
  * Functions:
  *   zero_vec_compression: zero vector compression
+ *   zero_vec_decompression: zero vector decompression
+ *   zero_vec_mask: bitmap of nonzero bytes (compare and movemask)
+ *   zero_vec_pack: packs nonzero bytes selected by the bitmap (compress store)
+ *   zero_vec_expand: expands packed nonzero bytes into the line (inverse of zero_vec_pack)
+ *   zero_run_length: length of zeros run from the bitmap of nonzero bytes (tzcnt, shared with FPC)
  *   zeros_run_compression: zeros run compression
+ *
+ * Note
+ *   Zero vector kernels are selected at compile time: AVX-512 (VBMI2 compress/expand), SSSE3
+ *   (8Byte shuffles from a table indexed by bitmap byte) or scalar. SSSE3 kernels load and store
+ *   8Bytes at once, so they fall back to scalar code near the end of packed bytes. Shuffle tables
+ *   are built at load time, so kernels can be called from several threads.
  */
 
+#if defined(__SSSE3__) && !defined(__AVX512VBMI2__)
+static Byte zero_vec_pack_table[256][8];    // positions of nonzero bytes in 8Bytes group
+static Byte zero_vec_expand_table[256][8];  // positions in packed bytes of each byte (0x80: zero byte)
+
+// tables are built when the program is loaded (before main), so threads only read them
+__attribute__((constructor)) static void zero_vec_make_tables(void) {
+    for (int bits = 0; bits < 256; bits++) {
+        int pivot = 0;
+        for (int i = 0; i < BYTE_BITWIDTH; i++) {
+            zero_vec_pack_table[bits][i] = 0x80;
+            zero_vec_expand_table[bits][i] = (bits & (1 << i)) ? pivot : 0x80;
+            if (bits & (1 << i))
+                zero_vec_pack_table[bits][pivot++] = i;
+        }
+    }
+}
+#endif
+
+int zero_vec_mask(CacheLine original, ByteArr mask) {
+    int nonzero_cnt = 0;
+    int i = 0;
+
+#if defined(__AVX512BW__)
+    for (; i + 64 <= original.size; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *)(original.body + i));
+        uint64_t bits = _mm512_test_epi8_mask(v, v);
+        memcpy(mask + i / BYTE_BITWIDTH, &bits, 8);
+        nonzero_cnt += __builtin_popcountll(bits);
+    }
+#endif
+#if defined(__AVX2__)
+    __m256i zeros = _mm256_setzero_si256();
+    for (; i + 32 <= original.size; i += 32) {
+        uint32_t bits = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(original.body + i)), zeros));
+        memcpy(mask + i / BYTE_BITWIDTH, &bits, 4);
+        nonzero_cnt += __builtin_popcount(bits);
+    }
+#elif defined(__SSE2__)
+    __m128i zeros = _mm_setzero_si128();
+    for (; i + 16 <= original.size; i += 16) {
+        uint16_t bits = ~(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(original.body + i)), zeros));
+        memcpy(mask + i / BYTE_BITWIDTH, &bits, 2);
+        nonzero_cnt += __builtin_popcount(bits);
+    }
+#endif
+
+    for (; i < original.size; i++) {
+        if (i % BYTE_BITWIDTH == 0)
+            mask[i / BYTE_BITWIDTH] = 0;
+        if (original.body[i] != 0) {
+            mask[i / BYTE_BITWIDTH] |= 1 << (i % BYTE_BITWIDTH);
+            nonzero_cnt += 1;
+        }
+    }
+
+    return nonzero_cnt;
+}
+
+void zero_vec_pack(CacheLine original, ByteArr mask, int nonzero_cnt, ByteArr packed) {
+    int pivot = 0, i = 0;
+
+#if defined(__AVX512VBMI2__)
+    for (; i + 64 <= original.size; i += 64) {
+        uint64_t bits;
+        memcpy(&bits, mask + i / BYTE_BITWIDTH, 8);
+        _mm512_mask_compressstoreu_epi8(packed + pivot, bits, _mm512_loadu_si512((const void *)(original.body + i)));
+        pivot += __builtin_popcountll(bits);
+    }
+#elif defined(__SSSE3__)
+    for (; i + 8 <= original.size && pivot + 8 <= nonzero_cnt; i += 8) {
+        Byte bits = mask[i / BYTE_BITWIDTH];
+        __m128i v = _mm_loadl_epi64((const __m128i *)(original.body + i));
+        _mm_storel_epi64((__m128i *)(packed + pivot), _mm_shuffle_epi8(v, _mm_loadl_epi64((const __m128i *)zero_vec_pack_table[bits])));
+        pivot += __builtin_popcount(bits);
+    }
+#endif
+
+    for (; i < original.size; i += BYTE_BITWIDTH) {
+        for (Byte bits = mask[i / BYTE_BITWIDTH]; bits; bits &= bits - 1)  // visit nonzero bytes only
+            packed[pivot++] = original.body[i + __builtin_ctz(bits)];
+    }
+}
+
+void zero_vec_expand(ByteArr packed, int nonzero_cnt, ByteArr mask, CacheLine original) {
+    int pivot = 0, i = 0;
+
+#if defined(__AVX512VBMI2__)
+    for (; i + 64 <= original.size; i += 64) {
+        uint64_t bits;
+        memcpy(&bits, mask + i / BYTE_BITWIDTH, 8);
+        _mm512_storeu_si512((void *)(original.body + i), _mm512_maskz_expandloadu_epi8(bits, packed + pivot));
+        pivot += __builtin_popcountll(bits);
+    }
+#elif defined(__SSSE3__)
+    for (; i + 8 <= original.size && pivot + 8 <= nonzero_cnt; i += 8) {
+        Byte bits = mask[i / BYTE_BITWIDTH];
+        __m128i v = _mm_loadl_epi64((const __m128i *)(packed + pivot));
+        _mm_storel_epi64((__m128i *)(original.body + i), _mm_shuffle_epi8(v, _mm_loadl_epi64((const __m128i *)zero_vec_expand_table[bits])));
+        pivot += __builtin_popcount(bits);
+    }
+#endif
+
+    for (; i < original.size; i += BYTE_BITWIDTH) {
+        int group = original.size - i < BYTE_BITWIDTH ? original.size - i : BYTE_BITWIDTH;
+        memset(original.body + i, 0, group);
+        for (Byte bits = mask[i / BYTE_BITWIDTH]; bits; bits &= bits - 1)
+            original.body[i + __builtin_ctz(bits)] = packed[pivot++];
+    }
+}
+
+int zero_run_length(ByteArr mask, int size, int offset) {
+    uint64_t window;
+    int run = 0, pos, bytes, mask_size = (size + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+
+    if (offset < size && (mask[offset / BYTE_BITWIDTH] >> (offset % BYTE_BITWIDTH)) & 1)
+        return 0;  // nonzero byte at offset
+
+    while (offset + run < size) {
+        pos = offset + run;
+        bytes = mask_size - pos / BYTE_BITWIDTH < 8 ? mask_size - pos / BYTE_BITWIDTH : 8;
+        window = 0;
+        memcpy(&window, mask + pos / BYTE_BITWIDTH, bytes);  // up to 64 bytes of the line at once
+        window >>= pos % BYTE_BITWIDTH;
+
+        if (window != 0) {
+            run += __builtin_ctzll(window);  // first nonzero byte ends the run
+            break;
+        }
+        run += bytes * BYTE_BITWIDTH - pos % BYTE_BITWIDTH;
+    }
+
+    return run < size - offset ? run : size - offset;
+}
+
 CompressionResult zero_vec_compression(CacheLine original) {
     CompressionResult result;
     CacheLine compressed;
     const double threshold = 0.5;
-    int zero_cnt, index, offset = original.size;  // in bits
+    int zero_cnt, nonzero_cnt, index, offset = original.size;  // in bits
 
 #ifdef VERBOSE
     printf("Compressing with zero vector algorithm...\n");
@@ -1527,16 +1672,15 @@ CompressionResult zero_vec_compression(CacheLine original) {
     result.compression_type = "Zero Vector algorithm";
     result.original = original;
 
-    zero_cnt = 0;
-    for (index = 0; index < original.size; index++) {
-        if (original.body[index] == 0x00)
-            zero_cnt++;
-    }
+    compressed = make_memory_chunk(original.size, 0);
+    nonzero_cnt = zero_vec_mask(original, compressed.body);  // bitmap is the head of compressed line
+    zero_cnt = original.size - nonzero_cnt;
 
     if (((double)zero_cnt / original.size) < threshold) {
 #ifdef VERBOSE
         printf("failed due to insufficient sparcity of the memory chunk\n");
 #endif  
+        remove_memory_chunk(compressed);
         compressed = copy_memory_chunk(original);
 #ifdef VERBOSE
         printf("compressed size: %dBytes\n", compressed.size);
@@ -1550,20 +1694,22 @@ CompressionResult zero_vec_compression(CacheLine original) {
         return result;
     }
 
-    compressed = make_memory_chunk(original.size, 0);
-
-    // generating bit indexes
-    for (index = 0; index < original.size; index++) {
+    if (original.size % BYTE_BITWIDTH == 0) {
+        zero_vec_pack(original, compressed.body, nonzero_cnt, compressed.body + original.size / BYTE_BITWIDTH);
+        offset += nonzero_cnt * BYTE_BITWIDTH;
+    } else {
+        // nonzero bytes are not byte aligned after the bitmap
+        for (index = 0; index < original.size; index++) {
 #ifdef VERBOSE
-        printf("original.body[%2d] = 0x%02x (is_zero: %5s, offset: %2d, index: %2d)\n", index, 
-                                                               original.body[index], 
-                                                               original.body[index] == 0 ? "true" : "false",
-                                                               offset, index);
+            printf("original.body[%2d] = 0x%02x (is_zero: %5s, offset: %2d, index: %2d)\n", index, 
+                                                                   original.body[index], 
+                                                                   original.body[index] == 0 ? "true" : "false",
+                                                                   offset, index);
 #endif
-        if (original.body[index] != 0x00) {
-            set_value_bitwise(compressed.body, 1, index, 1);
-            set_value_bitwise(compressed.body, original.body[index], offset, BYTE_BITWIDTH);
-            offset += BYTE_BITWIDTH;
+            if (original.body[index] != 0x00) {
+                set_value_bitwise(compressed.body, original.body[index], offset, BYTE_BITWIDTH);
+                offset += BYTE_BITWIDTH;
+            }
         }
     }
 
@@ -1571,9 +1717,9 @@ CompressionResult zero_vec_compression(CacheLine original) {
     compressed.valid_bitwidth =  offset;
     result.compressed = compressed;
     result.is_compressed = TRUE;
-    // result.tag_overhead = make_memory_chunk(1, 0);
-    // result.tag_overhead.size = 0;
-    // result.tag_overhead.valid_bitwidth = 0;
+    result.tag_overhead = make_memory_chunk(1, 0);
+    result.tag_overhead.size = 0;
+    result.tag_overhead.valid_bitwidth = 0;
 
 #ifdef VERBOSE
     printf("succeed\n");
@@ -1582,10 +1728,54 @@ CompressionResult zero_vec_compression(CacheLine original) {
     return result;
 }
 
+DecompressionResult zero_vec_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result;
+    CacheLine original = make_memory_chunk(original_size, 0);
+    int mask_size = (original_size + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+    int nonzero_cnt = 0, offset = original_size;  // in bits
+
+#ifdef VERBOSE
+    printf("Decompressing with zero vector algorithm...\n");
+#endif
+
+    result.compression_type = "Zero Vector algorithm";
+    result.compressed = compressed;
+
+    if (compressed.size >= original_size) {  // stored as it is
+        memcpy(original.body, compressed.body, original_size);
+        result.original = original;
+        result.is_decompressed = TRUE;
+        return result;
+    }
+
+    if (original_size % BYTE_BITWIDTH == 0) {
+        for (int i = 0; i < mask_size; i++)
+            nonzero_cnt += __builtin_popcount(compressed.body[i]);
+        zero_vec_expand(compressed.body + mask_size, nonzero_cnt, compressed.body, original);
+    } else {
+        for (int index = 0; index < original_size; index++) {
+            if (get_value_bitwise(compressed.body, index, 1)) {
+                original.body[index] = get_value_bitwise(compressed.body, offset, BYTE_BITWIDTH);
+                offset += BYTE_BITWIDTH;
+                nonzero_cnt += 1;
+            }
+        }
+    }
+
+#ifdef VERBOSE
+    printf("succeed (nonzero bytes: %d)\n", nonzero_cnt);
+#endif
+
+    result.original = original;
+    result.is_decompressed = TRUE;
+    return result;
+}
+
 CompressionResult zeros_run_compression(CacheLine original) {
     CompressionResult result;
     CacheLine compressed = make_memory_chunk(original.size, 0);
-    ValueBuffer buffer;
+    Byte mask_buffer[ZERO_RUN_MASK_SIZ];
+    ByteArr mask = original.size / BYTE_BITWIDTH < ZERO_RUN_MASK_SIZ ? mask_buffer : (ByteArr)malloc(original.size / BYTE_BITWIDTH + 1);
     int offset = 0, zeros_cnt = 0;
     Bool flag = TRUE;
 
@@ -1596,50 +1786,54 @@ CompressionResult zeros_run_compression(CacheLine original) {
     result.compression_type = "Zeros Run algorithm";
     result.original = original;
 
-    for (int i = 0; (i < original.size) && flag; i++) {
-        buffer = get_value(original.body, i, 1);
+    zero_vec_mask(original, mask);
+
+    for (int i = 0; (i < original.size) && flag;) {
+        zeros_cnt = zero_run_length(mask, original.size, i);
 #ifdef VERBOSE
-        printf("[ITER %2d] buffer: 0x%08x offset: %3d zeros_cnt: %d\n", i, (ByteBuffer)buffer, offset, zeros_cnt);
+        printf("[ITER %2d] buffer: 0x%02x offset: %3d zeros_cnt: %d\n", i, original.body[i], offset, zeros_cnt);
 #endif
 
-        if (buffer == 0) {
-            zeros_cnt += 1;
-        } else {
-            if (zeros_cnt != 0) {
-                if ((original.size * BYTE_BITWIDTH) - offset < 4) {
-                    flag = FALSE;
-                    break;
-                }
-
-                set_value_bitwise(compressed.body, 1, offset, 1);
-                set_value_bitwise(compressed.body, zeros_cnt-1, offset+1, 3);
-                offset += 4;
-                zeros_cnt = 0;
-            }
-
-            if ((original.size * BYTE_BITWIDTH) - offset < (BYTE_BITWIDTH + 1)) {
+        for (; zeros_cnt >= 8; zeros_cnt -= 8, i += 8) {  // runs are split into 8 zero bytes
+            if ((original.size * BYTE_BITWIDTH) - offset < 4) {
                 flag = FALSE;
                 break;
             }
 
-            set_value_bitwise(compressed.body, buffer, offset+1, BYTE_BITWIDTH);
-            offset += BYTE_BITWIDTH+1;
+            set_value_bitwise(compressed.body, 1, offset, 1);
+            set_value_bitwise(compressed.body, 7, offset+1, 3);
+            offset += 4;
         }
+        if (flag == FALSE)
+            break;
 
-        if (zeros_cnt == 8) {
+        i += zeros_cnt;
+        if (i >= original.size)
+            break;  // trailing zeros run
+
+        if (zeros_cnt != 0) {
             if ((original.size * BYTE_BITWIDTH) - offset < 4) {
                 flag = FALSE;
                 break;
             }
 
             set_value_bitwise(compressed.body, 1, offset, 1);
-            set_value_bitwise(compressed.body, 7, offset+1, 3);
+            set_value_bitwise(compressed.body, zeros_cnt-1, offset+1, 3);
             offset += 4;
             zeros_cnt = 0;
         }
+
+        if ((original.size * BYTE_BITWIDTH) - offset < (BYTE_BITWIDTH + 1)) {
+            flag = FALSE;
+            break;
+        }
+
+        set_value_bitwise(compressed.body, original.body[i], offset+1, BYTE_BITWIDTH);
+        offset += BYTE_BITWIDTH+1;
+        i += 1;
     }
 
-    if (zeros_cnt != 0) {
+    if (flag && zeros_cnt != 0) {
         if ((original.size * BYTE_BITWIDTH) - offset < 4) {
             flag = FALSE;
         } else {
@@ -1650,6 +1844,9 @@ CompressionResult zeros_run_compression(CacheLine original) {
         }
     }
 
+    if (mask != mask_buffer)
+        free(mask);
+
     if (flag == FALSE) {
 #ifdef VERBOSE
         printf("failed (compression increases the size)\n");
@@ -1867,6 +2064,7 @@ Bool bdi_ze_compressing_unit(CacheLine original, CacheLine *compressed, MetaData
 #ifdef VERBOSE
             printf("compression failed (sign extension failure)\n");
 #endif
+            remove_memory_chunk(zero_base_encoding);
             return FALSE;
         }
 
@@ -1878,6 +2076,7 @@ Bool bdi_ze_compressing_unit(CacheLine original, CacheLine *compressed, MetaData
     printf("compression succeed\n");
 #endif
 
+    remove_memory_chunk(zero_base_encoding);
     compressed->size = compressed_siz;
     set_value_bitwise(tag_overhead->body, encoding, 0, 4);
     set_value_bitwise(tag_overhead->body, ceil((double)compressed_siz / 8), 4, 7);
@@ -90,6 +90,7 @@ MemoryChunk file2memorychunk(char const *filename, int offset, int size);
 CompressionResult bdi_compression(CacheLine original);                                                  // BDI compression algorithm
 DecompressionResult bdi_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);  // BDI decompression algorithm
 CacheLine bdi_compressing_unit(CacheLine original, int encoding);                                       // Compressing Unit (CU)
+Bool bdi_delta_check(CacheLine original, ValueBuffer base, int k, int d, ByteArr deltas);               // Delta check against given base (deltas can be NULL)
 
 // Functions for FPC(Frequent Pattern Compression) algorithm
 CompressionResult fpc_compression(CacheLine original);                                                  // FPC compression algorithm
@@ -99,15 +100,24 @@ DecompressionResult fpc_decompression(CacheLine compressed, MetaData tag_overhea
 CompressionResult bdi_twobase_compression(CacheLine original);                                                          // BDI compression algorithm with two bases
 DecompressionResult bdi_twobase_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);          // BDI decompression algorithm with two bases
 Bool bdi_twobase_compressing_unit(CacheLine original, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding);  // Compressing Unit (CU)
+int bdi_twobase_scan(CacheLine original, int k, Bool *all_zero, Bool *all_same);                                      // smallest delta size of base size k (all_zero, all_same can be NULL)
 
 // Functions for BDI algorithm with zeros run detection
 CompressionResult bdi_zr_compression(CacheLine original);                                                                                 // BDI compression algorithm with zeros run detection
 DecompressionResult bdi_zr_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);                                 // BDI decompression algorithm with zeros run detection
-Bool bdi_zr_compressing_unit(CacheLine original, CacheLine *compressed, MemoryChunk *shifting, MemoryChunk *tag_overhead, int encoding);  // Compressing Unit (CU)
+Bool bdi_zr_compressing_unit(CacheLine original, ByteArr nonzero_mask, CacheLine *compressed, MemoryChunk *tag_overhead, int encoding);   // Compressing Unit (CU, nonzero_mask: zero_vec_mask of the line)
 MemoryChunk bdi_zr_detector(CacheLine original, int encoding);                                                                            // Zeros run detector
 
+// Parameters of zeros run scanner
+#define ZERO_RUN_MASK_SIZ  65  // bitmap of nonzero bytes is kept on stack for lines up to 512Bytes
+
 // Other algorithms on test
-CompressionResult zero_vec_compression(CacheLine original);   // Zero vector compression algorithm
+CompressionResult zero_vec_compression(CacheLine original);                                                  // Zero vector compression algorithm
+DecompressionResult zero_vec_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);  // Zero vector decompression algorithm
+int zero_vec_mask(CacheLine original, ByteArr mask);                                                         // bitmap of nonzero bytes (returns nonzero count)
+void zero_vec_pack(CacheLine original, ByteArr mask, int nonzero_cnt, ByteArr packed);                       // packs nonzero bytes selected by the bitmap
+void zero_vec_expand(ByteArr packed, int nonzero_cnt, ByteArr mask, CacheLine original);                     // expands packed nonzero bytes into the line
+int zero_run_length(ByteArr mask, int size, int offset);                                                    // length of zeros run at offset (mask: bitmap of nonzero bytes)
 CompressionResult zeros_run_compression(CacheLine original);  // Zeros Run Compression algorithm
 
 // Functions for BDI algorithm with zeros encoding
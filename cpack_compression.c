@@ -0,0 +1,278 @@
+#include "cpack_compression.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+ * Functions for C-Pack algorithm
+ *   C-Pack(Cache Packer) compresses each 32bit word of the cacheline with a small set of static
+ *   patterns (zero words, zero-extended bytes) and a dictionary built while scanning the line.
+ *   The dictionary holds 16 recently seen words with FIFO replacement, and a word matching an
+ *   entry fully or on its high-order 2-3 bytes is encoded with the index of the entry.
+ *
+ * Functions:
+ *   cpack_compression: C-Pack compression algorithm
+ *   cpack_decompression: C-Pack decompression algorithm
+ *   cpack_dictionary_match: compares a word against every dictionary entry at once
+ *
+ * Codewords (2bit prefix, '11' prefix is followed by 2bit extended prefix)
+ *   zzzz: 00                  (zero word)
+ *   xxxx: 01 + 32bits         (unmatched word, pushed to dictionary)
+ *   mmmm: 10 + index          (full match)
+ *   mmxx: 11 00 + index + 16bits  (high-order 2Bytes match, pushed to dictionary)
+ *   zzzx: 11 01 + 8bits       (zero except the lowest byte)
+ *   mmmx: 11 10 + index + 8bits   (high-order 3Bytes match, pushed to dictionary)
+ *
+ * Note
+ *   This algorithm is reference to the paper of IEEE TVLSI (2010)
+ *   url: https://ieeexplore.ieee.org/document/5229354
+ */
+
+int cpack_dictionary_match(uint32_t *dict, int dict_cnt, uint32_t word, int *index) {
+    const uint32_t match_masks[3] = {0xffffffff, 0xffffff00, 0xffff0000};
+    const int match_bytes[3] = {4, 3, 2};
+    uint32_t valid = dict_cnt >= CPACK_DICT_SIZ ? 0xffff : (((uint32_t)1 << dict_cnt) - 1);
+    uint32_t hit;
+
+    for (int m = 0; m < 3; m++) {
+#if defined(__AVX2__)
+        __m256i mask = _mm256_set1_epi32(match_masks[m]);
+        __m256i target = _mm256_and_si256(_mm256_set1_epi32(word), mask);
+        __m256i lo = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(dict + 0)), mask);
+        __m256i hi = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(dict + 8)), mask);
+
+        hit = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lo, target)))
+            | (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hi, target))) << 8;
+#elif defined(__SSE2__)
+        __m128i mask = _mm_set1_epi32(match_masks[m]);
+        __m128i target = _mm_and_si128(_mm_set1_epi32(word), mask);
+
+        hit = 0;
+        for (int g = 0; g < CPACK_DICT_SIZ; g += 4) {
+            __m128i entries = _mm_and_si128(_mm_loadu_si128((const __m128i *)(dict + g)), mask);
+            hit |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(entries, target))) << g;
+        }
+#else
+        hit = 0;
+        for (int e = 0; e < CPACK_DICT_SIZ; e++)
+            hit |= (uint32_t)(((dict[e] ^ word) & match_masks[m]) == 0) << e;
+#endif
+        hit &= valid;
+
+        if (hit) {
+            *index = __builtin_ctz(hit);
+            return match_bytes[m];
+        }
+    }
+
+    return 0;
+}
+
+CompressionResult cpack_compression(CacheLine original) {
+    CompressionResult result;
+    CacheLine compressed = make_memory_chunk(original.size * 2, 0);
+    MetaData tag_overhead = make_memory_chunk(1, 0);  // 1bit flag identifying whether the cacheline is compressed
+    uint32_t dict[CPACK_DICT_SIZ] = {0};
+    uint32_t word;
+    int dict_cnt = 0, dict_pivot = 0;
+    int index, pivot = 0;
+
+#ifdef VERBOSE
+    printf("Compressing with C-Pack algorithm...\n");
+#endif
+
+    result.compression_type = "C-Pack(Cache Packer)";
+    result.original = original;
+
+    if (original.size % WORDSIZ != 0)
+        pivot = original.size * BYTE_BITWIDTH;  // cacheline is not word aligned (not compressible)
+
+    for (int i = 0; i < original.size && pivot < original.size * BYTE_BITWIDTH; i += WORDSIZ) {
+        word = (uint32_t)get_value(original.body, i, WORDSIZ);
+
+        if (word == 0) {
+            set_value_bitwise(compressed.body, 0b00, pivot, 2);  // zzzz
+            pivot += 2;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: zzzz\n", i/WORDSIZ, word);
+#endif
+            continue;
+        }
+
+        if ((word & 0xffffff00) == 0) {
+            set_value_bitwise(compressed.body, 0b11, pivot, 2);  // zzzx
+            set_value_bitwise(compressed.body, 0b01, pivot + 2, 2);
+            set_value_bitwise(compressed.body, word, pivot + 4, 8);
+            pivot += 12;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: zzzx\n", i/WORDSIZ, word);
+#endif
+            continue;
+        }
+
+        switch (cpack_dictionary_match(dict, dict_cnt, word, &index)) {
+        case 4:
+            set_value_bitwise(compressed.body, 0b10, pivot, 2);  // mmmm
+            set_value_bitwise(compressed.body, index, pivot + 2, CPACK_INDEX_BITS);
+            pivot += 2 + CPACK_INDEX_BITS;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: mmmm (index: %d)\n", i/WORDSIZ, word, index);
+#endif
+            continue;  // fully matched word is not pushed to dictionary
+
+        case 3:
+            set_value_bitwise(compressed.body, 0b11, pivot, 2);  // mmmx
+            set_value_bitwise(compressed.body, 0b10, pivot + 2, 2);
+            set_value_bitwise(compressed.body, index, pivot + 4, CPACK_INDEX_BITS);
+            set_value_bitwise(compressed.body, word & 0xff, pivot + 4 + CPACK_INDEX_BITS, 8);
+            pivot += 4 + CPACK_INDEX_BITS + 8;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: mmmx (index: %d)\n", i/WORDSIZ, word, index);
+#endif
+            break;
+
+        case 2:
+            set_value_bitwise(compressed.body, 0b11, pivot, 2);  // mmxx
+            set_value_bitwise(compressed.body, 0b00, pivot + 2, 2);
+            set_value_bitwise(compressed.body, index, pivot + 4, CPACK_INDEX_BITS);
+            set_value_bitwise(compressed.body, word & 0xffff, pivot + 4 + CPACK_INDEX_BITS, 16);
+            pivot += 4 + CPACK_INDEX_BITS + 16;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: mmxx (index: %d)\n", i/WORDSIZ, word, index);
+#endif
+            break;
+
+        default:
+            set_value_bitwise(compressed.body, 0b01, pivot, 2);  // xxxx
+            set_value_bitwise(compressed.body, word, pivot + 2, 32);
+            pivot += 2 + 32;
+#ifdef VERBOSE
+            printf("[ITER %2d] word: 0x%08x  pattern: xxxx\n", i/WORDSIZ, word);
+#endif
+            break;
+        }
+
+        // push partially matched or unmatched word to dictionary (FIFO)
+        dict[dict_pivot] = word;
+        dict_pivot = (dict_pivot + 1) % CPACK_DICT_SIZ;
+        if (dict_cnt < CPACK_DICT_SIZ) dict_cnt += 1;
+    }
+
+    int compressed_size = ceil((double)pivot / BYTE_BITWIDTH);
+
+    if (compressed_size < original.size) {
+        compressed.size = compressed_size;
+        compressed.valid_bitwidth = pivot;
+        result.compressed = compressed;
+        result.is_compressed = TRUE;
+        set_value_bitwise(tag_overhead.body, 1, 0, 1);
+    } else {
+#ifdef VERBOSE
+        printf("compression failed (compressed size: %dBytes)\n", compressed_size);
+#endif
+        remove_memory_chunk(compressed);
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+    }
+
+    tag_overhead.valid_bitwidth = 1;
+    result.tag_overhead = tag_overhead;
+
+#ifdef VERBOSE
+    printf("compression completed\n");
+#endif
+
+    return result;
+}
+
+DecompressionResult cpack_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result;
+    CacheLine original = make_memory_chunk(original_size, 0);
+    uint32_t dict[CPACK_DICT_SIZ] = {0};
+    uint32_t word;
+    int dict_pivot = 0;
+    int prefix, index, pivot = 0;
+
+#ifdef VERBOSE
+    printf("Decompressing with C-Pack algorithm...\n");
+#endif
+
+    result.compression_type = "C-Pack(Cache Packer)";
+    result.compressed = compressed;
+
+    if (get_value_bitwise(tag_overhead.body, 0, 1) == 0) {
+        memcpy(original.body, compressed.body, original_size);
+        result.original = original;
+        result.is_decompressed = TRUE;
+        return result;
+    }
+
+    for (int i = 0; i < original_size; i += WORDSIZ) {
+        prefix = get_value_bitwise(compressed.body, pivot, 2);
+        pivot += 2;
+
+        if (prefix == 0b11) {
+            prefix = 0b100 | get_value_bitwise(compressed.body, pivot, 2);  // extended prefix
+            pivot += 2;
+        }
+
+        switch (prefix) {
+        case 0b00:  // zzzz
+            word = 0;
+            break;
+
+        case 0b01:  // xxxx
+            word = get_value_bitwise(compressed.body, pivot, 32);
+            pivot += 32;
+            break;
+
+        case 0b10:  // mmmm
+            index = get_value_bitwise(compressed.body, pivot, CPACK_INDEX_BITS);
+            word = dict[index];
+            pivot += CPACK_INDEX_BITS;
+            set_value(original.body, word, i, WORDSIZ);
+            continue;
+
+        case 0b100:  // mmxx
+            index = get_value_bitwise(compressed.body, pivot, CPACK_INDEX_BITS);
+            word = (dict[index] & 0xffff0000) | get_value_bitwise(compressed.body, pivot + CPACK_INDEX_BITS, 16);
+            pivot += CPACK_INDEX_BITS + 16;
+            break;
+
+        case 0b101:  // zzzx
+            word = get_value_bitwise(compressed.body, pivot, 8);
+            pivot += 8;
+            set_value(original.body, word, i, WORDSIZ);
+            continue;
+
+        case 0b110:  // mmmx
+            index = get_value_bitwise(compressed.body, pivot, CPACK_INDEX_BITS);
+            word = (dict[index] & 0xffffff00) | get_value_bitwise(compressed.body, pivot + CPACK_INDEX_BITS, 8);
+            pivot += CPACK_INDEX_BITS + 8;
+            break;
+
+        default:
+            result.original = original;
+            result.is_decompressed = FALSE;
+            return result;
+        }
+
+        set_value(original.body, word, i, WORDSIZ);
+
+        if (prefix == 0b00) continue;  // zero word is not pushed to dictionary
+
+        dict[dict_pivot] = word;
+        dict_pivot = (dict_pivot + 1) % CPACK_DICT_SIZ;
+    }
+
+#ifdef VERBOSE
+    printf("decompression completed\n");
+#endif
+
+    result.original = original;
+    result.is_decompressed = TRUE;
+
+    return result;
+}
@@ -0,0 +1,18 @@
+#ifndef CPACK_COMPRESSION
+#define CPACK_COMPRESSION
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for C-Pack dictionary
+#define CPACK_DICT_SIZ    16  // number of dictionary entries (FIFO replacement)
+#define CPACK_INDEX_BITS  4   // bitwidth of dictionary index
+
+// Functions for C-Pack(Cache Packer) algorithm
+CompressionResult cpack_compression(CacheLine original);                                                  // C-Pack compression algorithm
+DecompressionResult cpack_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);  // C-Pack decompression algorithm
+int cpack_dictionary_match(uint32_t *dict, int dict_cnt, uint32_t word, int *index);                     // Dictionary matching unit (returns matched bytes)
+
+#endif
@@ -0,0 +1,85 @@
+#include "dram_model.h"
+
+
+/*
+ * Functions for DRAM burst and bandwidth model
+ *   DRAM transfers data in bursts, so compressed lines only save traffic when they need fewer
+ *   bursts than the original line (e.g. a 64Bytes line compressed to 40Bytes still takes a 64Bytes
+ *   burst, and a 1.3x byte ratio can be no saving at all). Each line access is mapped onto bursts
+ *   of its compressed size (lines which are not smaller than the original are stored as they are).
+ *
+ *   Metadata (tag overhead) is either stored in ECC bits and fetched with the data for free, or
+ *   stored in a separate region behind a metadata cache, in which case every access misses the
+ *   cache with the given probability and fetches one metadata burst. The modeled bandwidth assumes
+ *   a bandwidth-bound workload: effective bandwidth is the peak bandwidth scaled by the ratio of
+ *   original bytes to bytes on the bus.
+ *
+ * Functions:
+ *   make_dram_config: configuration of memory system
+ *   make_dram_traffic: empty traffic counter
+ *   dram_add_line: adds an access of a (compressed) line
+ *   dram_transferred_bytes: bytes on the bus (data and metadata bursts)
+ *   dram_burst_savings: fraction of bursts saved by compression
+ *   dram_effective_bandwidth: uncompressed bytes delivered per second (GB/s)
+ *
+ * Note
+ *   Tag bits are assumed to fit in the spare ECC bits (DRAM_META_IN_ECC), and lines smaller than
+ *   a burst still take a whole burst
+ */
+
+#define DRAM_BURSTS(size, burst) (((long)(size) + (burst) - 1) / (burst))
+
+DramConfig make_dram_config(int burst_size, int metadata_mode, double meta_hit_rate, double bandwidth) {
+    DramConfig config;
+    config.burst_size = burst_size;
+    config.metadata_mode = metadata_mode;
+    config.meta_hit_rate = meta_hit_rate < 0 ? 0 : (meta_hit_rate > 1 ? 1 : meta_hit_rate);
+    config.bandwidth = bandwidth;
+    return config;
+}
+
+DramTraffic make_dram_traffic(void) {
+    DramTraffic traffic;
+    traffic.lines = 0;
+    traffic.original_bytes = 0;
+    traffic.compressed_bytes = 0;
+    traffic.original_bursts = 0;
+    traffic.data_bursts = 0;
+    traffic.meta_bursts = 0;
+    return traffic;
+}
+
+void dram_add_line(DramTraffic *traffic, DramConfig config, int original_size, int compressed_size) {
+    int stored_size = compressed_size < original_size ? compressed_size : original_size;
+
+    traffic->lines += 1;
+    traffic->original_bytes += original_size;
+    traffic->compressed_bytes += stored_size;
+    traffic->original_bursts += DRAM_BURSTS(original_size, config.burst_size);
+    traffic->data_bursts += DRAM_BURSTS(stored_size, config.burst_size);
+
+    if (config.metadata_mode == DRAM_META_SEPARATE)
+        traffic->meta_bursts += 1 - config.meta_hit_rate;  // every access looks up the tag
+
+#ifdef VERBOSE
+    printf("line %dBytes -> %dBytes (%ld -> %ld bursts)\n", original_size, stored_size,
+           DRAM_BURSTS(original_size, config.burst_size), DRAM_BURSTS(stored_size, config.burst_size));
+#endif
+}
+
+long dram_transferred_bytes(DramTraffic traffic, DramConfig config) {
+    return (long)((traffic.data_bursts + traffic.meta_bursts) * config.burst_size + 0.5);
+}
+
+double dram_burst_savings(DramTraffic traffic) {
+    if (traffic.original_bursts == 0)
+        return 0;
+    return 1 - (traffic.data_bursts + traffic.meta_bursts) / traffic.original_bursts;
+}
+
+double dram_effective_bandwidth(DramTraffic traffic, DramConfig config) {
+    long transferred = dram_transferred_bytes(traffic, config);
+    if (transferred == 0)
+        return config.bandwidth;
+    return config.bandwidth * traffic.original_bytes / transferred;
+}
@@ -0,0 +1,39 @@
+#ifndef DRAM_MODEL
+#define DRAM_MODEL
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for DRAM traffic model
+#define DRAM_DEFAULT_BURST      64     // bytes per burst (e.g. DDR4 x64 BL8)
+#define DRAM_DEFAULT_BANDWIDTH  25.6   // peak bandwidth of a channel (GB/s, DDR4-3200)
+#define DRAM_META_IN_ECC        0      // tag is stored in ECC bits (fetched with the data)
+#define DRAM_META_SEPARATE      1      // tag is stored in a separate region (fetched on metadata cache miss)
+
+typedef struct {
+    int     burst_size;      // bytes per burst (32 or 64)
+    int     metadata_mode;   // DRAM_META_IN_ECC or DRAM_META_SEPARATE
+    double  meta_hit_rate;   // hit rate of metadata cache (DRAM_META_SEPARATE)
+    double  bandwidth;       // peak bandwidth (GB/s)
+} DramConfig;
+
+typedef struct {
+    long    lines;            // number of accessed lines
+    long    original_bytes;   // total size of lines
+    long    compressed_bytes; // total compressed size (uncompressed lines count as original size)
+    long    original_bursts;  // bursts to transfer the lines without compression
+    long    data_bursts;      // bursts to transfer the compressed lines
+    double  meta_bursts;      // expected bursts to fetch metadata (DRAM_META_SEPARATE)
+} DramTraffic;
+
+// Functions for DRAM burst and bandwidth model
+DramConfig make_dram_config(int burst_size, int metadata_mode, double meta_hit_rate, double bandwidth);  // configuration of memory system
+DramTraffic make_dram_traffic(void);                                                                     // empty traffic counter
+void dram_add_line(DramTraffic *traffic, DramConfig config, int original_size, int compressed_size);     // adds an access of a (compressed) line
+long dram_transferred_bytes(DramTraffic traffic, DramConfig config);                                     // bytes on the bus (data and metadata bursts)
+double dram_burst_savings(DramTraffic traffic);                                                          // fraction of bursts saved by compression (bursts are counted in burst size of the config)
+double dram_effective_bandwidth(DramTraffic traffic, DramConfig config);                                 // uncompressed bytes delivered per second (GB/s)
+
+#endif
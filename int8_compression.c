@@ -0,0 +1,351 @@
+#include "int8_compression.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+ * Functions for int8 quantized tensor compression
+ *   Quantized tensors (int_repr of qint8 weights and quint8 activations) are byte-typed, while BDI
+ *   only uses 2/4/8Bytes bases. These algorithms work on byte lanes: int8 BDI keeps a 1Byte base
+ *   with 2bit or 4bit deltas (frame of reference, base is the minimum byte), and int8 ZV keeps a
+ *   bitmap of nonzero bytes for ReLU sparsity, followed by the nonzero bytes either raw or as 4bit
+ *   deltas. Range of bytes is checked both as signed and unsigned values, so that qint8 values
+ *   around zero (e.g. 0xfe-0x03) and quint8 values (e.g. 0x7e-0x83) are both in a small range.
+ *
+ * Functions:
+ *   int8_bdi_compression: 1Byte base with sub-byte deltas (zeros, repeated, 2bit, 4bit deltas)
+ *   int8_zv_compression: zero bitmap with raw or delta coded nonzero bytes
+ *   int8_decompression: decompression of both algorithms
+ *   int8_range: smallest (max - min) of signed and unsigned bytes with byte lane SIMD kernel
+ *   int8_zero_mask: bitmap of nonzero bytes (zero_vec_mask kernel)
+ *
+ * Note
+ *   Deltas are stored LSB first (as set_value_bitwise), and kernels are selected at compile time
+ *   (AVX2, SSE2 or scalar)
+ */
+
+int int8_range(CacheLine original, Bool skip_zeros, Byte *base) {
+    Byte umin = 0xff, umax = 0x00, smin = 0xff, smax = 0x00;  // signed bytes are compared with sign bit flipped
+    Byte buffer, zero_mask;
+    int i = 0;
+
+#if defined(__AVX2__)
+    __m256i vumin = _mm256_set1_epi8((char)0xff), vumax = _mm256_setzero_si256();
+    __m256i vsmin = _mm256_set1_epi8((char)0xff), vsmax = _mm256_setzero_si256();
+    __m256i sign = _mm256_set1_epi8((char)0x80);
+    __m256i zeros = _mm256_setzero_si256();
+    Byte lanes[4][32];
+
+    for (; i + 32 <= original.size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(original.body + i));
+        __m256i s = _mm256_xor_si256(v, sign);
+        __m256i zm = skip_zeros ? _mm256_cmpeq_epi8(v, zeros) : zeros;  // zero bytes never become min or max
+        vumin = _mm256_min_epu8(vumin, _mm256_or_si256(v, zm));
+        vumax = _mm256_max_epu8(vumax, _mm256_andnot_si256(zm, v));
+        vsmin = _mm256_min_epu8(vsmin, _mm256_or_si256(s, zm));
+        vsmax = _mm256_max_epu8(vsmax, _mm256_andnot_si256(zm, s));
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes[0], vumin);
+    _mm256_storeu_si256((__m256i *)lanes[1], vumax);
+    _mm256_storeu_si256((__m256i *)lanes[2], vsmin);
+    _mm256_storeu_si256((__m256i *)lanes[3], vsmax);
+    for (int l = 0; l < 32; l++) {
+        if (lanes[0][l] < umin) umin = lanes[0][l];
+        if (lanes[1][l] > umax) umax = lanes[1][l];
+        if (lanes[2][l] < smin) smin = lanes[2][l];
+        if (lanes[3][l] > smax) smax = lanes[3][l];
+    }
+#elif defined(__SSE2__)
+    __m128i vumin = _mm_set1_epi8((char)0xff), vumax = _mm_setzero_si128();
+    __m128i vsmin = _mm_set1_epi8((char)0xff), vsmax = _mm_setzero_si128();
+    __m128i sign = _mm_set1_epi8((char)0x80);
+    __m128i zeros = _mm_setzero_si128();
+    Byte lanes[4][16];
+
+    for (; i + 16 <= original.size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(original.body + i));
+        __m128i s = _mm_xor_si128(v, sign);
+        __m128i zm = skip_zeros ? _mm_cmpeq_epi8(v, zeros) : zeros;  // zero bytes never become min or max
+        vumin = _mm_min_epu8(vumin, _mm_or_si128(v, zm));
+        vumax = _mm_max_epu8(vumax, _mm_andnot_si128(zm, v));
+        vsmin = _mm_min_epu8(vsmin, _mm_or_si128(s, zm));
+        vsmax = _mm_max_epu8(vsmax, _mm_andnot_si128(zm, s));
+    }
+
+    _mm_storeu_si128((__m128i *)lanes[0], vumin);
+    _mm_storeu_si128((__m128i *)lanes[1], vumax);
+    _mm_storeu_si128((__m128i *)lanes[2], vsmin);
+    _mm_storeu_si128((__m128i *)lanes[3], vsmax);
+    for (int l = 0; l < 16; l++) {
+        if (lanes[0][l] < umin) umin = lanes[0][l];
+        if (lanes[1][l] > umax) umax = lanes[1][l];
+        if (lanes[2][l] < smin) smin = lanes[2][l];
+        if (lanes[3][l] > smax) smax = lanes[3][l];
+    }
+#endif
+
+    for (; i < original.size; i++) {
+        buffer = original.body[i];
+        zero_mask = (skip_zeros && buffer == 0) ? 0xff : 0x00;
+        if ((buffer | zero_mask) < umin) umin = buffer | zero_mask;
+        if ((buffer & ~zero_mask) > umax) umax = buffer & ~zero_mask;
+        if (((buffer ^ 0x80) | zero_mask) < smin) smin = (buffer ^ 0x80) | zero_mask;
+        if (((buffer ^ 0x80) & ~zero_mask) > smax) smax = (buffer ^ 0x80) & ~zero_mask;
+    }
+
+    if (umin > umax) {  // every byte is skipped
+        *base = 0;
+        return 0;
+    }
+
+    if (smax - smin < umax - umin) {
+        *base = smin ^ 0x80;
+        return smax - smin;
+    }
+
+    *base = umin;
+    return umax - umin;
+}
+
+int int8_zero_mask(CacheLine original, ByteArr mask) {
+    return zero_vec_mask(original, mask);  // shared with zero vector compression
+}
+
+static void int8_pack4(ByteArr src, int n, Byte base, ByteArr dst) {
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128i vbase = _mm_set1_epi8((char)base);
+    __m128i low = _mm_set1_epi16(0x000f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(src + i)), vbase);
+        __m128i even = _mm_and_si128(d, low);                        // bytes 2j (low nibble of 16bit lane)
+        __m128i odd = _mm_and_si128(_mm_srli_epi16(d, 8), low);      // bytes 2j+1
+        __m128i packed = _mm_or_si128(even, _mm_slli_epi16(odd, 4));
+        _mm_storel_epi64((__m128i *)(dst + i / 2), _mm_packus_epi16(packed, packed));
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (i % 2 == 0) dst[i / 2] = (Byte)(src[i] - base) & 0x0f;
+        else            dst[i / 2] |= ((Byte)(src[i] - base) & 0x0f) << 4;
+    }
+}
+
+static void int8_unpack4(ByteArr src, int n, Byte base, ByteArr dst) {
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128i vbase = _mm_set1_epi8((char)base);
+    __m128i low = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i packed = _mm_loadl_epi64((const __m128i *)(src + i / 2));
+        __m128i even = _mm_and_si128(packed, low);
+        __m128i odd = _mm_and_si128(_mm_srli_epi16(packed, 4), low);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi8(_mm_unpacklo_epi8(even, odd), vbase));
+    }
+#endif
+
+    for (; i < n; i++)
+        dst[i] = (Byte)(((src[i / 2] >> ((i % 2) * 4)) & 0x0f) + base);
+}
+
+static void int8_pack2(ByteArr src, int n, Byte base, ByteArr dst) {
+    for (int i = 0; i < n; i++) {
+        if (i % 4 == 0) dst[i / 4] = 0;
+        dst[i / 4] |= ((Byte)(src[i] - base) & 0x03) << ((i % 4) * 2);
+    }
+}
+
+static void int8_unpack2(ByteArr src, int n, Byte base, ByteArr dst) {
+    for (int i = 0; i < n; i++)
+        dst[i] = (Byte)(((src[i / 4] >> ((i % 4) * 2)) & 0x03) + base);
+}
+
+static CompressionResult int8_compress(CacheLine original, Bool use_bdi, Bool use_zv) {
+    CompressionResult result;
+    CacheLine compressed;
+    MetaData tag_overhead = make_memory_chunk(2, 0);  // 2Bytes of tag overhead with its valid bitwidth of 11bits
+    MemoryChunk mask = make_memory_chunk((original.size + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH, 0);
+    int mask_size = mask.size;
+    int encoding = INT8_UNCOMPRESSED, best_size = original.size, size;
+    int nonzero_cnt, range;
+    Byte base = 0, nonzero_base = 0;
+    ByteArr nonzeros;
+
+    result.compression_type = "INT8(Quantized tensor compression)";
+    result.original = original;
+
+    nonzero_cnt = int8_zero_mask(original, mask.body);
+
+    if (nonzero_cnt == 0) {
+        encoding = INT8_ZEROS;  // zero line fast path
+        best_size = 1;
+    } else {
+        if (use_bdi) {
+            range = int8_range(original, FALSE, &base);
+            size = range == 0 ? 1 : range <= 0x03 ? 1 + (original.size + 3) / 4 : range <= 0x0f ? 1 + (original.size + 1) / 2 : original.size;
+            if (size < best_size) {
+                best_size = size;
+                encoding = range == 0 ? INT8_REPEATED : range <= 0x03 ? INT8_BASE_DELTA2 : INT8_BASE_DELTA4;
+            }
+        }
+
+        if (use_zv) {
+            if (mask_size + nonzero_cnt < best_size) {
+                best_size = mask_size + nonzero_cnt;
+                encoding = INT8_ZV_RAW;
+            }
+            if (int8_range(original, TRUE, &nonzero_base) <= 0x0f && mask_size + 1 + (nonzero_cnt + 1) / 2 < best_size) {
+                best_size = mask_size + 1 + (nonzero_cnt + 1) / 2;
+                encoding = INT8_ZV_DELTA4;
+            }
+        }
+    }
+
+#ifdef VERBOSE
+    printf("int8 encoding: %d  nonzero bytes: %d  size: %dBytes\n", encoding, nonzero_cnt, best_size);
+#endif
+
+    if (encoding == INT8_UNCOMPRESSED) {
+        remove_memory_chunk(mask);
+        result.compressed = copy_memory_chunk(original);
+        result.is_compressed = FALSE;
+        set_value_bitwise(tag_overhead.body, INT8_UNCOMPRESSED, 0, 4);
+        set_value_bitwise(tag_overhead.body, (ValueBuffer)ceil((double)original.size / BYTE_BITWIDTH), 4, 7);
+        tag_overhead.valid_bitwidth = 11;
+        result.tag_overhead = tag_overhead;
+        return result;
+    }
+
+    compressed = make_memory_chunk(best_size, 0);
+
+    switch (encoding) {
+    case INT8_ZEROS:
+        compressed.body[0] = 0;
+        break;
+
+    case INT8_REPEATED:
+        compressed.body[0] = base;
+        break;
+
+    case INT8_BASE_DELTA2:
+        compressed.body[0] = base;
+        int8_pack2(original.body, original.size, base, compressed.body + 1);
+        break;
+
+    case INT8_BASE_DELTA4:
+        compressed.body[0] = base;
+        int8_pack4(original.body, original.size, base, compressed.body + 1);
+        break;
+
+    case INT8_ZV_RAW:
+    case INT8_ZV_DELTA4:
+        memcpy(compressed.body, mask.body, mask_size);
+        nonzeros = encoding == INT8_ZV_RAW ? compressed.body + mask_size : (ByteArr)malloc(nonzero_cnt);
+        zero_vec_pack(original, mask.body, nonzero_cnt, nonzeros);
+        if (encoding == INT8_ZV_DELTA4) {
+            compressed.body[mask_size] = nonzero_base;
+            int8_pack4(nonzeros, nonzero_cnt, nonzero_base, compressed.body + mask_size + 1);
+            free(nonzeros);
+        }
+        break;
+    }
+
+    remove_memory_chunk(mask);
+
+    result.compressed = compressed;
+    result.is_compressed = TRUE;
+    set_value_bitwise(tag_overhead.body, encoding, 0, 4);
+    set_value_bitwise(tag_overhead.body, (ValueBuffer)ceil((double)compressed.size / BYTE_BITWIDTH), 4, 7);
+    tag_overhead.valid_bitwidth = 11;
+    result.tag_overhead = tag_overhead;
+
+#ifdef VERBOSE
+    printf("compression completed\n");
+#endif
+
+    return result;
+}
+
+CompressionResult int8_bdi_compression(CacheLine original) {
+#ifdef VERBOSE
+    printf("Compressing with int8 BDI algorithm...\n");
+#endif
+    return int8_compress(original, TRUE, FALSE);
+}
+
+CompressionResult int8_zv_compression(CacheLine original) {
+#ifdef VERBOSE
+    printf("Compressing with int8 zero vector algorithm...\n");
+#endif
+    return int8_compress(original, FALSE, TRUE);
+}
+
+DecompressionResult int8_decompression(CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result;
+    CacheLine original = make_memory_chunk(original_size, 0);
+    int encoding = get_value_bitwise(tag_overhead.body, 0, 4);
+    int mask_size = (original_size + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+    int nonzero_cnt = 0;
+    ByteArr nonzeros;
+
+#ifdef VERBOSE
+    printf("Decompressing with int8 algorithm...\n");
+    printf("encoding: %d\n", encoding);
+#endif
+
+    result.compression_type = "INT8(Quantized tensor compression)";
+    result.compressed = compressed;
+    result.is_decompressed = TRUE;
+
+    switch (encoding) {
+    case INT8_ZEROS:
+        memset(original.body, 0, original_size);
+        break;
+
+    case INT8_REPEATED:
+        memset(original.body, compressed.body[0], original_size);
+        break;
+
+    case INT8_BASE_DELTA2:
+        int8_unpack2(compressed.body + 1, original_size, compressed.body[0], original.body);
+        break;
+
+    case INT8_BASE_DELTA4:
+        int8_unpack4(compressed.body + 1, original_size, compressed.body[0], original.body);
+        break;
+
+    case INT8_ZV_RAW:
+    case INT8_ZV_DELTA4:
+        for (int i = 0; i < mask_size; i++)
+            nonzero_cnt += __builtin_popcount(compressed.body[i]);
+
+        if (encoding == INT8_ZV_RAW) {
+            nonzeros = compressed.body + mask_size;
+        } else {
+            nonzeros = (ByteArr)malloc(nonzero_cnt > 0 ? nonzero_cnt : 1);
+            int8_unpack4(compressed.body + mask_size + 1, nonzero_cnt, compressed.body[mask_size], nonzeros);
+        }
+
+        zero_vec_expand(nonzeros, nonzero_cnt, compressed.body, original);
+
+        if (encoding == INT8_ZV_DELTA4)
+            free(nonzeros);
+        break;
+
+    case INT8_UNCOMPRESSED:
+        memcpy(original.body, compressed.body, original_size);
+        break;
+
+    default:
+        result.is_decompressed = FALSE;
+        break;
+    }
+
+    result.original = original;
+    return result;
+}
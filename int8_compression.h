@@ -0,0 +1,25 @@
+#ifndef INT8_COMPRESSION
+#define INT8_COMPRESSION
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Encodings of int8 compression (tag_overhead = {encoding(4bits), segment_pointer(7bits)} as BDI)
+#define INT8_ZEROS         0   // all zero bytes                                 (1Byte)
+#define INT8_REPEATED      1   // repeated byte                                  (1Byte)
+#define INT8_BASE_DELTA2   2   // 1Byte base + 2bit deltas                       (1 + n/4 Bytes)
+#define INT8_BASE_DELTA4   3   // 1Byte base + 4bit deltas                       (1 + n/2 Bytes)
+#define INT8_ZV_RAW        4   // zero bitmap + nonzero bytes                    (n/8 + nnz Bytes)
+#define INT8_ZV_DELTA4     5   // zero bitmap + 1Byte base + 4bit deltas of nonzero bytes (n/8 + 1 + nnz/2 Bytes)
+#define INT8_UNCOMPRESSED  15
+
+// Functions for int8 quantized tensor compression
+CompressionResult int8_bdi_compression(CacheLine original);                                                // 1Byte base with sub-byte deltas
+CompressionResult int8_zv_compression(CacheLine original);                                                 // zero bitmap with raw or delta coded nonzero bytes
+DecompressionResult int8_decompression(CacheLine compressed, MetaData tag_overhead, int original_size);    // decompression of both algorithms
+int int8_range(CacheLine original, Bool skip_zeros, Byte *base);                                          // smallest (max - min) of signed and unsigned bytes
+int int8_zero_mask(CacheLine original, ByteArr mask);                                                     // bitmap of nonzero bytes (returns nonzero count)
+
+#endif
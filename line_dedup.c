@@ -0,0 +1,97 @@
+#include "line_dedup.h"
+
+
+/*
+ * Functions for cross-line deduplication
+ *   Identical lines (padding, zero channels, tied weights) are detected by hashing every line
+ *   into an open-addressing (linear probing) table. Only 64bit hashes and the offsets of their
+ *   first lines are kept, so the table uses fixed memory regardless of the input size: once the
+ *   table reaches its maximum load, unseen lines are counted as unique without being indexed
+ *   (dedup ratio is underestimated).
+ *
+ * Functions:
+ *   line_hash64: 64bit hash of a memory line (8Bytes per step, murmur3 finalizer)
+ *   make_dedup_table: allocates table with 2^capacity_bits slots
+ *   reset_dedup_table: empties table
+ *   remove_dedup_table: removes table
+ *   dedup_lookup_insert: looks up the hash and inserts it with the line offset if it is unseen
+ *
+ * Note
+ *   A hash hit does not guarantee identical lines: the caller compares the line at the returned
+ *   offset and counts the line as unique (hash collision) if they differ.
+ */
+
+#define DEDUP_PRIME1  0x9e3779b185ebca87ULL
+#define DEDUP_PRIME2  0xc2b2ae3d27d4eb4fULL
+
+static uint64_t dedup_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+uint64_t line_hash64(ByteArr arr, int size) {
+    uint64_t hash = DEDUP_PRIME1 ^ (uint64_t)size;
+    uint64_t buffer;
+    int i;
+
+    for (i = 0; i + DWORDSIZ <= size; i += DWORDSIZ) {
+        memcpy(&buffer, arr + i, DWORDSIZ);
+        hash ^= dedup_rotl(buffer * DEDUP_PRIME2, 31) * DEDUP_PRIME1;
+        hash = dedup_rotl(hash, 27) * DEDUP_PRIME1 + DEDUP_PRIME2;
+    }
+
+    if (i < size) {
+        buffer = 0;
+        memcpy(&buffer, arr + i, size - i);
+        hash ^= dedup_rotl(buffer * DEDUP_PRIME2, 31) * DEDUP_PRIME1;
+    }
+
+    // finalizer (avalanche)
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+DedupTable make_dedup_table(int capacity_bits) {
+    DedupTable table;
+    table.capacity = 1L << capacity_bits;
+    table.slots = (DedupSlot *)calloc(table.capacity, sizeof(DedupSlot));
+    table.occupied = 0;
+    table.overflowed = 0;
+    return table;
+}
+
+void reset_dedup_table(DedupTable *table) {
+    memset(table->slots, 0, table->capacity * sizeof(DedupSlot));
+    table->occupied = 0;
+    table->overflowed = 0;
+}
+
+void remove_dedup_table(DedupTable table) {
+    free(table.slots);
+}
+
+long dedup_lookup_insert(DedupTable *table, uint64_t hash, long offset) {
+    long mask = table->capacity - 1;
+    long slot;
+
+    if (hash == 0) hash = 1;  // 0 is reserved for empty slot
+
+    for (slot = hash & mask; table->slots[slot].hash != 0; slot = (slot + 1) & mask) {
+        if (table->slots[slot].hash == hash)
+            return table->slots[slot].offset;
+    }
+
+    if (table->occupied >= table->capacity * DEDUP_MAX_LOAD) {
+        table->overflowed += 1;
+        return -1;
+    }
+
+    table->slots[slot].hash = hash;
+    table->slots[slot].offset = offset;
+    table->occupied += 1;
+    return -1;
+}
@@ -0,0 +1,34 @@
+#ifndef LINE_DEDUP
+#define LINE_DEDUP
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for deduplication hash index
+#define DEDUP_DEFAULT_BITS  22  // 4M slots (64MB) by default
+#define DEDUP_MAX_LOAD      0.75
+#define DEDUP_MAX_BITS      30  // 1G slots (16GB) at most
+#define DEDUP_REF_SIZE      4   // Bytes of reference (unique line index) stored for every line
+
+typedef struct {
+    uint64_t hash;          // 64bit line hash (0: empty)
+    long     offset;        // byte offset of the first line indexed with this hash
+} DedupSlot;
+
+typedef struct {
+    DedupSlot *slots;       // open-addressing slots
+    long      capacity;     // number of slots (power of 2)
+    long      occupied;     // number of occupied slots (unique lines indexed)
+    long      overflowed;   // number of unseen lines not indexed because the table reached its max load
+} DedupTable;
+
+// Functions for cross-line deduplication
+uint64_t line_hash64(ByteArr arr, int size);                            // 64bit hash of a memory line
+DedupTable make_dedup_table(int capacity_bits);                         // allocates table with 2^capacity_bits slots
+void reset_dedup_table(DedupTable *table);                              // empties table
+void remove_dedup_table(DedupTable table);                              // removes table
+long dedup_lookup_insert(DedupTable *table, uint64_t hash, long offset);  // offset of the line seen before with the same hash (-1: unseen)
+
+#endif
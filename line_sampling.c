@@ -0,0 +1,171 @@
+#include "line_sampling.h"
+
+
+/*
+ * Functions for line sampling
+ *   Reading the first N lines of a layer file is biased toward the beginning of the file. Lines
+ *   are instead drawn uniformly across the whole file, or stratified: the file is split into
+ *   equal ranges of lines (strata) and one line is drawn from each stratum in turn. Strata are
+ *   visited in a random order, so that fewer samples than strata are spread over the whole file
+ *   rather than taken from its beginning. Random number generator has a fixed seed, so the same
+ *   lines are sampled on every run.
+ *
+ *   Compression ratio is estimated as line size over the (stratified) mean of compressed sizes,
+ *   and its 95% confidence interval follows from the standard error of the mean (delta method).
+ *   Strata without samples yet are left out and the weights of sampled strata are renormalized.
+ *   With fewer samples than strata, sampled strata are a random subset (every stratum is equally
+ *   likely to be sampled), so the estimate has no positional bias, but its confidence interval is
+ *   not available until every stratum has two samples.
+ *   Lines are drawn with replacement, which is negligible for large files and conservative for
+ *   small ones.
+ *
+ * Functions:
+ *   make_line_sampler: sampler over lines of a file
+ *   next_sample_line: index of the next line to compress
+ *   sample_subline: sub-line of a sampled line, used when a line holds several smaller lines
+ *   make_ratio_estimator: estimator with strata of the sampler
+ *   remove_ratio_estimator: removes estimator
+ *   add_ratio_sample: adds compressed size of a sampled line
+ *   estimate_ratio: compression ratio and half width of its 95% confidence interval
+ */
+
+static uint64_t sampler_random(LineSampler *sampler) {
+    sampler->state ^= sampler->state >> 12;
+    sampler->state ^= sampler->state << 25;
+    sampler->state ^= sampler->state >> 27;
+    return sampler->state * 0x2545f4914f6cdd1dULL;
+}
+
+static long stratum_begin(long line_num, int strata_num, int stratum) {
+    return (long)((double)line_num * stratum / strata_num);
+}
+
+LineSampler make_line_sampler(long line_num, int mode, uint64_t seed) {
+    LineSampler sampler;
+    sampler.mode = mode;
+    sampler.line_num = line_num;
+    sampler.strata_num = 1;
+    sampler.drawn = 0;
+    sampler.seed = seed;
+    sampler.state = seed == 0 ? SAMPLE_DEFAULT_SEED : seed;  // state of xorshift should not be zero
+
+    if (mode == SAMPLE_STRATIFIED)
+        sampler.strata_num = line_num < SAMPLE_STRATA_NUM ? (line_num > 0 ? line_num : 1) : SAMPLE_STRATA_NUM;
+
+    // strata are visited in random order (Fisher-Yates shuffle)
+    for (int s = 0; s < sampler.strata_num; s++)
+        sampler.strata_order[s] = s;
+    for (int s = sampler.strata_num - 1; s > 0 && mode == SAMPLE_STRATIFIED; s--) {
+        int swap_idx = sampler_random(&sampler) % (uint64_t)(s + 1);
+        int tmp = sampler.strata_order[s];
+        sampler.strata_order[s] = sampler.strata_order[swap_idx];
+        sampler.strata_order[swap_idx] = tmp;
+    }
+
+    return sampler;
+}
+
+long next_sample_line(LineSampler *sampler, int *stratum) {
+    long begin, end;
+    int s = 0;
+
+    switch (sampler->mode) {
+    case SAMPLE_UNIFORM:
+        begin = 0;
+        end = sampler->line_num;
+        break;
+
+    case SAMPLE_STRATIFIED:
+        s = sampler->strata_order[sampler->drawn % sampler->strata_num];
+        begin = stratum_begin(sampler->line_num, sampler->strata_num, s);
+        end = stratum_begin(sampler->line_num, sampler->strata_num, s + 1);
+        break;
+
+    default:  // sequential
+        *stratum = 0;
+        return sampler->drawn++;
+    }
+
+    sampler->drawn += 1;
+    *stratum = s;
+
+    return begin + (long)(sampler_random(sampler) % (uint64_t)(end - begin));
+}
+
+long sample_subline(LineSampler sampler, long line, int subline_size, int subline_num) {
+    uint64_t hash = sampler.seed ^ ((uint64_t)line * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t)sampler.drawn << 20) ^ ((uint64_t)subline_size << 48);
+
+    if (subline_num <= 1)
+        return 0;
+
+    // stateless mix (splitmix64 finalizer) of the draw, so every sub-line size draws independently of the others
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+
+    return (long)(hash % (uint64_t)subline_num);
+}
+
+RatioEstimator make_ratio_estimator(LineSampler sampler) {
+    RatioEstimator estimator;
+    estimator.strata_num = sampler.strata_num;
+    estimator.weights = (double *)calloc(estimator.strata_num, sizeof(double));
+    estimator.counts = (long *)calloc(estimator.strata_num, sizeof(long));
+    estimator.sums = (double *)calloc(estimator.strata_num, sizeof(double));
+    estimator.sqsums = (double *)calloc(estimator.strata_num, sizeof(double));
+
+    for (int s = 0; s < estimator.strata_num; s++) {
+        estimator.weights[s] = sampler.line_num > 0 ?
+            (double)(stratum_begin(sampler.line_num, sampler.strata_num, s + 1) - stratum_begin(sampler.line_num, sampler.strata_num, s)) / sampler.line_num :
+            1.0 / estimator.strata_num;
+    }
+
+    return estimator;
+}
+
+void remove_ratio_estimator(RatioEstimator estimator) {
+    free(estimator.weights);
+    free(estimator.counts);
+    free(estimator.sums);
+    free(estimator.sqsums);
+}
+
+void add_ratio_sample(RatioEstimator *estimator, int stratum, int compressed_size) {
+    estimator->counts[stratum] += 1;
+    estimator->sums[stratum] += compressed_size;
+    estimator->sqsums[stratum] += (double)compressed_size * compressed_size;
+}
+
+double estimate_ratio(RatioEstimator estimator, int line_size, double *half_width) {
+    double mean = 0, variance = 0, covered = 0, stratum_mean, stratum_var;
+    Bool estimable = TRUE;
+
+    for (int s = 0; s < estimator.strata_num; s++) {
+        if (estimator.counts[s] < 2) {
+            estimable = FALSE;  // variance of the stratum is unknown
+            if (estimator.counts[s] == 0) continue;
+        }
+
+        stratum_mean = estimator.sums[s] / estimator.counts[s];
+        mean += estimator.weights[s] * stratum_mean;
+        covered += estimator.weights[s];
+
+        if (estimator.counts[s] >= 2) {
+            stratum_var = (estimator.sqsums[s] - estimator.counts[s] * stratum_mean * stratum_mean) / (estimator.counts[s] - 1);
+            if (stratum_var < 0) stratum_var = 0;  // rounding error
+            variance += estimator.weights[s] * estimator.weights[s] * stratum_var / estimator.counts[s];
+        }
+    }
+
+    if (mean <= 0) {
+        *half_width = INFINITY;
+        return 0;
+    }
+
+    // weights of sampled strata are renormalized (fewer samples than strata leave some strata empty)
+    mean /= covered;
+    variance /= covered * covered;
+
+    *half_width = estimable ? SAMPLE_Z95 * line_size * sqrt(variance) / (mean * mean) : INFINITY;
+    return line_size / mean;
+}
@@ -0,0 +1,43 @@
+#ifndef LINE_SAMPLING
+#define LINE_SAMPLING
+
+#include "compression.h"
+
+// Parameters for line sampling
+#define SAMPLE_SEQUENTIAL    0       // first N lines of the file (no confidence interval)
+#define SAMPLE_UNIFORM       1       // lines drawn uniformly across the whole file
+#define SAMPLE_STRATIFIED    2       // one line drawn from each stratum in turn (strata in random order)
+#define SAMPLE_DEFAULT_SEED  0x5eed
+#define SAMPLE_STRATA_NUM    64      // number of strata (equal ranges of lines)
+#define SAMPLE_MIN_NUM       128     // minimum number of samples before checking precision
+#define SAMPLE_Z95           1.96    // z-score of 95% confidence interval
+#define SAMPLE_ESTIMATOR_VERSION  3  // version of stratified estimate (increase it whenever estimates change, so cached results are recomputed)
+
+typedef struct {
+    int       mode;        // sampling mode (SAMPLE_SEQUENTIAL, SAMPLE_UNIFORM, SAMPLE_STRATIFIED)
+    long      line_num;    // number of lines in the file
+    int       strata_num;  // number of strata (1 if not stratified)
+    long      drawn;       // number of lines drawn
+    int       strata_order[SAMPLE_STRATA_NUM];  // order of strata in each turn (random permutation fixed by the seed)
+    uint64_t  seed;        // seed of the sampler
+    uint64_t  state;       // state of random number generator (xorshift64*)
+} LineSampler;
+
+typedef struct {
+    int       strata_num;  // number of strata
+    double   *weights;     // share of lines of each stratum
+    long     *counts;      // number of samples of each stratum
+    double   *sums;        // sum of compressed sizes of each stratum
+    double   *sqsums;      // sum of squared compressed sizes of each stratum
+} RatioEstimator;
+
+// Functions for line sampling
+LineSampler make_line_sampler(long line_num, int mode, uint64_t seed);                  // sampler over lines of a file
+long next_sample_line(LineSampler *sampler, int *stratum);                               // index of the next line to compress
+long sample_subline(LineSampler sampler, long line, int subline_size, int subline_num);  // sub-line of a sampled line (does not advance sampler)
+RatioEstimator make_ratio_estimator(LineSampler sampler);                                // estimator with strata of the sampler
+void remove_ratio_estimator(RatioEstimator estimator);                                   // removes estimator
+void add_ratio_sample(RatioEstimator *estimator, int stratum, int compressed_size);     // adds compressed size of a sampled line
+double estimate_ratio(RatioEstimator estimator, int line_size, double *half_width);      // compression ratio and half width of its 95% CI
+
+#endif
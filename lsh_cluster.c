@@ -0,0 +1,188 @@
+#include "lsh_cluster.h"
+
+
+/*
+ * Functions for LSH clustering compression algorithm
+ *   Near-identical lines (e.g. weights of similar filters) share high-order bytes of their elements
+ *   while low-order bytes differ. The LSH signature samples the high-order byte of every element,
+ *   so those lines fall into the same cluster. Each line is then encoded as element-wise delta
+ *   against the representative line of its cluster, compressed with BDI. Lines are encoded with
+ *   plain BDI when it is smaller or when the cluster table is full.
+ *
+ * Functions:
+ *   make_lsh_cluster_table: allocates table with 2^index_bits clusters
+ *   remove_lsh_cluster_table: removes table
+ *   lsh_cluster_table_size: storage cost of the table (representative lines)
+ *   lsh_signature: LSH signature of high-order bytes
+ *   lsh_cluster_compression: LSH clustering compression algorithm
+ *   lsh_cluster_decompression: LSH clustering decompression algorithm
+ */
+
+LshClusterTable make_lsh_cluster_table(int index_bits, int line_size) {
+    LshClusterTable table;
+    table.index_bits = index_bits;
+    table.capacity = 1 << index_bits;
+    table.cluster_num = 0;
+    table.line_size = line_size;
+    table.signatures = (uint64_t *)calloc(table.capacity * 2, sizeof(uint64_t));  // load factor is kept under 0.5
+    table.cluster_ids = (int *)calloc(table.capacity * 2, sizeof(int));
+    table.representatives = (ByteArr)calloc(table.capacity, line_size);
+    return table;
+}
+
+void remove_lsh_cluster_table(LshClusterTable table) {
+    free(table.signatures);
+    free(table.cluster_ids);
+    free(table.representatives);
+}
+
+long lsh_cluster_table_size(LshClusterTable table) {
+    return (long)table.cluster_num * table.line_size;
+}
+
+uint64_t lsh_signature(CacheLine original) {
+    MemoryChunk high_bytes = make_memory_chunk(original.size / LSH_ELEM_SIZ, 0);
+    uint64_t signature;
+
+    for (int i = 0; i < high_bytes.size; i++)
+        high_bytes.body[i] = original.body[(i + 1) * LSH_ELEM_SIZ - 1];  // high-order byte (little endian)
+
+    signature = line_hash64(high_bytes.body, high_bytes.size);
+    remove_memory_chunk(high_bytes);
+
+    return signature == 0 ? 1 : signature;  // 0 is reserved for empty slot
+}
+
+static int lsh_find_cluster(LshClusterTable *table, CacheLine original) {
+    uint64_t signature = lsh_signature(original);
+    int mask = table->capacity * 2 - 1;
+    int slot;
+
+    for (slot = signature & mask; table->signatures[slot] != 0; slot = (slot + 1) & mask) {
+        if (table->signatures[slot] == signature)
+            return table->cluster_ids[slot];
+    }
+
+    if (table->cluster_num >= table->capacity)
+        return -1;  // table is full
+
+    // the line becomes the representative of a new cluster
+    table->signatures[slot] = signature;
+    table->cluster_ids[slot] = table->cluster_num;
+    memcpy(table->representatives + (long)table->cluster_num * table->line_size, original.body, original.size);
+
+    return table->cluster_num++;
+}
+
+CompressionResult lsh_cluster_compression(LshClusterTable *table, CacheLine original) {
+    CompressionResult result, plain, clustered;
+    MetaData tag_overhead = make_memory_chunk((LSH_BDI_TAG_OFFSET + table->index_bits + 11 + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH, 0);
+    CacheLine delta;
+    ByteArr representative;
+    int cluster_id = -1;
+    uint32_t buffer, base;
+
+#ifdef VERBOSE
+    printf("Compressing with LSH clustering algorithm...\n");
+#endif
+
+    plain = bdi_compression(original);
+
+    if (original.size == table->line_size && original.size % LSH_ELEM_SIZ == 0)
+        cluster_id = lsh_find_cluster(table, original);
+
+    if (cluster_id >= 0) {
+        representative = table->representatives + (long)cluster_id * table->line_size;
+        delta = make_memory_chunk(original.size, 0);
+
+        for (int i = 0; i < original.size; i += LSH_ELEM_SIZ) {
+            memcpy(&buffer, original.body + i, LSH_ELEM_SIZ);
+            memcpy(&base, representative + i, LSH_ELEM_SIZ);
+            buffer -= base;
+            memcpy(delta.body + i, &buffer, LSH_ELEM_SIZ);
+        }
+
+        clustered = bdi_compression(delta);
+
+#ifdef VERBOSE
+        printf("cluster: %d  plain: %dBytes  clustered: %dBytes\n", cluster_id, plain.compressed.size, clustered.compressed.size);
+#endif
+
+        if (clustered.compressed.size * BYTE_BITWIDTH + table->index_bits < plain.compressed.size * BYTE_BITWIDTH) {
+            remove_compression_result(plain);
+            remove_memory_chunk(delta);
+            set_value_bitwise(tag_overhead.body, 1, 0, 1);
+            set_value_bitwise(tag_overhead.body, cluster_id, LSH_BDI_TAG_OFFSET, table->index_bits);
+            set_value_bitwise(tag_overhead.body, get_value_bitwise(clustered.tag_overhead.body, 0, 11), LSH_BDI_TAG_OFFSET + table->index_bits, 11);
+            tag_overhead.valid_bitwidth = LSH_BDI_TAG_OFFSET + table->index_bits + 11;
+            remove_memory_chunk(clustered.tag_overhead);
+
+            result.compression_type = "LSH clustering with BDI";
+            result.original = original;
+            result.compressed = clustered.compressed;
+            result.is_compressed = TRUE;
+            result.tag_overhead = tag_overhead;
+            return result;
+        }
+
+        remove_compression_result(clustered);
+        remove_memory_chunk(delta);
+    }
+
+    set_value_bitwise(tag_overhead.body, get_value_bitwise(plain.tag_overhead.body, 0, 11), LSH_BDI_TAG_OFFSET, 11);
+    tag_overhead.valid_bitwidth = LSH_BDI_TAG_OFFSET + 11;
+    remove_memory_chunk(plain.tag_overhead);
+
+    result.compression_type = "LSH clustering with BDI";
+    result.original = original;
+    result.compressed = plain.compressed;
+    result.is_compressed = plain.is_compressed;
+    result.tag_overhead = tag_overhead;
+    return result;
+}
+
+DecompressionResult lsh_cluster_decompression(LshClusterTable *table, CacheLine compressed, MetaData tag_overhead, int original_size) {
+    DecompressionResult result, bdi_result;
+    MetaData bdi_tag = make_memory_chunk(2, 0);
+    ByteArr representative;
+    Bool is_clustered = get_value_bitwise(tag_overhead.body, 0, 1);
+    int cluster_id = 0, tag_offset = LSH_BDI_TAG_OFFSET;
+    uint32_t buffer, base;
+
+#ifdef VERBOSE
+    printf("Decompressing with LSH clustering algorithm...\n");
+#endif
+
+    if (is_clustered) {
+        cluster_id = get_value_bitwise(tag_overhead.body, LSH_BDI_TAG_OFFSET, table->index_bits);
+        tag_offset += table->index_bits;
+    }
+
+    set_value_bitwise(bdi_tag.body, get_value_bitwise(tag_overhead.body, tag_offset, 11), 0, 11);
+    bdi_tag.valid_bitwidth = 11;
+
+    if (get_value_bitwise(bdi_tag.body, 0, 4) == 15) {  // not compressed with BDI
+        bdi_result.original = make_memory_chunk(original_size, 0);
+        memcpy(bdi_result.original.body, compressed.body, original_size);
+        bdi_result.is_decompressed = TRUE;
+    } else {
+        bdi_result = bdi_decompression(compressed, bdi_tag, original_size);
+    }
+    remove_memory_chunk(bdi_tag);
+
+    if (is_clustered) {
+        representative = table->representatives + (long)cluster_id * table->line_size;
+        for (int i = 0; i < original_size; i += LSH_ELEM_SIZ) {
+            memcpy(&buffer, bdi_result.original.body + i, LSH_ELEM_SIZ);
+            memcpy(&base, representative + i, LSH_ELEM_SIZ);
+            buffer += base;
+            memcpy(bdi_result.original.body + i, &buffer, LSH_ELEM_SIZ);
+        }
+    }
+
+    result.compression_type = "LSH clustering with BDI";
+    result.compressed = compressed;
+    result.original = bdi_result.original;
+    result.is_decompressed = bdi_result.is_decompressed;
+    return result;
+}
@@ -0,0 +1,34 @@
+#ifndef LSH_CLUSTER
+#define LSH_CLUSTER
+
+#include "compression.h"
+#include "line_dedup.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for LSH clustering
+#define LSH_ELEM_SIZ        WORDSIZ  // element size for signature and delta (float32, int32)
+#define LSH_DEFAULT_BITS    12       // 4096 clusters by default
+#define LSH_BDI_TAG_OFFSET  1        // tag_overhead = {clustered(1bit), cluster index, BDI tag(11bits)}
+#define LSH_MAX_BITS        20       // maximum bitwidth of cluster index (1M clusters)
+
+typedef struct {
+    uint64_t *signatures;       // open-addressing slots holding signature hashes (0: empty)
+    int      *cluster_ids;      // cluster id of each slot
+    ByteArr   representatives;  // representative line of each cluster
+    int       index_bits;       // bitwidth of cluster index
+    int       capacity;         // maximum number of clusters
+    int       cluster_num;      // number of clusters
+    int       line_size;        // size of lines in table
+} LshClusterTable;
+
+// Functions for LSH clustering compression algorithm
+LshClusterTable make_lsh_cluster_table(int index_bits, int line_size);                                                       // allocates table with 2^index_bits clusters
+void remove_lsh_cluster_table(LshClusterTable table);                                                                       // removes table
+long lsh_cluster_table_size(LshClusterTable table);                                                                         // storage cost of the table in bytes
+uint64_t lsh_signature(CacheLine original);                                                                                 // LSH signature of high-order bytes
+CompressionResult lsh_cluster_compression(LshClusterTable *table, CacheLine original);                                      // LSH clustering compression algorithm
+DecompressionResult lsh_cluster_decompression(LshClusterTable *table, CacheLine compressed, MetaData tag_overhead, int original_size);  // LSH clustering decompression algorithm
+
+#endif
@@ -27,6 +27,7 @@ class ModelExtractor(object):
         self._activation = {}  # extracted output activations
         self._hook_names = []  # name of registered hooks
         self._traces = []      # parameter traces
+        self._stream = None    # shared memory ring producer (activations are streamed instead of stored)
         self._verbose = verbose
         self.device = device   # defined target device (mainly 'cpu' or 'cuda')
 
@@ -47,6 +48,10 @@ class ModelExtractor(object):
         if trace in self._traces:
             self._traces.remove(trace)
 
+    def attach_stream(self, stream):
+        # stream: ShmRingProducer (None: store activations in memory)
+        self._stream = stream
+
     def register_hook(self, layer: torch.nn.Module, name: str=AUTO):
         if name == AUTO:
             hidx = 0
@@ -56,6 +61,9 @@ class ModelExtractor(object):
 
     def _extract_hook(self, name: str):
         def hook(model, layer_input, layer_output):
+            if self._stream is not None:
+                self._stream.write(name, layer_output)  # every batch is aggregated under the hook name
+                return
             oidx = 0
             while f"{name}_output{oidx}" in self._activation.keys(): oidx += 1
             save_output_name = f"{name}_output{oidx}"
@@ -95,7 +103,7 @@ class ModelExtractor(object):
         os.makedirs(savepath, exist_ok=True)
 
         for param_name in self._params.keys():
-            barr = self._params[param_name].detach().numpy()
+            barr = self._params[param_name].detach().cpu().numpy()  # parameters of models on GPU are copied to host
             with open(os.path.join(savepath, f"{param_name}"), 'wb') as file:
                 file.write(barr)
 
@@ -108,7 +116,7 @@ class ModelExtractor(object):
         os.makedirs(savepath, exist_ok=True)
 
         for layer_name in self._activation.keys():
-            barr = self._activation[layer_name].detach().numpy()
+            barr = self._activation[layer_name].detach().cpu().numpy()
             with open(os.path.join(savepath, f"{layer_name}"), 'wb') as file:
                 file.write(barr)
 
@@ -124,6 +132,7 @@ class QuantModelExtractor(Interpreter):
         self._params = {}      # extracted parameters
         self._activation = {}  # extracted output activations
         self._traces = []      # parameter traces
+        self._stream = None    # shared memory ring producer (activations are streamed instead of stored)
         self._verbose = verbose
         self.device = 'cpu'
 
@@ -135,19 +144,22 @@ class QuantModelExtractor(Interpreter):
         if trace in self._traces:
             self._traces.remove(trace)
 
+    def attach_stream(self, stream):
+        # stream: ShmRingProducer (None: store activations in memory)
+        self._stream = stream
+
     def call_module(self, target, *args, **kwargs):
-        for kw in self.traces:
-            if kw in target.split('.'):
-                idx = 0
-                save_output_name = f"{self.output_modelname}_{target}_output{idx}"
-                if save_output_name in self.features:
-                    idx += 1
-                    save_output_name = f"{self.output_modelname}_{target}_output{idx}"
-
-                if self._verbose:
-                    print(f'extracting {save_output_name}')
-                self.features[save_output_name] = super().call_module(target, *args, **kwargs).int_repr().detach()
-        return super().call_module(target, *args, **kwargs)
+        layer_output = super().call_module(target, *args, **kwargs)
+        if isinstance(layer_output, torch.Tensor) and layer_output.is_quantized and self._stream is not None:
+            self._stream.write(f"{self.output_modelname}_{target.replace('.', '_')}", layer_output)  # int8 representation
+        elif isinstance(layer_output, torch.Tensor) and layer_output.is_quantized:
+            oidx = 0
+            while f"{self.output_modelname}_{target.replace('.', '_')}_output{oidx}" in self._activation.keys(): oidx += 1
+            save_output_name = f"{self.output_modelname}_{target.replace('.', '_')}_output{oidx}"
+            self._activation[save_output_name] = layer_output.int_repr().detach()  # int8 representation
+            if self._verbose:
+                print(f'extracting {save_output_name}')
+        return layer_output
 
     def extract_activation(self, dataloader, max_iter=5):
         iter_cnt = 0
@@ -179,7 +191,8 @@ class QuantModelExtractor(Interpreter):
         os.makedirs(savepath, exist_ok=True)
 
         for param_name in self._params.keys():
-            barr = self._params[param_name].detach().numpy()
+            param = self._params[param_name].detach()
+            barr = (param.int_repr() if param.is_quantized else param).numpy()  # int8 representation of quantized weights
             with open(os.path.join(savepath, f"{param_name}"), 'wb') as file:
                 file.write(barr)
 
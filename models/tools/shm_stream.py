@@ -0,0 +1,149 @@
+import os
+import mmap
+import time
+import struct
+
+
+# Layout of shared memory ring buffer (must match shm_ring.h)
+RING_MAGIC = 0x31474e4952504d43  # "CMPRING1"
+RING_HEADER_SIZ = 256
+RING_MAGIC_OFFSET = 0
+RING_CAP_OFFSET = 8
+RING_CLOSED_OFFSET = 16
+RING_HEAD_OFFSET = 64
+RING_TAIL_OFFSET = 128
+RING_RECORD_SIZ = 16
+RING_ALIGN = 8
+RING_WRAP = 1
+RING_NAME_SIZ = 256
+
+
+class ShmStreamError(RuntimeError):
+    # consumer exited or stopped releasing the ring while the producer waits
+    pass
+
+
+def _aligned(size):
+    return (size + RING_ALIGN - 1) // RING_ALIGN * RING_ALIGN
+
+
+def tensor_bytes(tensor):
+    # raw bytes of a tensor (int8 representation of quantized tensors) or of any bytes-like object
+    if hasattr(tensor, 'detach'):
+        tensor = tensor.detach().cpu()
+        if tensor.is_quantized:
+            tensor = tensor.int_repr()
+        tensor = tensor.contiguous().numpy()
+    return memoryview(tensor).cast('B')
+
+
+class ShmRingProducer(object):
+    """
+    Producer of the shared memory ring buffer consumed by tb_stream
+
+    Tensors are written as records {name length, flags, payload size, name, payload} and head is
+    published after each record, so the compressor reads them while inference runs. write() waits
+    while the ring is full (backpressure). Head and tail are aligned 8Byte fields written with a
+    single store, and record bytes are written before head, which x86 keeps in order.
+
+    Tensors larger than a quarter of the ring are split into several records at multiples of
+    line_size (chunk size of tb_stream), so that lines of a split tensor are the same as lines of
+    the whole tensor (only the last line of the tensor is zero padded).
+
+    The consumer process (attach_consumer) is checked while waiting, so that write() raises instead
+    of blocking forever once the consumer has exited. stall_timeout (sec, None: no limit) bounds a
+    single wait for a consumer which is alive but stuck.
+    """
+
+    def __init__(self, path: str, line_size: int, capacity: int=64 * (1 << 20), poll_interval: float=1e-4, stall_timeout: float=None):
+        if line_size <= 0:
+            raise ValueError(f"invalid line size {line_size}")
+        self.path = path
+        self.line_size = line_size
+        self.capacity = _aligned(capacity)
+        self.poll_interval = poll_interval
+        self.stall_timeout = stall_timeout
+        self.head = 0
+        self.stall_time = 0.0  # time spent waiting for the consumer
+        self._consumer = None  # consumer process (subprocess.Popen, None: not checked)
+
+        fd = os.open(path, os.O_RDWR | os.O_CREAT | os.O_TRUNC, 0o600)
+        try:
+            os.ftruncate(fd, RING_HEADER_SIZ + self.capacity)
+            self._mm = mmap.mmap(fd, RING_HEADER_SIZ + self.capacity)
+        finally:
+            os.close(fd)
+
+        struct.pack_into('<Q', self._mm, RING_CAP_OFFSET, self.capacity)
+        struct.pack_into('<Q', self._mm, RING_CLOSED_OFFSET, 0)
+        struct.pack_into('<Q', self._mm, RING_HEAD_OFFSET, 0)
+        struct.pack_into('<Q', self._mm, RING_TAIL_OFFSET, 0)
+        struct.pack_into('<Q', self._mm, RING_MAGIC_OFFSET, RING_MAGIC)  # ring is ready
+
+    def attach_consumer(self, consumer):
+        # consumer: subprocess.Popen of tb_stream (None: consumer is not checked while waiting)
+        self._consumer = consumer
+
+    def _tail(self):
+        return struct.unpack_from('<Q', self._mm, RING_TAIL_OFFSET)[0]
+
+    def _reserve(self, size):
+        # waits until size bytes after head are released by the consumer
+        if self.head + size - self._tail() <= self.capacity:
+            return
+        start = time.perf_counter()
+        while self.head + size - self._tail() > self.capacity:
+            if self._consumer is not None and self._consumer.poll() is not None:
+                self.stall_time += time.perf_counter() - start
+                raise ShmStreamError(f"stream consumer exited (code {self._consumer.returncode}) while the ring is full")
+            if self.stall_timeout is not None and time.perf_counter() - start > self.stall_timeout:
+                self.stall_time += time.perf_counter() - start
+                raise ShmStreamError(f"stream consumer did not release the ring for {self.stall_timeout}s")
+            time.sleep(self.poll_interval)
+        self.stall_time += time.perf_counter() - start
+
+    def _write_record(self, name, payload):
+        record_size = RING_RECORD_SIZ + _aligned(len(name)) + _aligned(len(payload))
+        index = self.head % self.capacity
+        rest = self.capacity - index
+
+        if rest < record_size:  # record does not wrap around, skip the end of the data area
+            self._reserve(rest)
+            if rest >= RING_RECORD_SIZ:
+                struct.pack_into('<IIQ', self._mm, RING_HEADER_SIZ + index, 0, RING_WRAP, 0)
+            self.head += rest
+            struct.pack_into('<Q', self._mm, RING_HEAD_OFFSET, self.head)
+            index = 0
+
+        self._reserve(record_size)
+        offset = RING_HEADER_SIZ + index
+        struct.pack_into('<IIQ', self._mm, offset, len(name), 0, len(payload))
+        offset += RING_RECORD_SIZ
+        self._mm[offset:offset + len(name)] = name
+        offset += _aligned(len(name))
+        self._mm[offset:offset + len(payload)] = payload
+        self.head += record_size
+        struct.pack_into('<Q', self._mm, RING_HEAD_OFFSET, self.head)
+
+    def write(self, name: str, tensor):
+        name = name.encode()[:RING_NAME_SIZ - 1]
+        payload = tensor_bytes(tensor)
+        split = max(self.line_size, (self.capacity // 4) // self.line_size * self.line_size)  # split at line boundaries
+        if split + RING_RECORD_SIZ + _aligned(len(name)) > self.capacity:
+            raise ValueError(f"ring capacity {self.capacity}Bytes is too small")
+
+        for start in range(0, max(len(payload), 1), split):
+            self._write_record(name, payload[start:start + split])
+
+    def close(self):
+        if self._mm is None:
+            return
+        struct.pack_into('<Q', self._mm, RING_CLOSED_OFFSET, 1)
+        self._mm.close()
+        self._mm = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
@@ -1,7 +1,9 @@
+import os
 import sys
 import torch
 import torch.distributed as dist
 from models.tools.progressbar import progressbar
+from models.tools.extractor import ModelExtractor, weight_trace
 
 
 # device = "cuda" if torch.cuda.is_available() else "cpu"
@@ -109,4 +111,26 @@ def test(dataloader, model, loss_fn, verbose=1, savelog_path=None, device='auto'
         with open(savelog_path, 'at') as logfile:
             logfile.write(f"Accuracy: {(100*correct):>0.1f}%, Avg loss: {test_loss:>8f}\n")
 
-    return 100 * correct, test_loss
\ No newline at end of file
+    return 100 * correct, test_loss
+
+
+def save_checkpoint(model, epoch, savepath, modelname='model', traces=(weight_trace,)):
+    # dumps parameters of the epoch into savepath/epoch<N> and appends its filelist to savepath/checkpoints.txt
+    # (checkpoint list of tb_checkpoint, which tracks compressibility over epochs)
+    # checkpoints of this epoch and later ones in the list are from an earlier run, so a rerun truncates the list
+    extractor = ModelExtractor(model, output_modelname=modelname)
+    for trace in traces:
+        extractor.add_param_trace(trace)
+    extractor.extract_params()
+
+    epoch_path = os.path.join(savepath, f"epoch{epoch:03d}")
+    extractor.save_params(savepath=epoch_path)
+
+    listpath = os.path.join(savepath, 'checkpoints.txt')
+    earlier = []
+    if os.path.exists(listpath):
+        with open(listpath, 'rt') as checkpoints:
+            earlier = [line.rstrip('\n') for line in checkpoints
+                       if line.strip() and int(os.path.basename(os.path.dirname(line.strip()))[len('epoch'):]) < epoch]
+    with open(listpath, 'wt') as checkpoints:
+        checkpoints.write(''.join(line + '\n' for line in earlier + [os.path.join(epoch_path, 'filelist.txt')]))
@@ -1,5 +1,55 @@
 #include "original_bdi_compression.h"
 
+
+/*
+ * Functions for original BDI algorithm (reference)
+ *   Compressed size of the original BDI proposal: zeros (1Byte), repeated 8/4Bytes values, and
+ *   base+delta with an implicit zero base and one explicit base (base8-delta1/2/4, base4-delta1/2,
+ *   base2-delta1). Only sizes are computed, the algorithm is used as a reference of bdi_compression.
+ *
+ *   Sizes of every configuration are computed in a single pass over the line without allocation:
+ *   each 8Bytes value is split into 4Bytes and 2Bytes values (little endian, in the order of the
+ *   line), and every value is fed to the state of each configuration. The explicit base is the
+ *   first value out of delta range of zero, so the values before it are always covered by the zero
+ *   base and a single pass finds the same base as multBaseCompression.
+ *
+ * Functions:
+ *   bdi_original_sizes: compressed size of every configuration (BDI_ORIGINAL_CONFIG_NUM sizes)
+ *   bdi_original_compression: smallest compressed size of all configurations
+ *   bdi_original_result: compression result of bdi_original_compression (for testbenches)
+ *   multBaseCompression: size of a single configuration over value array
+ *
+ * Note
+ *   4Bytes and 2Bytes values are not sign extended (as convertBuffer2Array), and configurations
+ *   not applicable to the line have the size of the line
+ */
+
+typedef struct {
+    unsigned long long limit;  // delta range
+    ValueBuffer base;          // explicit base (first value out of delta range of zero)
+    Bool has_base;             // whether explicit base is found
+    Bool fits;                 // whether every value is covered by zero or explicit base
+} BdiOriginalState;
+
+static inline unsigned long long bdi_original_distance(ValueBuffer a, ValueBuffer b) {
+    return my_llabs((long long)((uint64_t)a - (uint64_t)b));
+}
+
+static inline void bdi_original_feed(BdiOriginalState *state, ValueBuffer value) {
+    if (!state->fits || bdi_original_distance(0, value) <= state->limit)
+        return;
+    if (!state->has_base) {
+        state->base = value;
+        state->has_base = TRUE;
+    } else if (bdi_original_distance(state->base, value) > state->limit) {
+        state->fits = FALSE;
+    }
+}
+
+static inline unsigned bdi_original_state_size(BdiOriginalState state, unsigned value_num, unsigned blimit, unsigned bsize) {
+    return state.fits ? blimit * value_num + bsize * 2 : value_num * bsize;
+}
+
 unsigned long long my_llabs(long long x) {
    unsigned long long t = x >> 63;
    return (x ^ t) - t;
@@ -12,13 +62,13 @@ unsigned my_abs(int x) {
 
 BufferArr convertBuffer2Array(ByteArr arr, unsigned size, unsigned step) {
     BufferArr values = (BufferArr)malloc(sizeof(ValueBuffer) * (size / step));
-    
-    for (int i = 0; i < size / step; i++) {
+
+    for (unsigned i = 0; i < size / step; i++) {
         values[i] = 0;    // Initialize all elements to zero.
     }
 
-    for (int i = 0; i < size; i += step) {
-        for (int j = 0; j < step; j++) {
+    for (unsigned i = 0; i < size; i += step) {
+        for (unsigned j = 0; j < step; j++) {
             values[i / step] += (ValueBuffer)((Byte)arr[i + j]) << (BYTE_BITWIDTH * j);
         }
     }
@@ -29,7 +79,7 @@ BufferArr convertBuffer2Array(ByteArr arr, unsigned size, unsigned step) {
 Bool isZeroPackable(BufferArr values, unsigned size) {
     int is_packable = TRUE;
 
-    for (int i = 0; i < size; i++) {
+    for (unsigned i = 0; i < size; i++) {
         if( values[i] != 0){
             is_packable = FALSE;
             break;
@@ -42,7 +92,7 @@ Bool isZeroPackable(BufferArr values, unsigned size) {
 Bool isSameValuePackable(BufferArr values, unsigned size) {
     int is_packable = TRUE;
 
-    for (int i = 0; i < size; i++) {
+    for (unsigned i = 0; i < size; i++) {
         if( values[0] != values[i]){
             is_packable = FALSE;
             break;
@@ -53,96 +103,128 @@ Bool isSameValuePackable(BufferArr values, unsigned size) {
 }
 
 unsigned multBaseCompression (BufferArr values, unsigned size, unsigned blimit, unsigned bsize) {
-    unsigned long long limit = 0;
-    unsigned BASES = 2;
+    BdiOriginalState state;
 
     //define the appropriate size for the mask
     switch(blimit){
         case 1:
-            limit = 0xFF;
+            state.limit = 0xFF;
             break;
         case 2:
-            limit = 0xFFFF;
+            state.limit = 0xFFFF;
             break;
         case 4:
-            limit = 0xFFFFFFFF;
+            state.limit = 0xFFFFFFFF;
             break;
         default:
-            limit = 0xff;
+            state.limit = 0xff;
     }
 
-    // finding bases: # BASES
-    ValueBuffer mbases[64];
-    unsigned baseCount = 1;
-    mbases[0] = 0;
+    state.base = 0;
+    state.has_base = FALSE;
+    state.fits = TRUE;
 
-    for (int i = 0; i < size; i++) {
-        for(int j = 0; j <  baseCount; j++){
-            if (my_llabs((long long int)(mbases[j] - values[i])) > limit) {
-                mbases[baseCount++] = values[i];  
-            }
-        }
+    for (unsigned i = 0; i < size && state.fits; i++)
+        bdi_original_feed(&state, values[i]);
 
-        if (baseCount >= BASES)
-            break;
+    return bdi_original_state_size(state, size, blimit, bsize);
+}
+
+void bdi_original_sizes(CacheLine original, unsigned *sizes) {
+    static const unsigned long long limits[3] = {0xFF, 0xFFFF, 0xFFFFFFFF};
+    BdiOriginalState b8[3], b4[2], b2;
+    unsigned n8 = original.size / 8, n4 = original.size / 4, n2 = original.size / 2;
+    Bool is_zero = TRUE, same8 = TRUE, same4 = TRUE;
+    ValueBuffer first8 = 0, first4 = 0, value;
+    uint64_t word;
+    uint32_t word4;
+    uint16_t word2;
+    unsigned i;
+
+    for (int j = 0; j < 3; j++) {
+        b8[j].limit = limits[j];
+        b8[j].base = 0;
+        b8[j].has_base = FALSE;
+        b8[j].fits = TRUE;
+        if (j < 2) b4[j] = b8[j];
     }
+    b2 = b8[0];
 
-    // find how many elements can be compressed with mbases
-    unsigned compCount = 0;
-    for (int i = 0; i < size; i++) {
-        //ol covered = 0;
-        for(int j = 0; j <  baseCount; j++){
-            if( my_llabs((long long int)(mbases[j] -  values[i])) <= limit ){
-                compCount++;
-                break;
-            }
+    if (n8 > 0) memcpy(&first8, original.body, 8);
+    if (n4 > 0) {
+        memcpy(&word4, original.body, 4);
+        first4 = word4;
+    }
+
+    // 1. 8Bytes words (with their 4Bytes and 2Bytes values)
+    for (i = 0; i < n8; i++) {
+        memcpy(&word, original.body + i * 8, 8);
+        value = (ValueBuffer)word;
+
+        is_zero &= word == 0;
+        same8 &= value == first8;
+        for (int j = 0; j < 3; j++)
+            bdi_original_feed(&b8[j], value);
+
+        for (int h = 0; h < 2; h++) {
+            value = (ValueBuffer)((word >> (32 * h)) & 0xFFFFFFFFULL);
+            same4 &= value == first4;
+            bdi_original_feed(&b4[0], value);
+            bdi_original_feed(&b4[1], value);
         }
+
+        for (int q = 0; q < 4; q++)
+            bdi_original_feed(&b2, (ValueBuffer)((word >> (16 * q)) & 0xFFFFULL));
     }
-    
-    unsigned mCompSize = blimit * compCount + bsize * BASES + (size - compCount) * bsize;
-    if(compCount < size)
-        return size * bsize;
-    return mCompSize;
+
+    // 2. 4Bytes and 2Bytes values after the last 8Bytes word
+    for (unsigned j = i * 2; j < n4; j++) {
+        memcpy(&word4, original.body + j * 4, 4);
+        same4 &= (ValueBuffer)word4 == first4;
+        bdi_original_feed(&b4[0], (ValueBuffer)word4);
+        bdi_original_feed(&b4[1], (ValueBuffer)word4);
+    }
+    for (unsigned j = i * 4; j < n2; j++) {
+        memcpy(&word2, original.body + j * 2, 2);
+        bdi_original_feed(&b2, (ValueBuffer)word2);
+    }
+
+    sizes[BDI_ORIGINAL_ZEROS]    = is_zero ? 1 : original.size;
+    sizes[BDI_ORIGINAL_REP8]     = same8 ? 8 : original.size;
+    sizes[BDI_ORIGINAL_B8D1]     = bdi_original_state_size(b8[0], n8, 1, 8);
+    sizes[BDI_ORIGINAL_B8D2]     = bdi_original_state_size(b8[1], n8, 2, 8);
+    sizes[BDI_ORIGINAL_B8D4]     = bdi_original_state_size(b8[2], n8, 4, 8);
+    sizes[BDI_ORIGINAL_REP4]     = same4 ? 4 : original.size;
+    sizes[BDI_ORIGINAL_B4D1]     = bdi_original_state_size(b4[0], n4, 1, 4);
+    sizes[BDI_ORIGINAL_B4D2]     = bdi_original_state_size(b4[1], n4, 2, 4);
+    sizes[BDI_ORIGINAL_B2D1]     = bdi_original_state_size(b2, n2, 1, 2);
 }
 
 unsigned bdi_original_compression(CacheLine original) {
-    BufferArr values;
+    unsigned sizes[BDI_ORIGINAL_CONFIG_NUM];
     unsigned bestCSize = original.size;
-    unsigned currCSize = original.size;
-
-    // Base8 compressions including zero packing and repeating values
-    values = convertBuffer2Array(original.body, original.size, 8);
-
-    if (isZeroPackable(values, original.size / 8))
-        bestCSize = 1;
-    if (isSameValuePackable(values, original.size / 8))
-        currCSize = 8;
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-
-    currCSize = multBaseCompression(values, original.size / 8, 1, 8);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    currCSize = multBaseCompression(values, original.size / 8, 2, 8);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    currCSize =  multBaseCompression(values, original.size / 8, 4, 8);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    free(values);
-
-    // Base4 compression including repeated values
-    values = convertBuffer2Array(original.body, original.size, 4);
-    if( isSameValuePackable(values, original.size / 4))
-        currCSize = 4;
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    currCSize = multBaseCompression(values, original.size / 4, 1, 4);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    currCSize = multBaseCompression(values, original.size / 4, 2, 4);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    free(values);
-
-    // Base2 compression including repeated values
-    values = convertBuffer2Array(original.body, original.size, 2);
-    currCSize = multBaseCompression(values, original.size / 2, 1, 2);
-    bestCSize = bestCSize > currCSize ? currCSize: bestCSize;
-    free(values);
+
+    bdi_original_sizes(original, sizes);
+    for (unsigned i = 0; i < BDI_ORIGINAL_CONFIG_NUM; i++)
+        bestCSize = bestCSize > sizes[i] ? sizes[i] : bestCSize;
 
     return bestCSize;
 }
+
+CompressionResult bdi_original_result(CacheLine original) {
+    CompressionResult result;
+    unsigned size = bdi_original_compression(original);
+
+    result.compression_type = "BDI (original)";
+    result.original = original;
+    result.compressed = make_memory_chunk(size, 0);  // only size is meaningful
+    result.is_compressed = size < (unsigned)original.size;
+    result.tag_overhead = make_memory_chunk(1, 0);
+    result.tag_overhead.valid_bitwidth = 0;
+
+#ifdef VERBOSE
+    printf("original BDI size: %uBytes\n", size);
+#endif
+
+    return result;
+}
@@ -4,7 +4,19 @@
 #include "compression.h"
 
 // Verbose parameter
-#define VERBOSE  // Comment this line not to display debug messages
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Configurations of original BDI algorithm (index of bdi_original_sizes)
+#define BDI_ORIGINAL_CONFIG_NUM  9
+#define BDI_ORIGINAL_ZEROS       0  // all zeros (1Byte)
+#define BDI_ORIGINAL_REP8        1  // repeated 8Bytes value
+#define BDI_ORIGINAL_B8D1        2  // base 8Bytes, delta 1Byte
+#define BDI_ORIGINAL_B8D2        3  // base 8Bytes, delta 2Bytes
+#define BDI_ORIGINAL_B8D4        4  // base 8Bytes, delta 4Bytes
+#define BDI_ORIGINAL_REP4        5  // repeated 4Bytes value
+#define BDI_ORIGINAL_B4D1        6  // base 4Bytes, delta 1Byte
+#define BDI_ORIGINAL_B4D2        7  // base 4Bytes, delta 2Bytes
+#define BDI_ORIGINAL_B2D1        8  // base 2Bytes, delta 1Byte
 
 typedef ValueBuffer* BufferArr;
 
@@ -16,6 +28,8 @@ Bool isZeroPackable(BufferArr values, unsigned size);
 Bool isSameValuePackable(BufferArr values, unsigned size);
 unsigned multBaseCompression (BufferArr values, unsigned size, unsigned blimit, unsigned bsize);
 
-unsigned bdi_original_compression(CacheLine original);  // original BDI compression algorithm just showing compressed size
+void bdi_original_sizes(CacheLine original, unsigned *sizes);  // compressed size of every configuration in a single pass (no allocation)
+unsigned bdi_original_compression(CacheLine original);         // original BDI compression algorithm just showing compressed size
+CompressionResult bdi_original_result(CacheLine original);     // original BDI as compression result (compressed chunk only has the size)
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,377 @@
+#include "page_store.h"
+
+#include <string.h>
+
+
+/*
+ * Functions for compressed page store
+ *   Pages (4KB) are stored in RAM in compressed form as a software memory tier (as zswap), with
+ *   any line compression algorithm which has a decompression function. A page is compressed line
+ *   by line into a compressed page: each line is {payload size (2B), tag bitwidth (2B), tag,
+ *   payload}, and lines whose tag and payload are not smaller than the line (algorithms may report
+ *   a line as compressed when only the payload is smaller) are stored as they are
+ *   (PAGE_STORE_RAW_TAG), so that a compressed page is never larger than its blob buffer.
+ *   Pages whose compressed page is not smaller than the page are stored as they are.
+ *
+ *   Compressed pages are kept in objects of size classes (multiples of PAGE_STORE_CLASS_STEP), and
+ *   objects of a class are carved from slabs, so that pages of different sizes do not fragment the
+ *   pool. A slab is released when its last object is freed, so memory moves between classes as
+ *   the sizes of pages change. Pages are referred to with handles (index of the handle table).
+ *
+ *   The store is split into shards, each with its own lock, size classes and handle table, so that
+ *   threads storing and loading pages do not contend on a single lock. Pages are assigned to
+ *   shards in round robin, and the shard is encoded in the handle. Compression and decompression
+ *   are done outside of the lock. The size of slabs of all shards is limited by the capacity, and
+ *   a page is not stored when the pool is full (the caller evicts pages and retries). Before that,
+ *   a free object of a larger class is used, as freed objects of other classes may not release
+ *   their slabs.
+ *
+ * Functions:
+ *   make_page_store: empty store (capacity: maximum size of slabs, 0: unlimited)
+ *   remove_page_store: removes store and its slabs
+ *   page_store_store: compresses and stores a page (PAGE_STORE_NO_HANDLE if the pool is full)
+ *   page_store_load: decompresses a stored page (FALSE if the handle is not valid)
+ *   page_store_evict: removes a stored page
+ *   page_store_stats: statistics on pool density
+ *
+ * Note
+ *   Page size must be a multiple of the line size. Buffers of compressed pages have a line of
+ *   margin, as decompression algorithms may read whole words after the end of the tag or payload
+ */
+
+#define PAGE_STORE_SHARD(store, handle) (&(store)->shards[(handle) % (store)->shard_num])
+#define PAGE_STORE_INDEX(store, handle) ((handle) / (store)->shard_num)
+
+static int page_store_compress(PageStore *store, ByteArr page, ByteArr blob) {
+    CompressionResult result;
+    CacheLine line;
+    uint16_t header[2];  // payload size, tag bitwidth
+    int cursor = 0, tag_bytes;
+
+    line.size = store->line_size;
+    line.valid_bitwidth = store->line_size * BYTE_BITWIDTH;
+
+    for (int offset = 0; offset < store->page_size; offset += store->line_size) {
+        line.body = page + offset;
+        result = store->comp_func(line);
+        tag_bytes = (result.tag_overhead.valid_bitwidth + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+
+        // lines are stored as they are unless tag and payload are smaller than the line
+        if (result.is_compressed && tag_bytes + result.compressed.size < store->line_size) {
+            header[0] = (uint16_t)result.compressed.size;
+            header[1] = (uint16_t)result.tag_overhead.valid_bitwidth;
+            memcpy(blob + cursor, header, PAGE_STORE_LINE_HEADER);
+            memcpy(blob + cursor + PAGE_STORE_LINE_HEADER, result.tag_overhead.body, tag_bytes);
+            memcpy(blob + cursor + PAGE_STORE_LINE_HEADER + tag_bytes, result.compressed.body, result.compressed.size);
+            cursor += PAGE_STORE_LINE_HEADER + tag_bytes + result.compressed.size;
+        } else {
+            header[0] = (uint16_t)store->line_size;
+            header[1] = PAGE_STORE_RAW_TAG;
+            memcpy(blob + cursor, header, PAGE_STORE_LINE_HEADER);
+            memcpy(blob + cursor + PAGE_STORE_LINE_HEADER, line.body, store->line_size);
+            cursor += PAGE_STORE_LINE_HEADER + store->line_size;
+        }
+        remove_compression_result(result);
+    }
+
+    return cursor;
+}
+
+static Bool page_store_decompress(PageStore *store, ByteArr blob, ByteArr page) {
+    DecompressionResult result;
+    CacheLine compressed;
+    MetaData tag_overhead;
+    uint16_t header[2];  // payload size, tag bitwidth
+    int cursor = 0, tag_bits, payload_size;
+    Bool restored = TRUE;
+
+    for (int offset = 0; offset < store->page_size && restored; offset += store->line_size) {
+        memcpy(header, blob + cursor, PAGE_STORE_LINE_HEADER);
+        payload_size = header[0];
+        tag_bits = header[1];
+        cursor += PAGE_STORE_LINE_HEADER;
+
+        if (tag_bits == PAGE_STORE_RAW_TAG) {
+            memcpy(page + offset, blob + cursor, store->line_size);
+            cursor += store->line_size;
+            continue;
+        }
+
+        tag_overhead.size = (tag_bits + BYTE_BITWIDTH - 1) / BYTE_BITWIDTH;
+        tag_overhead.valid_bitwidth = tag_bits;
+        tag_overhead.body = blob + cursor;
+        compressed.size = payload_size;
+        compressed.valid_bitwidth = payload_size * BYTE_BITWIDTH;
+        compressed.body = blob + cursor + tag_overhead.size;
+        cursor += tag_overhead.size + payload_size;
+
+        result = store->decomp_func(compressed, tag_overhead, store->line_size);
+        restored = result.is_decompressed;
+        if (restored)
+            memcpy(page + offset, result.original.body, store->line_size);
+        remove_memory_chunk(result.original);
+    }
+
+    return restored;
+}
+
+static PageSlab *page_store_make_slab(PageStore *store, PageSizeClass *size_class) {
+    PageSlab *slab;
+
+    // pool is full if the slab does not fit in the capacity
+    if (__atomic_add_fetch(&store->pool_bytes, size_class->slab_size, __ATOMIC_RELAXED) > store->capacity && store->capacity > 0) {
+        __atomic_sub_fetch(&store->pool_bytes, size_class->slab_size, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    slab = (PageSlab *)malloc(sizeof(PageSlab));
+    slab->object_num = size_class->slab_size / size_class->object_size;
+    slab->body = (ByteArr)malloc(size_class->slab_size);
+    slab->free_objects = (int *)malloc(sizeof(int) * slab->object_num);
+    for (int i = 0; i < slab->object_num; i++)
+        slab->free_objects[i] = slab->object_num - 1 - i;  // objects are used from the beginning of the slab
+    slab->free_num = slab->object_num;
+    slab->used_num = 0;
+    slab->partial = FALSE;
+
+#ifdef VERBOSE
+    printf("slab of %dBytes objects allocated (pool: %ldBytes)\n", size_class->object_size, store->pool_bytes);
+#endif
+
+    return slab;
+}
+
+static void page_store_push_partial(PageSizeClass *size_class, PageSlab *slab) {
+    if (size_class->partial_num >= size_class->partial_cap) {
+        size_class->partial_cap = size_class->partial_cap == 0 ? 16 : size_class->partial_cap * 2;
+        size_class->partial = (PageSlab **)realloc(size_class->partial, sizeof(PageSlab *) * size_class->partial_cap);
+    }
+    size_class->partial[size_class->partial_num++] = slab;
+    slab->partial = TRUE;
+}
+
+static void page_store_free_object(PageStore *store, PageSizeClass *size_class, PageSlab *slab, int object_idx) {
+    slab->free_objects[slab->free_num++] = object_idx;
+    slab->used_num -= 1;
+    if (!slab->partial)
+        page_store_push_partial(size_class, slab);
+
+    if (slab->used_num > 0)
+        return;
+
+    // empty slab is released (memory goes back to the pool for any class)
+    for (int i = 0; i < size_class->partial_num; i++) {
+        if (size_class->partial[i] == slab) {
+            size_class->partial[i] = size_class->partial[--size_class->partial_num];
+            break;
+        }
+    }
+    __atomic_sub_fetch(&store->pool_bytes, size_class->slab_size, __ATOMIC_RELAXED);
+    free(slab->free_objects);
+    free(slab->body);
+    free(slab);
+}
+
+PageStore *make_page_store(CompressionResult (*comp_func)(CacheLine), DecompressionResult (*decomp_func)(CacheLine, MetaData, int),
+                           int page_size, int line_size, int shard_num, long capacity) {
+    PageStore *store = (PageStore *)calloc(1, sizeof(PageStore));
+    PageShard *shard;
+    PageSizeClass *size_class;
+
+    store->comp_func = comp_func;
+    store->decomp_func = decomp_func;
+    store->page_size = page_size;
+    store->line_size = line_size;
+    store->blob_size = (page_size / line_size) * (PAGE_STORE_LINE_HEADER + line_size) + line_size;  // every line stored as it is (and margin)
+    store->shard_num = shard_num > 0 ? shard_num : PAGE_STORE_DEFAULT_SHARDS;
+    store->class_num = (page_size + PAGE_STORE_CLASS_STEP - 1) / PAGE_STORE_CLASS_STEP;
+    store->capacity = capacity;
+    store->shards = (PageShard *)calloc(store->shard_num, sizeof(PageShard));
+
+    for (int s = 0; s < store->shard_num; s++) {
+        shard = &store->shards[s];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->classes = (PageSizeClass *)calloc(store->class_num, sizeof(PageSizeClass));
+        for (int c = 0; c < store->class_num; c++) {
+            size_class = &shard->classes[c];
+            size_class->object_size = (c + 1) * PAGE_STORE_CLASS_STEP;
+            if (size_class->object_size > page_size)
+                size_class->object_size = page_size;  // largest class holds pages stored as they are
+            size_class->slab_size = size_class->object_size < PAGE_STORE_SLAB_SIZ ?
+                                    PAGE_STORE_SLAB_SIZ / size_class->object_size * size_class->object_size : size_class->object_size;
+        }
+    }
+
+    return store;
+}
+
+void remove_page_store(PageStore *store) {
+    PageShard *shard;
+    PageEntry *entry;
+
+    for (int s = 0; s < store->shard_num; s++) {
+        shard = &store->shards[s];
+        for (long i = 0; i < shard->entry_num; i++) {
+            entry = &shard->entries[i];
+            if (entry->slab != NULL)
+                page_store_free_object(store, &shard->classes[entry->size_class], entry->slab, entry->object_idx);
+        }
+        for (int c = 0; c < store->class_num; c++)
+            free(shard->classes[c].partial);
+        free(shard->classes);
+        free(shard->entries);
+        free(shard->free_handles);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    free(store->shards);
+    free(store);
+}
+
+PageHandle page_store_store(PageStore *store, ByteArr page) {
+    ByteArr blob = (ByteArr)malloc(store->blob_size);
+    PageShard *shard;
+    PageSizeClass *size_class;
+    PageSlab *slab;
+    PageEntry entry;
+    long index;
+    int shard_idx;
+
+    // 1. Compress page (outside of the lock)
+    entry.size = page_store_compress(store, page, blob);
+    entry.raw = entry.size >= store->page_size;
+    if (entry.raw) {
+        entry.size = store->page_size;
+        memcpy(blob, page, store->page_size);
+    }
+    entry.size_class = (entry.size + PAGE_STORE_CLASS_STEP - 1) / PAGE_STORE_CLASS_STEP - 1;
+
+    shard_idx = __atomic_fetch_add(&store->next_shard, 1, __ATOMIC_RELAXED) % store->shard_num;
+    shard = &store->shards[shard_idx];
+    size_class = &shard->classes[entry.size_class];
+
+    pthread_mutex_lock(&shard->lock);
+
+    // 2. Allocate object from a partial slab (or a new slab, or a free object of a larger class if the pool is full)
+    if (size_class->partial_num == 0) {
+        slab = page_store_make_slab(store, size_class);
+        if (slab != NULL) {
+            page_store_push_partial(size_class, slab);
+        } else {
+            while (size_class->partial_num == 0 && entry.size_class < store->class_num - 1)
+                size_class = &shard->classes[++entry.size_class];
+            if (size_class->partial_num == 0) {  // pool is full
+                pthread_mutex_unlock(&shard->lock);
+                free(blob);
+                return PAGE_STORE_NO_HANDLE;
+            }
+        }
+    }
+    slab = size_class->partial[size_class->partial_num - 1];
+    entry.slab = slab;
+    entry.object_idx = slab->free_objects[--slab->free_num];
+    slab->used_num += 1;
+    if (slab->free_num == 0) {
+        size_class->partial_num -= 1;
+        slab->partial = FALSE;
+    }
+    memcpy(slab->body + (long)entry.object_idx * size_class->object_size, blob, entry.size);
+
+    // 3. Register handle
+    if (shard->free_handle_num > 0) {
+        index = shard->free_handles[--shard->free_handle_num];
+    } else {
+        if (shard->entry_num >= shard->entry_cap) {
+            shard->entry_cap = shard->entry_cap == 0 ? 1024 : shard->entry_cap * 2;
+            shard->entries = (PageEntry *)realloc(shard->entries, sizeof(PageEntry) * shard->entry_cap);
+            shard->free_handles = (long *)realloc(shard->free_handles, sizeof(long) * shard->entry_cap);
+        }
+        index = shard->entry_num++;
+    }
+    shard->entries[index] = entry;
+
+    shard->stored_pages += 1;
+    shard->compressed_bytes += entry.size;
+    shard->object_bytes += size_class->object_size;
+    shard->raw_pages += entry.raw;
+
+    pthread_mutex_unlock(&shard->lock);
+
+    free(blob);
+    return index * store->shard_num + shard_idx;
+}
+
+Bool page_store_load(PageStore *store, PageHandle handle, ByteArr page) {
+    ByteArr blob;
+    PageShard *shard;
+    PageEntry entry;
+    Bool restored;
+
+    if (handle < 0)
+        return FALSE;
+    shard = PAGE_STORE_SHARD(store, handle);
+    blob = (ByteArr)malloc(store->blob_size);
+
+    // compressed page is copied out, so that decompression does not hold the lock
+    pthread_mutex_lock(&shard->lock);
+    if (PAGE_STORE_INDEX(store, handle) >= shard->entry_num || shard->entries[PAGE_STORE_INDEX(store, handle)].slab == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        free(blob);
+        return FALSE;
+    }
+    entry = shard->entries[PAGE_STORE_INDEX(store, handle)];
+    memcpy(blob, entry.slab->body + (long)entry.object_idx * shard->classes[entry.size_class].object_size, entry.size);
+    pthread_mutex_unlock(&shard->lock);
+
+    if (entry.raw) {
+        memcpy(page, blob, store->page_size);
+        restored = TRUE;
+    } else {
+        restored = page_store_decompress(store, blob, page);
+    }
+
+    free(blob);
+    return restored;
+}
+
+void page_store_evict(PageStore *store, PageHandle handle) {
+    PageShard *shard;
+    PageEntry *entry;
+
+    if (handle < 0)
+        return;
+    shard = PAGE_STORE_SHARD(store, handle);
+
+    pthread_mutex_lock(&shard->lock);
+    if (PAGE_STORE_INDEX(store, handle) < shard->entry_num && shard->entries[PAGE_STORE_INDEX(store, handle)].slab != NULL) {
+        entry = &shard->entries[PAGE_STORE_INDEX(store, handle)];
+        shard->stored_pages -= 1;
+        shard->compressed_bytes -= entry->size;
+        shard->object_bytes -= shard->classes[entry->size_class].object_size;
+        shard->raw_pages -= entry->raw;
+
+        page_store_free_object(store, &shard->classes[entry->size_class], entry->slab, entry->object_idx);
+        entry->slab = NULL;
+        shard->free_handles[shard->free_handle_num++] = PAGE_STORE_INDEX(store, handle);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+PageStoreStats page_store_stats(PageStore *store) {
+    PageStoreStats stats;
+    PageShard *shard;
+
+    memset(&stats, 0, sizeof(stats));
+    for (int s = 0; s < store->shard_num; s++) {
+        shard = &store->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        stats.stored_pages += shard->stored_pages;
+        stats.compressed_bytes += shard->compressed_bytes;
+        stats.object_bytes += shard->object_bytes;
+        stats.raw_pages += shard->raw_pages;
+        pthread_mutex_unlock(&shard->lock);
+    }
+    stats.original_bytes = stats.stored_pages * store->page_size;
+    stats.pool_bytes = __atomic_load_n(&store->pool_bytes, __ATOMIC_RELAXED);
+
+    return stats;
+}
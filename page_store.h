@@ -0,0 +1,93 @@
+#ifndef PAGE_STORE
+#define PAGE_STORE
+
+#include <pthread.h>
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for compressed page store
+#define PAGE_STORE_DEFAULT_PAGE    4096       // size of pages
+#define PAGE_STORE_DEFAULT_SHARDS  16         // number of shards (each with its own lock)
+#define PAGE_STORE_CLASS_STEP      64         // object sizes of size classes are multiples of it
+#define PAGE_STORE_SLAB_SIZ        (1 << 14)  // slab size (objects of a size class are carved from slabs of 4 pages)
+#define PAGE_STORE_LINE_HEADER     4          // header of each line in a compressed page: payload size (2B), tag bitwidth (2B)
+#define PAGE_STORE_RAW_TAG         0xffff     // tag bitwidth of lines stored as they are
+#define PAGE_STORE_NO_HANDLE       -1L        // page is not stored (pool is full)
+
+typedef long PageHandle;
+
+typedef struct {
+    ByteArr   body;         // objects of the slab
+    int       object_num;   // number of objects
+    int       used_num;     // number of used objects
+    int      *free_objects; // stack of free object indices
+    int       free_num;
+    Bool      partial;      // whether the slab is in the partial list of its class
+} PageSlab;
+
+typedef struct {
+    int        object_size;  // size of objects
+    int        slab_size;    // size of slabs
+    PageSlab **partial;      // slabs with free objects (stack)
+    int        partial_num;
+    int        partial_cap;
+} PageSizeClass;
+
+typedef struct {
+    PageSlab *slab;          // slab of the object (NULL: handle is free)
+    int       object_idx;    // index of the object in the slab
+    int       size;          // size of the compressed page
+    int       size_class;    // size class of the object
+    Bool      raw;           // page is stored as it is (not smaller when compressed)
+} PageEntry;
+
+typedef struct {
+    pthread_mutex_t  lock;
+    PageSizeClass   *classes;          // size classes of the shard
+    PageEntry       *entries;          // handle table of the shard
+    long             entry_num;
+    long             entry_cap;
+    long            *free_handles;     // stack of free entries
+    long             free_handle_num;
+    long             stored_pages;     // number of stored pages
+    long             compressed_bytes; // total size of compressed pages
+    long             object_bytes;     // total size of objects holding the pages
+    long             raw_pages;        // pages stored as they are
+} PageShard;
+
+typedef struct {
+    CompressionResult (*comp_func)(CacheLine);                      // line compression algorithm
+    DecompressionResult (*decomp_func)(CacheLine, MetaData, int);   // line decompression algorithm
+    int         page_size;     // size of pages
+    int         line_size;     // size of lines compressed by the algorithm
+    int         blob_size;     // maximum size of a compressed page (buffer size)
+    int         shard_num;     // number of shards
+    int         class_num;     // number of size classes
+    long        capacity;      // maximum size of slabs (0: unlimited)
+    long        pool_bytes;    // size of slabs of all shards (atomic)
+    unsigned    next_shard;    // shard of the next page (atomic, round robin)
+    PageShard  *shards;
+} PageStore;
+
+typedef struct {
+    long     stored_pages;      // number of stored pages
+    long     original_bytes;    // total size of stored pages
+    long     compressed_bytes;  // total size of compressed pages
+    long     object_bytes;      // total size of objects (rounded up to size classes)
+    long     pool_bytes;        // total size of slabs
+    long     raw_pages;         // pages stored as they are
+} PageStoreStats;
+
+// Functions for compressed page store (zswap-style memory tier over line compression algorithms)
+PageStore *make_page_store(CompressionResult (*comp_func)(CacheLine), DecompressionResult (*decomp_func)(CacheLine, MetaData, int),
+                           int page_size, int line_size, int shard_num, long capacity);   // empty store (capacity: maximum size of slabs, 0: unlimited)
+void remove_page_store(PageStore *store);                                                  // removes store and its slabs
+PageHandle page_store_store(PageStore *store, ByteArr page);                               // compresses and stores a page (PAGE_STORE_NO_HANDLE if the pool is full)
+Bool page_store_load(PageStore *store, PageHandle handle, ByteArr page);                  // decompresses a stored page (FALSE if the handle is not valid)
+void page_store_evict(PageStore *store, PageHandle handle);                                // removes a stored page
+PageStoreStats page_store_stats(PageStore *store);                                         // statistics on pool density
+
+#endif
@@ -0,0 +1,140 @@
+#include "perf_counters.h"
+
+#include <math.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+/*
+ * Functions for hardware performance counters
+ *   Throughput alone does not tell why an algorithm is slow. Counters of cycles, instructions,
+ *   branch misses and L1D read misses are opened as a single group with perf_event_open, so they
+ *   are scheduled on the PMU together and describe the same instructions. A benchmark loop is
+ *   wrapped with perf_counters_start/stop, and the values are divided by the number of lines of
+ *   the loop (IPC, branch misses per line, ...).
+ *
+ *   Only user space is counted, so counters work with the default perf_event_paranoid (2). When
+ *   the group is multiplexed with other events, values are scaled by enabled / running time.
+ *
+ * Functions:
+ *   make_perf_counters: opens counter group of the calling thread (user space only)
+ *   remove_perf_counters: closes counter group
+ *   perf_counters_start: resets and enables counters
+ *   perf_counters_stop: disables counters and reads values
+ *   perf_counters_available: whether counters are opened
+ *
+ * Note
+ *   Only Linux is supported (on Windows, counters are never available). Counters are not
+ *   available on systems without PMU access (e.g. virtual machines, perf_event_paranoid 3), and
+ *   counters not supported by the CPU are NAN
+ */
+
+#ifndef _WIN32
+static const uint32_t perf_types[PERF_COUNTER_NUM] = {
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HW_CACHE,
+};
+
+static const uint64_t perf_configs[PERF_COUNTER_NUM] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+};
+
+static int open_perf_event(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd < 0;  // members follow the leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+PerfCounters make_perf_counters(void) {
+    PerfCounters counters;
+
+    for (int i = 0; i < PERF_COUNTER_NUM; i++) {
+        counters.fds[i] = -1;
+        counters.values[i] = NAN;
+    }
+#ifdef _WIN32
+    counters.leader = -1;  // perf_event_open is not available
+#else
+    counters.leader = open_perf_event(perf_types[PERF_CYCLES], perf_configs[PERF_CYCLES], -1);
+    if (counters.leader < 0)
+        return counters;
+
+    counters.fds[PERF_CYCLES] = counters.leader;
+    for (int i = 0; i < PERF_COUNTER_NUM; i++) {
+        if (i == PERF_CYCLES) continue;
+        counters.fds[i] = open_perf_event(perf_types[i], perf_configs[i], counters.leader);
+#ifdef VERBOSE
+        if (counters.fds[i] < 0)
+            printf("counter %d is not supported\n", i);
+#endif
+    }
+#endif
+
+    return counters;
+}
+
+void remove_perf_counters(PerfCounters counters) {
+    for (int i = 0; i < PERF_COUNTER_NUM; i++) {
+        if (counters.fds[i] < 0) continue;
+#ifndef _WIN32
+        close(counters.fds[i]);
+#endif
+    }
+}
+
+void perf_counters_start(PerfCounters *counters) {
+    if (counters->leader < 0)
+        return;
+#ifndef _WIN32
+    ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void perf_counters_stop(PerfCounters *counters) {
+    for (int i = 0; i < PERF_COUNTER_NUM; i++)
+        counters->values[i] = NAN;
+    if (counters->leader < 0)
+        return;
+
+#ifndef _WIN32
+    uint64_t buffer[3 + PERF_COUNTER_NUM];  // {nr, time_enabled, time_running, values of opened counters}
+    double scale;
+    int index = 0;
+
+    ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(counters->leader, buffer, sizeof(buffer)) < (long)(3 * sizeof(uint64_t)) || buffer[2] == 0)
+        return;  // group was never scheduled
+    scale = (double)buffer[1] / buffer[2];
+
+    // values are in the order the counters were added to the group
+    for (int i = 0; i < PERF_COUNTER_NUM && index < (int)buffer[0]; i++) {
+        if (counters->fds[i] < 0) continue;
+        counters->values[i] = buffer[3 + index++] * scale;
+    }
+#endif
+}
+
+Bool perf_counters_available(PerfCounters counters) {
+    return counters.leader >= 0;
+}
@@ -0,0 +1,29 @@
+#ifndef PERF_COUNTERS
+#define PERF_COUNTERS
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Hardware counters of a group (index of values)
+#define PERF_COUNTER_NUM    4
+#define PERF_CYCLES         0  // CPU cycles (group leader)
+#define PERF_INSTRUCTIONS   1  // retired instructions
+#define PERF_BRANCH_MISSES  2  // mispredicted branches
+#define PERF_L1D_MISSES     3  // L1 data cache read misses
+
+typedef struct {
+    int       leader;                     // fd of group leader (-1: counters are not available)
+    int       fds[PERF_COUNTER_NUM];      // fd of each counter (-1: not supported by the CPU)
+    double    values[PERF_COUNTER_NUM];   // counts of the last measurement (scaled if multiplexed, NAN if not counted)
+} PerfCounters;
+
+// Functions for hardware performance counters (perf_event_open)
+PerfCounters make_perf_counters(void);             // opens counter group of the calling thread (user space only)
+void remove_perf_counters(PerfCounters counters);  // closes counter group
+void perf_counters_start(PerfCounters *counters);  // resets and enables counters
+void perf_counters_stop(PerfCounters *counters);   // disables counters and reads values
+Bool perf_counters_available(PerfCounters counters);  // whether counters are opened
+
+#endif
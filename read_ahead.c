@@ -0,0 +1,245 @@
+#include "read_ahead.h"
+
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+/*
+ * Functions for read-ahead pipeline
+ *   Testbenches alternate between blocking on file reads and compressing, which is slow on
+ *   network-mounted disks. The pipeline overlaps them: the consumer (testbench) fills buffers of
+ *   the pool with the indices of the blocks it will compress next and submits them, and a reader
+ *   thread reads the blocks of submitted buffers in order while the consumer compresses the
+ *   buffers read before. Runs of consecutive blocks (sequential mode) are read with a single pread,
+ *   so a buffer of READ_AHEAD_BATCH blocks is a single large read. Other blocks (sampling mode) are
+ *   read through an aligned window of READ_AHEAD_WINDOW bytes, so that nearby samples share a read.
+ *
+ *   Buffers are used as a ring: submitted, completed and consumed are counters of buffers, and a
+ *   buffer can be reserved while (submitted - consumed) < depth. Time spent by each stage is
+ *   measured separately: reading, reader waiting for requests (compute bound) and consumer
+ *   waiting for data (I/O bound).
+ *
+ * Functions:
+ *   make_read_ahead: starts reader thread over the file
+ *   read_ahead_reserve: free buffer to fill with block indices (NULL if the pool is full)
+ *   read_ahead_submit: submits the reserved buffer to the reader thread
+ *   read_ahead_next: waits for the oldest submitted buffer (NULL if nothing is submitted)
+ *   read_ahead_release: releases the buffer returned by read_ahead_next
+ *   remove_read_ahead: stops reader thread and removes the pipeline
+ *   read_ahead_clock: monotonic clock (sec) for timing pipeline stages
+ *
+ * Note
+ *   On Windows (no pthread and pread), there is no reader thread: buffers are read with fseek and
+ *   fread by the consumer when read_ahead_next returns them, so reads are not overlapped but the
+ *   results are the same. Blocks of a buffer are zero padded after the end of the file (as tb_csv
+ *   reads its blocks)
+ */
+
+#ifdef _WIN32
+#define READ_AHEAD_LOCK(pipeline)
+#define READ_AHEAD_UNLOCK(pipeline)
+#else
+#define READ_AHEAD_LOCK(pipeline)    pthread_mutex_lock(&(pipeline)->lock)
+#define READ_AHEAD_UNLOCK(pipeline)  pthread_mutex_unlock(&(pipeline)->lock)
+#endif
+
+double read_ahead_clock(void) {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static long read_ahead_pread(ReadAhead *pipeline, ByteArr dst, long offset, long size) {
+    long total = 0;
+
+    if (offset >= pipeline->filesize)
+        return 0;
+    if (offset + size > pipeline->filesize)
+        size = pipeline->filesize - offset;
+
+#ifdef _WIN32
+    if (fseek(pipeline->fp, offset, SEEK_SET) == 0)
+        total = fread(dst, 1, size, pipeline->fp);
+#else
+    while (total < size) {
+        long readsiz = pread(fileno(pipeline->fp), dst + total, size - total, offset + total);
+        if (readsiz <= 0)
+            break;
+        total += readsiz;
+    }
+#endif
+    return total;
+}
+
+static void read_ahead_window(ReadAhead *pipeline, ByteArr dst, long offset, long size) {
+    long window_offset = offset / READ_AHEAD_WINDOW * READ_AHEAD_WINDOW;
+
+    if (offset + size > window_offset + READ_AHEAD_WINDOW) {  // crosses windows
+        pipeline->bytes_read += read_ahead_pread(pipeline, dst, offset, size);
+        return;
+    }
+
+    if (pipeline->window_offset != window_offset) {
+        pipeline->window_size = read_ahead_pread(pipeline, pipeline->window, window_offset, READ_AHEAD_WINDOW);
+        pipeline->window_offset = window_offset;
+        pipeline->bytes_read += pipeline->window_size;
+    }
+
+    if (offset - window_offset < pipeline->window_size) {
+        if (offset + size > window_offset + pipeline->window_size)
+            size = window_offset + pipeline->window_size - offset;  // end of the file
+        memcpy(dst, pipeline->window + (offset - window_offset), size);
+    }
+}
+
+static void read_ahead_batch(ReadAhead *pipeline, ReadAheadBatch *batch) {
+    long blocksize = pipeline->blocksize;
+    int run;
+
+    memset(batch->body, 0, (long)batch->block_num * blocksize);
+
+    for (int i = 0; i < batch->block_num; i += run) {
+        // run of consecutive blocks
+        for (run = 1; i + run < batch->block_num && batch->block_idx[i + run] == batch->block_idx[i] + run; run++);
+
+        if (run * blocksize >= READ_AHEAD_WINDOW) {
+            pipeline->bytes_read += read_ahead_pread(pipeline, batch->body + i * blocksize, batch->block_idx[i] * blocksize, run * blocksize);
+        } else {
+            read_ahead_window(pipeline, batch->body + i * blocksize, batch->block_idx[i] * blocksize, run * blocksize);
+        }
+    }
+}
+
+#ifndef _WIN32
+static void *read_ahead_thread(void *arg) {
+    ReadAhead *pipeline = (ReadAhead *)arg;
+    ReadAheadBatch *batch;
+    double start;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        start = read_ahead_clock();
+        while (pipeline->completed == pipeline->submitted && !pipeline->stop)
+            pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+        pipeline->reader_wait_sec += read_ahead_clock() - start;
+        if (pipeline->stop)
+            break;
+
+        batch = &pipeline->batches[pipeline->completed % pipeline->depth];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        start = read_ahead_clock();
+        read_ahead_batch(pipeline, batch);
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->read_sec += read_ahead_clock() - start;
+        pipeline->completed += 1;
+        pthread_cond_broadcast(&pipeline->cond);
+
+#ifdef VERBOSE
+        printf("batch %ld read (%d blocks)\n", pipeline->completed - 1, batch->block_num);
+#endif
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return NULL;
+}
+#endif
+
+ReadAhead *make_read_ahead(FILE *fp, long filesize, int blocksize, int depth) {
+    ReadAhead *pipeline = (ReadAhead *)calloc(1, sizeof(ReadAhead));
+
+    pipeline->fp = fp;
+    pipeline->filesize = filesize;
+    pipeline->blocksize = blocksize;
+    pipeline->depth = depth > 0 ? depth : READ_AHEAD_DEPTH;
+    pipeline->batches = (ReadAheadBatch *)calloc(pipeline->depth, sizeof(ReadAheadBatch));
+    for (int i = 0; i < pipeline->depth; i++)
+        pipeline->batches[i].body = (ByteArr)malloc((long)READ_AHEAD_BATCH * blocksize);
+
+    pipeline->window = (ByteArr)malloc(READ_AHEAD_WINDOW);
+    pipeline->window_offset = -1;
+    pipeline->window_size = 0;
+
+#ifndef _WIN32
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->cond, NULL);
+    pthread_create(&pipeline->thread, NULL, read_ahead_thread, pipeline);
+#endif
+
+    return pipeline;
+}
+
+ReadAheadBatch *read_ahead_reserve(ReadAhead *pipeline) {
+    ReadAheadBatch *batch = NULL;
+
+    READ_AHEAD_LOCK(pipeline);
+    if (pipeline->submitted - pipeline->consumed < pipeline->depth) {
+        batch = &pipeline->batches[pipeline->submitted % pipeline->depth];
+        batch->block_num = 0;
+    }
+    READ_AHEAD_UNLOCK(pipeline);
+
+    return batch;
+}
+
+void read_ahead_submit(ReadAhead *pipeline) {
+    READ_AHEAD_LOCK(pipeline);
+    pipeline->submitted += 1;
+#ifndef _WIN32
+    pthread_cond_broadcast(&pipeline->cond);
+#endif
+    READ_AHEAD_UNLOCK(pipeline);
+}
+
+ReadAheadBatch *read_ahead_next(ReadAhead *pipeline) {
+    ReadAheadBatch *batch = NULL;
+    double start = read_ahead_clock();
+
+    READ_AHEAD_LOCK(pipeline);
+    if (pipeline->consumed < pipeline->submitted) {
+        batch = &pipeline->batches[pipeline->consumed % pipeline->depth];
+#ifdef _WIN32
+        read_ahead_batch(pipeline, batch);  // read by the consumer (no reader thread)
+        pipeline->read_sec += read_ahead_clock() - start;
+        pipeline->completed += 1;
+#else
+        while (pipeline->completed <= pipeline->consumed)
+            pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+#endif
+    }
+    pipeline->consumer_wait_sec += read_ahead_clock() - start;
+    READ_AHEAD_UNLOCK(pipeline);
+
+    return batch;
+}
+
+void read_ahead_release(ReadAhead *pipeline) {
+    READ_AHEAD_LOCK(pipeline);
+    pipeline->consumed += 1;
+    READ_AHEAD_UNLOCK(pipeline);
+}
+
+void remove_read_ahead(ReadAhead *pipeline) {
+#ifndef _WIN32
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->stop = TRUE;
+    pthread_cond_broadcast(&pipeline->cond);
+    pthread_mutex_unlock(&pipeline->lock);
+    pthread_join(pipeline->thread, NULL);
+
+    pthread_mutex_destroy(&pipeline->lock);
+    pthread_cond_destroy(&pipeline->cond);
+#endif
+    for (int i = 0; i < pipeline->depth; i++)
+        free(pipeline->batches[i].body);
+    free(pipeline->batches);
+    free(pipeline->window);
+    free(pipeline);
+}
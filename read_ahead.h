@@ -0,0 +1,58 @@
+#ifndef READ_AHEAD
+#define READ_AHEAD
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Parameters for read-ahead pipeline
+#define READ_AHEAD_BATCH  256    // blocks per buffer (consecutive blocks are read with a single call)
+#define READ_AHEAD_DEPTH  4      // default number of buffers in the pool
+#define READ_AHEAD_WINDOW 4096   // blocks not in a long run are read through an aligned window (as stdio buffer)
+
+typedef struct {
+    int       block_num;                    // number of blocks requested
+    long      block_idx[READ_AHEAD_BATCH];  // index of each block (offset = index * block size)
+    int       tags[READ_AHEAD_BATCH];       // user tag of each block (e.g. stratum)
+    ByteArr   body;                         // blocks (zero padded after the end of the file)
+} ReadAheadBatch;
+
+typedef struct {
+    FILE            *fp;                 // file being read (pread on its descriptor, file position is not used)
+    long             filesize;           // size of the file
+    int              blocksize;          // size of blocks
+    int              depth;              // number of buffers in the pool
+    ReadAheadBatch  *batches;            // pool of buffers (ring)
+    ByteArr          window;             // last window read by reader thread
+    long             window_offset;      // offset of the window (-1: empty)
+    long             window_size;        // valid bytes of the window
+    long             submitted;          // number of batches submitted by consumer
+    long             completed;          // number of batches read by reader thread
+    long             consumed;           // number of batches released by consumer
+    Bool             stop;               // reader thread stops
+#ifndef _WIN32
+    pthread_t        thread;             // reader thread
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+#endif
+    long             bytes_read;         // bytes read from the file
+    double           read_sec;           // time spent reading (reader thread)
+    double           reader_wait_sec;    // time reader thread waited for requests (pipeline is compute bound)
+    double           consumer_wait_sec;  // time consumer waited for data (pipeline is I/O bound)
+} ReadAhead;
+
+// Functions for read-ahead pipeline
+ReadAhead *make_read_ahead(FILE *fp, long filesize, int blocksize, int depth); // starts reader thread over the file
+ReadAheadBatch *read_ahead_reserve(ReadAhead *pipeline);                       // free buffer to fill with block indices (NULL if the pool is full)
+void read_ahead_submit(ReadAhead *pipeline);                                   // submits the reserved buffer to the reader thread
+ReadAheadBatch *read_ahead_next(ReadAhead *pipeline);                          // waits for the oldest submitted buffer (NULL if nothing is submitted)
+void read_ahead_release(ReadAhead *pipeline);                                  // releases the buffer returned by read_ahead_next
+void remove_read_ahead(ReadAhead *pipeline);                                   // stops reader thread and removes the pipeline
+double read_ahead_clock(void);                                                 // monotonic clock (sec) for timing pipeline stages
+
+#endif
@@ -0,0 +1,103 @@
+#include "result_cache.h"
+
+#include <string.h>
+
+
+/*
+ * Functions for content-addressed result cache
+ *   Results of the testbench are cached on disk per (file content hash, chunk size, algorithm name
+ *   and version, options). A sweep over unchanged files only computes algorithms that are newly
+ *   added or whose version is increased, and renaming or moving a file does not invalidate its
+ *   results. Cache file is a CSV file which is only appended, so an interrupted sweep keeps the
+ *   results of files already done. When an entry is repeated, the last one wins.
+ *
+ * Functions:
+ *   open_result_cache: loads cached results and opens the file for appending
+ *   close_result_cache: closes the cache file
+ *   file_content_hash: 64bit hash of the whole file content (line_hash64 of 1MB blocks, chained)
+ *   lookup_result_cache: finds cached result
+ *   insert_result_cache: adds result and appends it to the cache file
+ */
+
+static void append_result_entry(ResultCache *cache, CachedResult entry) {
+    if (cache->entry_num >= cache->capacity) {
+        cache->capacity = cache->capacity == 0 ? 1024 : cache->capacity * 2;
+        cache->entries = (CachedResult *)realloc(cache->entries, cache->capacity * sizeof(CachedResult));
+    }
+    cache->entries[cache->entry_num++] = entry;
+}
+
+ResultCache open_result_cache(char const *filename) {
+    ResultCache cache;
+    CachedResult entry;
+    char linebuf[512];
+    unsigned long long content_hash;
+
+    cache.entries = NULL;
+    cache.entry_num = 0;
+    cache.capacity = 0;
+
+    FILE *fp = fopen(filename, "rt");
+    if (fp != NULL) {
+        while (fgets(linebuf, sizeof(linebuf), fp)) {
+            if (sscanf(linebuf, "%llx,%d,%63[^,],%d,%127[^,],%ld,%lf,%lf", &content_hash, &entry.chunk_size, entry.algo_name,
+                       &entry.algo_version, entry.options, &entry.samples, &entry.ratio, &entry.half_width) != 8)
+                continue;  // header or broken line
+            entry.content_hash = content_hash;
+            append_result_entry(&cache, entry);
+        }
+        fclose(fp);
+    }
+
+    cache.fp = fopen(filename, "at");
+    if (cache.fp == NULL) {
+        fprintf(stderr, "[WARNING] Opening result cache '%s' failed (results are not cached)\n", filename);
+    } else if (ftell(cache.fp) == 0) {
+        fprintf(cache.fp, "%s\n", "Content Hash,Chunk Size,Algorithm,Version,Options,Samples,Ratio,Half Width");
+    }
+
+#ifdef VERBOSE
+    printf("result cache '%s' loaded (%ld entries)\n", filename, cache.entry_num);
+#endif
+
+    return cache;
+}
+
+void close_result_cache(ResultCache cache) {
+    if (cache.fp != NULL)
+        fclose(cache.fp);
+    free(cache.entries);
+}
+
+uint64_t file_content_hash(FILE *fp) {
+    ByteArr block = (ByteArr)malloc(RESULT_CACHE_HASH_BLOCK);
+    uint64_t hash = 0;
+    size_t readsiz;
+
+    fseek(fp, 0, SEEK_SET);
+    while ((readsiz = fread(block, 1, RESULT_CACHE_HASH_BLOCK, fp)) > 0)
+        hash = line_hash64(block, (int)readsiz) ^ (hash * 0x9e3779b97f4a7c15ULL + readsiz);
+
+    free(block);
+    return hash;
+}
+
+CachedResult *lookup_result_cache(ResultCache *cache, uint64_t content_hash, int chunk_size, char const *algo_name, int algo_version, char const *options) {
+    for (long i = cache->entry_num - 1; i >= 0; i--) {  // latest entry first
+        CachedResult *entry = &cache->entries[i];
+        if (entry->content_hash == content_hash && entry->chunk_size == chunk_size && entry->algo_version == algo_version &&
+            strcmp(entry->algo_name, algo_name) == 0 && strcmp(entry->options, options) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+void insert_result_cache(ResultCache *cache, CachedResult entry) {
+    append_result_entry(cache, entry);
+
+    if (cache->fp != NULL) {
+        fprintf(cache->fp, "%016llx,%d,%s,%d,%s,%ld,%.17g,%.17g\n", (unsigned long long)entry.content_hash, entry.chunk_size,
+                entry.algo_name, entry.algo_version, entry.options, entry.samples, entry.ratio, entry.half_width);
+        fflush(cache->fp);
+    }
+}
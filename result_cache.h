@@ -0,0 +1,37 @@
+#ifndef RESULT_CACHE
+#define RESULT_CACHE
+
+#include "compression.h"
+#include "line_dedup.h"
+
+// Parameters for result cache
+#define RESULT_CACHE_NAME_SIZ    64
+#define RESULT_CACHE_OPTION_SIZ  128
+#define RESULT_CACHE_HASH_BLOCK  (1 << 20)  // file content is hashed by 1MB blocks
+
+typedef struct {
+    uint64_t  content_hash;                          // hash of the file content
+    int       chunk_size;                            // memory chunk size
+    char      algo_name[RESULT_CACHE_NAME_SIZ];      // algorithm name
+    int       algo_version;                          // algorithm version
+    char      options[RESULT_CACHE_OPTION_SIZ];      // testbench options affecting the result (';' separated)
+    long      samples;                               // number of compressed lines
+    double    ratio;                                 // compression ratio
+    double    half_width;                            // half width of 95% CI (0 if not sampled)
+} CachedResult;
+
+typedef struct {
+    CachedResult *entries;   // cached results
+    long          entry_num;
+    long          capacity;
+    FILE         *fp;        // cache file opened for appending new results
+} ResultCache;
+
+// Functions for content-addressed result cache
+ResultCache open_result_cache(char const *filename);                  // loads cached results and opens the file for appending
+void close_result_cache(ResultCache cache);                           // closes the cache file
+uint64_t file_content_hash(FILE *fp);                                 // 64bit hash of the whole file content
+CachedResult *lookup_result_cache(ResultCache *cache, uint64_t content_hash, int chunk_size, char const *algo_name, int algo_version, char const *options);  // NULL if not cached
+void insert_result_cache(ResultCache *cache, CachedResult entry);    // adds result and appends it to the cache file
+
+#endif
@@ -0,0 +1,174 @@
+#include "shm_ring.h"
+
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/*
+ * Functions for shared memory ring buffer
+ *   Single producer (PyTorch forward hooks, models/tools/shm_stream.py) and single consumer ring
+ *   buffer over a shared file (e.g. /dev/shm/...), so activations are compressed while inference
+ *   runs without being written to disk. Each record is {name length, flags, payload size, name,
+ *   payload}, aligned to 8Bytes, and never wraps around the end of the data area: the producer
+ *   writes a record with SHM_RING_WRAP flag instead (or leaves less than a record header).
+ *
+ *   Head and tail are byte counters which only increase (index = counter % capacity). The producer
+ *   publishes head after the record is written, and the consumer publishes tail after the record
+ *   is released. The producer waits while the record does not fit in (capacity - (head - tail)),
+ *   which is the backpressure when the compressor is slower than inference. Record headers come
+ *   from another process, so a record whose name or payload does not fit in the published bytes
+ *   before the end of the data area is reported as corrupted and ends the stream.
+ *
+ *   Only POSIX systems are supported (mmap).
+ *
+ * Functions:
+ *   open_shm_ring: maps ring created by producer (waits for it to be initialized)
+ *   close_shm_ring: unmaps ring
+ *   shm_ring_read: waits for next record (FALSE if producer closed the ring and it is drained, or a record is corrupted)
+ *   shm_ring_release: releases the record read last
+ */
+
+#define SHM_RING_FIELD(ring, offset) ((uint64_t *)((ring)->base + (offset)))
+#define SHM_RING_ALIGNED(size) (((size) + SHM_RING_ALIGN - 1) / SHM_RING_ALIGN * SHM_RING_ALIGN)
+
+static void shm_ring_sleep(void) {
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = SHM_RING_POLL_USEC * 1000L;
+    nanosleep(&ts, NULL);
+}
+
+ShmRing open_shm_ring(char const *path, int timeout_sec) {
+    ShmRing ring;
+    struct stat st;
+    uint64_t capacity;
+    long waited = 0, timeout = (long)timeout_sec * 1000000L / SHM_RING_POLL_USEC;
+    int fd = -1;
+
+    ring.base = NULL;
+    ring.data = NULL;
+    ring.capacity = 0;
+    ring.map_size = 0;
+    ring.tail = 0;
+    ring.next_tail = 0;
+    ring.corrupted = FALSE;
+
+    // 1. Wait for producer to create the file and write the header
+    for (;;) {
+        if (fd < 0)
+            fd = open(path, O_RDWR);
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size >= SHM_RING_HEADER_SIZ) {
+            ring.base = (ByteArr)mmap(NULL, SHM_RING_HEADER_SIZ, PROT_READ, MAP_SHARED, fd, 0);
+            if (ring.base != MAP_FAILED) {
+                Bool ready = __atomic_load_n(SHM_RING_FIELD(&ring, SHM_RING_MAGIC_OFFSET), __ATOMIC_ACQUIRE) == SHM_RING_MAGIC;
+                capacity = *SHM_RING_FIELD(&ring, SHM_RING_CAP_OFFSET);
+                munmap(ring.base, SHM_RING_HEADER_SIZ);
+                if (ready && st.st_size >= (off_t)(SHM_RING_HEADER_SIZ + capacity))
+                    break;
+            }
+            ring.base = NULL;
+        }
+        if (timeout >= 0 && waited++ >= timeout) {
+            fprintf(stderr, "[ERROR] Shared memory ring '%s' is not initialized\n", path);
+            if (fd >= 0) close(fd);
+            return ring;
+        }
+        shm_ring_sleep();
+    }
+
+    // 2. Map header and data area
+    ring.map_size = SHM_RING_HEADER_SIZ + capacity;
+    ring.base = (ByteArr)mmap(NULL, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring.base == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] Mapping shared memory ring '%s' failed\n", path);
+        ring.base = NULL;
+        return ring;
+    }
+    ring.data = ring.base + SHM_RING_HEADER_SIZ;
+    ring.capacity = capacity;
+    ring.tail = __atomic_load_n(SHM_RING_FIELD(&ring, SHM_RING_TAIL_OFFSET), __ATOMIC_ACQUIRE);
+    ring.next_tail = ring.tail;
+
+#ifdef VERBOSE
+    printf("shared memory ring '%s' opened (capacity: %lluBytes)\n", path, (unsigned long long)capacity);
+#endif
+
+    return ring;
+}
+
+void close_shm_ring(ShmRing ring) {
+    if (ring.base != NULL)
+        munmap(ring.base, ring.map_size);
+}
+
+Bool shm_ring_read(ShmRing *ring, ShmRecord *record) {
+    uint64_t head, index, rest, avail;
+    uint32_t name_len, flags;
+    uint64_t size;
+
+    if (ring->base == NULL || ring->corrupted)
+        return FALSE;
+
+    for (;;) {
+        head = __atomic_load_n(SHM_RING_FIELD(ring, SHM_RING_HEAD_OFFSET), __ATOMIC_ACQUIRE);
+
+        // 1. Ring is empty: finish if producer closed it, otherwise wait
+        if (head == ring->tail) {
+            if (__atomic_load_n(SHM_RING_FIELD(ring, SHM_RING_CLOSED_OFFSET), __ATOMIC_ACQUIRE)) {
+                head = __atomic_load_n(SHM_RING_FIELD(ring, SHM_RING_HEAD_OFFSET), __ATOMIC_ACQUIRE);
+                if (head == ring->tail)
+                    return FALSE;
+                continue;
+            }
+            shm_ring_sleep();
+            continue;
+        }
+
+        // 2. Skip the end of the data area (no room for a record, or wrap record)
+        index = ring->tail % ring->capacity;
+        rest = ring->capacity - index;
+        if (rest >= SHM_RING_RECORD_SIZ) {
+            memcpy(&name_len, ring->data + index, 4);
+            memcpy(&flags, ring->data + index + 4, 4);
+            memcpy(&size, ring->data + index + 8, 8);
+        }
+        if (rest < SHM_RING_RECORD_SIZ || (flags & SHM_RING_WRAP)) {
+            ring->tail += rest;
+            ring->next_tail = ring->tail;
+            __atomic_store_n(SHM_RING_FIELD(ring, SHM_RING_TAIL_OFFSET), ring->tail, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        // 3. Record must fit in the published bytes without wrapping (header is not trusted)
+        avail = head - ring->tail < rest ? head - ring->tail : rest;
+        if (name_len >= SHM_RING_NAME_SIZ || size > avail || SHM_RING_RECORD_SIZ + SHM_RING_ALIGNED(name_len) + SHM_RING_ALIGNED(size) > avail) {
+            fprintf(stderr, "[ERROR] Corrupted record at %llu (name length: %u  payload size: %llu)\n",
+                    (unsigned long long)ring->tail, name_len, (unsigned long long)size);
+            ring->corrupted = TRUE;
+            return FALSE;
+        }
+
+        // 4. Read record (payload stays in the ring until released)
+        memcpy(record->name, ring->data + index + SHM_RING_RECORD_SIZ, name_len);
+        record->name[name_len] = 0;
+        record->payload = ring->data + index + SHM_RING_RECORD_SIZ + SHM_RING_ALIGNED(name_len);
+        record->size = size;
+        ring->next_tail = ring->tail + SHM_RING_RECORD_SIZ + SHM_RING_ALIGNED(name_len) + SHM_RING_ALIGNED(size);
+
+#ifdef VERBOSE
+        printf("record '%s' (%lluBytes) at %llu\n", record->name, (unsigned long long)size, (unsigned long long)ring->tail);
+#endif
+
+        return TRUE;
+    }
+}
+
+void shm_ring_release(ShmRing *ring) {
+    ring->tail = ring->next_tail;
+    __atomic_store_n(SHM_RING_FIELD(ring, SHM_RING_TAIL_OFFSET), ring->tail, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,45 @@
+#ifndef SHM_RING
+#define SHM_RING
+
+#include "compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+// Layout of shared memory ring buffer (must match models/tools/shm_stream.py)
+#define SHM_RING_MAGIC         0x31474e4952504d43ULL  // "CMPRING1"
+#define SHM_RING_HEADER_SIZ    256     // header (magic, capacity, closed flag, head and tail on separate cache lines)
+#define SHM_RING_MAGIC_OFFSET  0
+#define SHM_RING_CAP_OFFSET    8
+#define SHM_RING_CLOSED_OFFSET 16
+#define SHM_RING_HEAD_OFFSET   64      // written by producer: total bytes written
+#define SHM_RING_TAIL_OFFSET   128     // written by consumer: total bytes released
+#define SHM_RING_RECORD_SIZ    16      // record header: name length (4B), flags (4B), payload size (8B)
+#define SHM_RING_ALIGN         8       // records are aligned to 8Bytes
+#define SHM_RING_WRAP          1       // record flag: skip to the beginning of the buffer
+#define SHM_RING_NAME_SIZ      256     // maximum length of tensor name
+#define SHM_RING_POLL_USEC     100     // sleep time of consumer while the ring is empty
+
+typedef struct {
+    ByteArr   base;       // mapped shared memory (header + data area)
+    ByteArr   data;       // data area
+    uint64_t  capacity;   // size of data area
+    long      map_size;   // size of mapped region
+    uint64_t  tail;       // read position of consumer (not released yet)
+    uint64_t  next_tail;  // position after the record being read
+    Bool      corrupted;  // a corrupted record was read (stream ended early)
+} ShmRing;
+
+typedef struct {
+    char      name[SHM_RING_NAME_SIZ];  // name of tensor (e.g. layer name)
+    ByteArr   payload;                  // tensor bytes (points into the ring, valid until released)
+    uint64_t  size;                     // size of payload
+} ShmRecord;
+
+// Functions for shared memory ring buffer (consumer side)
+ShmRing open_shm_ring(char const *path, int timeout_sec);   // maps ring created by producer (waits for it to be initialized)
+void close_shm_ring(ShmRing ring);                           // unmaps ring
+Bool shm_ring_read(ShmRing *ring, ShmRecord *record);        // waits for next record (FALSE if producer closed the ring and it is drained, or a record is corrupted)
+void shm_ring_release(ShmRing *ring);                        // releases the record read last (producer can overwrite it)
+
+#endif
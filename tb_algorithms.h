@@ -0,0 +1,82 @@
+#ifndef TB_ALGORITHMS
+#define TB_ALGORITHMS
+
+#include "compression.h"
+#include "bdi_zerovec.h"
+#include "bpc_compression.h"
+#include "cpack_compression.h"
+#include "block_compression.h"
+#include "int8_compression.h"
+#include "original_bdi_compression.h"
+#include "batch_compression.h"
+
+// Number of algorithms in test
+#define ALGO_NUM  14
+
+// Algorithms in test (shared by testbenches)
+static char *algo_names[ALGO_NUM] = {"BDI", "FPC", "BDI 2B", "BDI+ZR", "ZeroVec", "ZerosRun", "BDI+ZE", "BDI+ZV", "BPC", "C-Pack", "Block BDI", "INT8 BDI", "INT8 ZV", "BDI Orig"};
+
+static CompressionResult (*algo_funcs[ALGO_NUM]) (CacheLine original) = {
+    bdi_compression,          // BDI
+    fpc_compression,          // FPC
+    bdi_twobase_compression,  // BDI with two bases
+    bdi_zr_compression,       // BDI with zeros run
+    zero_vec_compression,     // Zero Vector
+    zeros_run_compression,    // Zeros Run
+    bdi_ze_compression,       // BDI with zero encoding
+    bdi_zv_compression,       // BDI with zero vector
+    bpc_compression,          // Bit-Plane Compression
+    cpack_compression,        // C-Pack
+    block_bdi_compression,    // Block mode BDI (64Bytes sub-lines)
+    int8_bdi_compression,     // int8 BDI (1Byte base, sub-byte deltas)
+    int8_zv_compression,      // int8 zero vector (ReLU sparsity)
+    bdi_original_result,      // original BDI (reference sizes of every base/delta configuration)
+};
+
+// Decompression of algorithms (NULL: not available, pages of these algorithms cannot be stored in page store; only used by tb_pagestore)
+static __attribute__((unused)) DecompressionResult (*algo_decomp_funcs[ALGO_NUM]) (CacheLine compressed, MetaData tag_overhead, int original_size) = {
+    bdi_decompression,          // BDI
+    NULL,                       // FPC (decompression overruns the line for some patterns)
+    bdi_twobase_decompression,  // BDI with two bases
+    NULL,                       // BDI with zeros run
+    zero_vec_decompression,     // Zero Vector
+    NULL,                       // Zeros Run
+    NULL,                       // BDI with zero encoding
+    NULL,                       // BDI with zero vector
+    bpc_decompression,          // Bit-Plane Compression
+    cpack_decompression,        // C-Pack
+    block_bdi_decompression,    // Block mode BDI
+    int8_decompression,         // int8 BDI
+    int8_decompression,         // int8 zero vector
+    NULL,                       // original BDI (sizes only)
+};
+
+// Batch entry points of algorithms (NULL: per-line function is called over the batch)
+static void (*algo_batch_funcs[ALGO_NUM]) (ByteArr lines, int line_num, BatchResult *result) = {
+    bdi_batch_compression,       // BDI
+    NULL,                        // FPC
+    NULL,                        // BDI with two bases
+    NULL,                        // BDI with zeros run
+    zero_vec_batch_compression,  // Zero Vector
+    NULL,                        // Zeros Run
+    NULL,                        // BDI with zero encoding
+    NULL,                        // BDI with zero vector
+    NULL,                        // Bit-Plane Compression
+    NULL,                        // C-Pack
+    NULL,                        // Block mode BDI
+    NULL,                        // int8 BDI
+    NULL,                        // int8 zero vector
+    NULL,                        // original BDI
+};
+
+static inline void algo_batch_compression(int algo, ByteArr lines, int line_num, BatchResult *result) {
+    if (algo_batch_funcs[algo] != NULL)
+        algo_batch_funcs[algo](lines, line_num, result);
+    else
+        batch_compression(algo_funcs[algo], lines, line_num, result);
+}
+
+// Version of each algorithm (increase it whenever the output of the algorithm changes, so cached results are recomputed; only used by tb_csv)
+static int algo_versions[ALGO_NUM] __attribute__((unused)) = {1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+#endif
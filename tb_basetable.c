@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compression.h"
+#include "base_table.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for BDI with global base table
+ *   Lines of each layer file are compressed with BDI and with BDI referencing a global base table.
+ *   The table is reset at the start of every region, and its storage is counted once per region.
+ *   Size of lines encoded with the table includes the bits of base index.
+ *
+ * Usage: tb_basetable <filelist> <chunksize> [maxiter (-1: whole file)] [logfile] [index bits]
+ *                     [region lines (-1: whole file)] [policy (0: LRU, 1: LFU)]
+ *
+ * Output columns: layer name, number of lines, base table hit rate, base table size (all regions),
+ * BDI ratio, global base ratio (lines only), global base ratio (lines + base tables)
+ */
+
+int main(int argc, char const *argv[]) {
+    MemoryChunk chunk;
+    CompressionResult result;
+    BaseTable table;
+    int chunksize, iter, maxiter = -1, index_bits = BASE_TABLE_DEFAULT_BITS, region = -1, policy = BASE_TABLE_LRU;
+    long filesize, table_size, hits;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/basetable.csv";
+
+    long  bdi_size, gbt_bits, original_size;
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        index_bits = atoi(argv[5]);
+    if (argc > 6)
+        region = atoi(argv[6]);
+    if (argc > 7)
+        policy = atoi(argv[7]);
+
+    if (index_bits < 0 || index_bits > BASE_TABLE_MAX_BITS) {
+        fprintf(stderr, "[ERROR] Invalid base index bitwidth %d (0 ~ %d)\n", index_bits, BASE_TABLE_MAX_BITS);
+        exit(-1);
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    chunk = make_memory_chunk(chunksize, 0);
+    table = make_base_table(index_bits, policy);
+
+    fprintf(logfilefp, "%s\n", "Layer Name,Lines,Hit Rate,Base Table Size,BDI,Global Base,Global Base+Table");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
+
+        reset_base_table(&table);
+        iter = 0;
+        hits = 0;
+        original_size = 0;
+        bdi_size = 0;
+        gbt_bits = 0;
+        table_size = 0;
+
+        for (long i = 0; (i < filesize) && (maxiter < 0 || iter < maxiter); i += chunksize) {
+            memset(chunk.body, 0, chunksize);
+            fread(chunk.body, 1, chunksize, fp);
+
+            if (region > 0 && iter % region == 0) {  // start of a new region
+                hits += table.hits;
+                reset_base_table(&table);
+            }
+            if (table.lookups == 0)
+                table_size += base_table_size(table);
+
+            result = bdi_compression(chunk);
+            bdi_size += result.compressed.size;
+            remove_compression_result(result);
+
+            result = base_table_compression(&table, chunk);
+            gbt_bits += result.compressed.size * BYTE_BITWIDTH;
+            if (get_value_bitwise(result.tag_overhead.body, 0, 1))
+                gbt_bits += table.index_bits;  // base index of lines referencing the table
+#ifdef VERBOSE
+            printf("hit: %s  size: %dBytes  result: ", get_value_bitwise(result.tag_overhead.body, 0, 1) ? "true" : "false", result.compressed.size);
+            print_memory_chunk(result.compressed);
+            printf("\n");
+#endif
+            remove_compression_result(result);
+
+            iter += 1;
+            original_size += chunksize;
+#ifndef VERBOSE
+            if (iter % 1024 == 0)
+                printf("\r[ITER %2d] offset: %ldBytes  hits: %ld", iter, i, hits + table.hits);
+#endif
+        }
+
+        fclose(fp);
+        hits += table.hits;
+
+        printf("\nlines: %d  hit rate: %.4f  table size: %ldBytes\n", iter, (double)hits / iter, table_size);
+        printf("compression ratio: %.4f(BDI) %.4f(Global Base) %.4f(Global Base+Table)\n",
+               (double)original_size / bdi_size, (double)original_size * BYTE_BITWIDTH / gbt_bits,
+               (double)original_size * BYTE_BITWIDTH / (gbt_bits + table_size * BYTE_BITWIDTH));
+        fprintf(logfilefp, "%s,%d,%.4f,%ld,%.4f,%.4f,%.4f\n", datafilename, iter, (double)hits / iter, table_size,
+                (double)original_size / bdi_size, (double)original_size * BYTE_BITWIDTH / gbt_bits,
+                (double)original_size * BYTE_BITWIDTH / (gbt_bits + table_size * BYTE_BITWIDTH));
+    }
+
+    remove_base_table(table);
+    remove_memory_chunk(chunk);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
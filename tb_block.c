@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compression.h"
+#include "block_compression.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for line-level vs page-level compression
+ *   Each block (e.g. 4KB page) is compressed with block mode BDI, and the same block is also
+ *   compressed line by line with BDI using the sub-line size. Line-level ratio is reported
+ *   without tags (as tb_csv) and with 11bits of tag per line, since block mode ratio includes
+ *   every metadata stream.
+ *
+ * Usage: tb_block <filelist> <blocksize> <sublinesize> [maxiter] [logfile]
+ */
+
+int main(int argc, char const *argv[]) {
+    MemoryChunk block, line;
+    CompressionResult result;
+    int blocksize, sublinesize, iter, maxiter = 500;
+    long filesize;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/block.csv";
+
+    long  line_size, line_tag_bits, block_size, original_size;
+
+    if (argc > 3) {
+        filename = argv[1];
+        blocksize = atoi(argv[2]);
+        sublinesize = atoi(argv[3]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename, block size and sub-line size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 4)
+        maxiter = atoi(argv[4]);
+    if (argc > 5)
+        logfilename = argv[5];
+
+    if (blocksize <= 0 || sublinesize <= 0) {
+        fprintf(stderr, "[ERROR] Invalid block size %d or sub-line size %d\n", blocksize, sublinesize);
+        exit(-1);
+    }
+
+    if (blocksize % sublinesize != 0) {
+        fprintf(stderr, "[ERROR] Block size (%d) is not a multiple of sub-line size (%d)\n", blocksize, sublinesize);
+        exit(-1);
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    block = make_memory_chunk(blocksize, 0);
+    line = make_memory_chunk(sublinesize, 0);
+
+    fprintf(logfilefp, "%s\n", "Layer Name,Line BDI,Line BDI+Tag,Block BDI");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
+
+        iter = 0;
+        original_size = 0;
+        line_size = 0;
+        line_tag_bits = 0;
+        block_size = 0;
+
+        for (long i = 0; (i < filesize) && (iter < maxiter); i += blocksize) {
+            memset(block.body, 0, blocksize);
+            fread(block.body, 1, blocksize, fp);
+
+            for (int j = 0; j < blocksize; j += sublinesize) {
+                memcpy(line.body, block.body + j, sublinesize);
+                result = bdi_compression(line);
+                line_size += result.compressed.size;
+                line_tag_bits += result.tag_overhead.valid_bitwidth;
+                remove_compression_result(result);
+            }
+
+            result = block_bdi_compression_subline(block, sublinesize);
+            block_size += result.compressed.size;
+#ifdef VERBOSE
+            printf("block size: %dBytes  compressed: %s\n", result.compressed.size, result.is_compressed ? "true" : "false");
+#endif
+            remove_compression_result(result);
+
+#ifndef VERBOSE
+            printf("\r[ITER %2d] offset: %ldBytes  size: %dBytes", iter+1, i, blocksize);
+#endif
+            iter += 1;
+            original_size += blocksize;
+        }
+
+        fclose(fp);
+
+        printf("\ncompression ratio: %.4f(Line BDI) %.4f(Line BDI+Tag) %.4f(Block BDI)\n",
+               (double)original_size / line_size, (double)original_size / (line_size + line_tag_bits / BYTE_BITWIDTH),
+               (double)original_size / block_size);
+        fprintf(logfilefp, "%s,%.4f,%.4f,%.4f\n", datafilename,
+                (double)original_size / line_size, (double)original_size / (line_size + line_tag_bits / BYTE_BITWIDTH),
+                (double)original_size / block_size);
+    }
+
+    remove_memory_chunk(block);
+    remove_memory_chunk(line);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "tb_algorithms.h"
+#include "checkpoint_track.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+#define MAX_LAYER_NUM    4096
+
+
+/*
+ * Testbench for compressibility over training checkpoints
+ *   Each line of the checkpoint list is the filelist of one checkpoint (filelist.txt written by
+ *   save_params of the extractor, or save_checkpoint of training.py), in training order. Layers
+ *   are matched across checkpoints by file name, and each layer is tracked with checkpoint_track.h:
+ *   only lines changed since the previous checkpoint are compressed again (batch API, changed
+ *   lines are gathered), so that per-epoch tracking costs as much as the lines training touches.
+ *
+ *   With full recompute, every line of every checkpoint is compressed (baseline for timing and
+ *   checking the incremental results).
+ *
+ * Usage: tb_checkpoint <checkpoint list> <chunksize> [logfile] [full recompute]
+ *
+ * Output columns: checkpoint index, layer name, lines, changed lines, ratio of each algorithm, and
+ * then share of lines of each encoding (encoding mix) of algorithms which report encodings
+ */
+
+typedef struct {
+    char        name[FILENAME_BUFSIZ];  // file name of the layer (without directory)
+    LayerTrack  track;
+} TrackedLayer;
+
+static char const *layer_name(char const *path) {
+    char const *slash = strrchr(path, '/');
+    return slash == NULL ? path : slash + 1;
+}
+
+int main(int argc, char const *argv[]) {
+    BatchResult batch;
+    TrackedLayer *layers;
+    LayerTrack *track;
+    Bool has_encodings[ALGO_NUM];
+    Bool full = FALSE;
+    int chunksize, layer_num = 0, checkpoint = 0, line_batch;
+    long filesize, line_num, changed_num, total_lines, total_changed;
+    ByteArr image, gathered;
+    clock_t start, compress_clocks;
+
+    char checkpointname[FILENAME_BUFSIZ];
+    char datafilename[FILENAME_BUFSIZ];
+    char const *listname;
+    char const *logfilename = "./logs/checkpoint.csv";
+
+    if (argc > 2) {
+        listname = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (checkpoint list and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        logfilename = argv[3];
+    if (argc > 4)
+        full = atoi(argv[4]) != 0;
+
+    if (chunksize <= 0) {
+        fprintf(stderr, "[ERROR] Invalid memory chunk size %d\n", chunksize);
+        exit(-1);
+    }
+
+    FILE *listfp = fopen(listname, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (listfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening checkpoint list '%s' or logfile '%s' failed\n", listname, logfilename);
+        exit(-1);
+    }
+
+    batch = make_batch_result(BATCH_DEFAULT_LINES, chunksize, FALSE);
+    gathered = (ByteArr)calloc((long)BATCH_DEFAULT_LINES * chunksize, 1);
+    layers = (TrackedLayer *)malloc(sizeof(TrackedLayer) * MAX_LAYER_NUM);
+
+    // algorithms which report encodings (probed with a zero line)
+    for (int i = 0; i < ALGO_NUM; i++) {
+        algo_batch_compression(i, gathered, 1, &batch);
+        has_encodings[i] = batch.encodings[0] != BATCH_NO_ENCODING;
+    }
+
+    fprintf(logfilefp, "%s", "Checkpoint,Layer Name,Lines,Changed Lines");
+    for (int i = 0; i < ALGO_NUM; i++)
+        fprintf(logfilefp, ",%s", algo_names[i]);
+    for (int i = 0; i < ALGO_NUM; i++)
+        for (int e = 0; has_encodings[i] && e < TRACK_ENCODING_NUM; e++)
+            fprintf(logfilefp, ",%s Enc%d", algo_names[i], e);
+    fprintf(logfilefp, "\n");
+
+    while (fgets(checkpointname, FILENAME_BUFSIZ-1, listfp)) {
+        if (checkpointname[strlen(checkpointname)-1] == '\n')
+            checkpointname[strlen(checkpointname)-1] = 0;
+        if (checkpointname[0] == 0)
+            continue;
+
+        FILE *filelistfp = fopen(checkpointname, "rt");
+        if (filelistfp == NULL) {
+            fprintf(stderr, "[ERROR] Opening checkpoint filelist '%s' failed\n", checkpointname);
+            continue;
+        }
+
+        printf("Checkpoint %d: %s\n", checkpoint, checkpointname);
+        total_lines = total_changed = 0;
+        compress_clocks = 0;
+
+        while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+            if (datafilename[strlen(datafilename)-1] == '\n')
+                datafilename[strlen(datafilename)-1] = 0;
+
+            FILE *fp = fopen(datafilename, "rb");
+            if (fp == NULL) {
+                fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+                continue;
+            }
+            fseek(fp, 0, SEEK_END);
+            filesize = ftell(fp);
+            fseek(fp, 0, SEEK_SET);
+
+            line_num = (filesize + chunksize - 1) / chunksize;
+            image = (ByteArr)calloc(line_num * chunksize + 1, 1);  // last line is zero padded
+            fread(image, 1, filesize, fp);
+            fclose(fp);
+
+            // 1. Track of the layer (new layers are tracked from this checkpoint)
+            track = NULL;
+            for (int t = 0; t < layer_num && track == NULL; t++)
+                if (strcmp(layers[t].name, layer_name(datafilename)) == 0)
+                    track = &layers[t].track;
+            if (track == NULL) {
+                if (layer_num >= MAX_LAYER_NUM) {
+                    fprintf(stderr, "[ERROR] Too many layers (maximum %d)\n", MAX_LAYER_NUM);
+                    exit(-1);
+                }
+                strcpy(layers[layer_num].name, layer_name(datafilename));
+                layers[layer_num].track = make_layer_track(chunksize, ALGO_NUM);
+                track = &layers[layer_num++].track;
+            }
+
+            // 2. Changed lines (every line with full recompute)
+            changed_num = update_layer_track(track, image, line_num);
+            if (full) {
+                for (long l = 0; l < line_num; l++)
+                    track->changed[l] = l;
+                changed_num = track->changed_num = line_num;
+            }
+
+            // 3. Changed lines are gathered and compressed again
+            start = clock();
+            for (long c = 0; c < changed_num; c += line_batch) {
+                line_batch = changed_num - c < BATCH_DEFAULT_LINES ? changed_num - c : BATCH_DEFAULT_LINES;
+                for (int b = 0; b < line_batch; b++)
+                    memcpy(gathered + (long)b * chunksize, image + track->changed[c + b] * chunksize, chunksize);
+                for (int i = 0; i < ALGO_NUM; i++) {
+                    algo_batch_compression(i, gathered, line_batch, &batch);
+                    for (int b = 0; b < line_batch; b++)
+                        record_line_result(track, i, track->changed[c + b], batch.sizes[b], batch.encodings[b]);
+                }
+            }
+            compress_clocks += clock() - start;
+
+#ifdef VERBOSE
+            printf("%s: %ld/%ld lines changed\n", datafilename, changed_num, line_num);
+#endif
+            total_lines += line_num;
+            total_changed += changed_num;
+
+            fprintf(logfilefp, "%d,%s,%ld,%ld", checkpoint, layer_name(datafilename), line_num, changed_num);
+            for (int i = 0; i < ALGO_NUM; i++)
+                fprintf(logfilefp, ",%.4f", layer_track_ratio(track, i));
+            for (int i = 0; i < ALGO_NUM; i++)
+                for (int e = 0; has_encodings[i] && e < TRACK_ENCODING_NUM; e++)
+                    fprintf(logfilefp, ",%.4f", line_num > 0 ? (double)track->encoding_counts[i * TRACK_ENCODING_NUM + e] / line_num : 0);
+            fprintf(logfilefp, "\n");
+
+            free(image);
+        }
+        fclose(filelistfp);
+
+        printf("changed lines: %ld/%ld (%.2f%%)  compression time: %.3fs\n", total_changed, total_lines,
+               total_lines > 0 ? (double)total_changed / total_lines * 100 : 0, (double)compress_clocks / CLOCKS_PER_SEC);
+        checkpoint += 1;
+    }
+
+    for (int t = 0; t < layer_num; t++)
+        remove_layer_track(layers[t].track);
+    free(layers);
+    free(gathered);
+    remove_batch_result(batch);
+    fclose(listfp);
+    fclose(logfilefp);
+
+    return 0;
+}
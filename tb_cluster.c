@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compression.h"
+#include "lsh_cluster.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for LSH clustering compression
+ *   Lines of each layer file are clustered with a fresh LshClusterTable and encoded as delta
+ *   against their cluster representative. The table storage (representative lines) is a
+ *   per-layer cost, so the ratio is reported both without and with it.
+ *
+ * Usage: tb_cluster <filelist> <chunksize> [maxiter (-1: whole file)] [logfile] [index bits]
+ *
+ * Output columns: layer name, number of lines, number of clusters, cluster table size,
+ * BDI ratio, LSH ratio (lines only), LSH ratio (lines + cluster table)
+ */
+
+int main(int argc, char const *argv[]) {
+    MemoryChunk chunk;
+    CompressionResult result;
+    LshClusterTable table;
+    int chunksize, iter, maxiter = -1, index_bits = LSH_DEFAULT_BITS;
+    long filesize, table_size;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/cluster.csv";
+
+    long  bdi_size, lsh_size, original_size;
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        index_bits = atoi(argv[5]);
+
+    if (index_bits < 0 || index_bits > LSH_MAX_BITS) {
+        fprintf(stderr, "[ERROR] Invalid cluster index bitwidth %d (0 ~ %d)\n", index_bits, LSH_MAX_BITS);
+        exit(-1);
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    chunk = make_memory_chunk(chunksize, 0);
+
+    fprintf(logfilefp, "%s\n", "Layer Name,Lines,Clusters,Cluster Table Size,BDI,LSH,LSH+Table");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
+
+        table = make_lsh_cluster_table(index_bits, chunksize);
+        iter = 0;
+        original_size = 0;
+        bdi_size = 0;
+        lsh_size = 0;
+
+        for (long i = 0; (i < filesize) && (maxiter < 0 || iter < maxiter); i += chunksize) {
+            memset(chunk.body, 0, chunksize);
+            fread(chunk.body, 1, chunksize, fp);
+
+            result = bdi_compression(chunk);
+            bdi_size += result.compressed.size;
+            remove_compression_result(result);
+
+            result = lsh_cluster_compression(&table, chunk);
+            lsh_size += result.compressed.size;
+#ifdef VERBOSE
+            printf("clustered: %s  size: %dBytes  result: ", get_value_bitwise(result.tag_overhead.body, 0, 1) ? "true" : "false", result.compressed.size);
+            print_memory_chunk(result.compressed);
+            printf("\n");
+#endif
+            remove_compression_result(result);
+
+            iter += 1;
+            original_size += chunksize;
+#ifndef VERBOSE
+            if (iter % 1024 == 0)
+                printf("\r[ITER %2d] offset: %ldBytes  clusters: %d", iter, i, table.cluster_num);
+#endif
+        }
+
+        fclose(fp);
+
+        table_size = lsh_cluster_table_size(table);
+        printf("\nlines: %d  clusters: %d  table size: %ldBytes\n", iter, table.cluster_num, table_size);
+        printf("compression ratio: %.4f(BDI) %.4f(LSH) %.4f(LSH+Table)\n",
+               (double)original_size / bdi_size, (double)original_size / lsh_size, (double)original_size / (lsh_size + table_size));
+        fprintf(logfilefp, "%s,%d,%d,%ld,%.4f,%.4f,%.4f\n", datafilename, iter, table.cluster_num, table_size,
+                (double)original_size / bdi_size, (double)original_size / lsh_size, (double)original_size / (lsh_size + table_size));
+
+        remove_lsh_cluster_table(table);
+    }
+
+    remove_memory_chunk(chunk);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
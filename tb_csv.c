@@ -1,44 +1,97 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "compression.h"
-#include "bdi_zerovec.h"
+#include "tb_algorithms.h"
+#include "line_sampling.h"
+#include "result_cache.h"
+#include "read_ahead.h"
+#include "checkpoint_delta.h"
 
 // Verbose parameter
 // #define VERBOSE  // Comment this line not to display debug messages
 
-// Number of algorithms in test
-#define ALGO_NUM         8
 #define FILENAME_BUFSIZ  2048
+#define SWEEP_MAX_NUM    16  // maximum number of chunk sizes in a sweep
 
 
+/*
+ * Testbench for compression algorithm comparison
+ *   Without sampling mode, the first maxiter lines of each file are compressed. With uniform (1) or
+ *   stratified (2) sampling, lines are drawn across the whole file with the given seed until every
+ *   algorithm reaches the target precision (relative half width of 95% CI, 0: disabled) or maxiter
+ *   lines are sampled (-1: unlimited). Each algorithm stops at its own precision, so its result
+ *   does not depend on the other algorithms in test. Half widths are logged to '<logfile>_ci.csv'.
+ *
+ *   With result cache file, results are cached per file content, chunk size, algorithm version
+ *   and options, and only algorithms without cached result are computed.
+ *
+ *   Chunk size can be a comma separated list (e.g. 32,64,128), and every size is computed in a
+ *   single pass over each file: the file is read in blocks of the largest size, and each block is
+ *   split into lines of every size. Each size compresses the same lines as a run with that size
+ *   alone. When sampling, one line of each size is drawn from every sampled block instead.
+ *
+ *   Blocks are read ahead by a reader thread (read_ahead.h) into a pool of buffers while the lines
+ *   of blocks read before are compressed, and the time of each stage is reported per file.
+ *
+ *   With reference filelist (checkpoint delta mode), each layer is compressed as its delta against
+ *   the layer on the same line of the reference filelist (checkpoint_delta.h), e.g. a fine-tuned
+ *   model against its pretrained base. The delta is XOR (0) or subtraction (1) of elements of the
+ *   given size, and is computed per block against the mapped reference file.
+ *
+ * Usage: tb_csv <filelist> <chunksize[,chunksize...]> [maxiter] [logfile] [sampling mode] [seed] [precision] [cache file] [reference filelist] [delta mode] [delta element size]
+ */
+
+typedef struct {
+    int             chunksize;                // size of lines
+    long            line_num;                 // number of lines in the file
+    int             iter;                     // number of compressed lines
+    long            original_size;            // total size of compressed lines
+    long            algo_sizes[ALGO_NUM];     // total compressed size of each algorithm
+    RatioEstimator  estimators[ALGO_NUM];     // ratio estimator of each algorithm (sampling mode)
+    CachedResult   *cached[ALGO_NUM];         // cached result of each algorithm (NULL: not cached)
+    Bool            algo_active[ALGO_NUM];    // whether each algorithm needs more lines
+    int             active_num;               // number of active algorithms
+    char            options[RESULT_CACHE_OPTION_SIZ];  // options of cached results
+} SweepState;
+
 int main(int argc, char const *argv[]) {
-    MemoryChunk chunk;
+    MemoryChunk block, chunk;
     CompressionResult result;
-    int chunksize, iter, maxiter = 500, filesize;
+    LineSampler sampler, drawn_sampler;
+    ReadAhead *pipeline;
+    ReadAheadBatch *batch;
+    SweepState sweep[SWEEP_MAX_NUM];
+    SweepState *state;
+    int blocksize = 0, sweep_num = 0, maxiter = 500, mode = SAMPLE_SEQUENTIAL, stratum, samples;
+    long filesize, block_idx, line, offset, subline_num;
+    uint64_t seed = SAMPLE_DEFAULT_SEED;
+    double precision = 0, ratio, half_width;
+    int active_num;
+    long drawn;
+    Bool end_of_samples;
+    double stage_start, stage_sec;
+    ResultCache cache;
+    CachedResult entry;
+    uint64_t content_hash = 0;
+    char const *cachefilename = NULL;
+    DeltaReference reference;
+    int delta_mode = DELTA_XOR, delta_element_size = DELTA_DEFAULT_ELEMENT;
+    long delta_size;
+    char const *reflistfilename = NULL;
+    FILE *reflistfp = NULL;
 
     char datafilename[FILENAME_BUFSIZ];
+    char reffilename[FILENAME_BUFSIZ];
+    char cifilename[FILENAME_BUFSIZ];
+    char sizelist[FILENAME_BUFSIZ];
     char const *filename;
     char const *logfilename = "./logs/comparison.csv";
-
-    char *algo_names[ALGO_NUM] = {"BDI", "FPC", "BDI 2B", "BDI+ZR", "ZeroVec", "ZerosRun", "BDI+ZE", "BDI+ZV"};
-    int   algo_sizes[ALGO_NUM];
-    int   original_size;
-
-    CompressionResult (*algo_funcs[ALGO_NUM]) (CacheLine original) = {
-        bdi_compression,          // BDI
-        fpc_compression,          // FPC
-        bdi_twobase_compression,  // BDI with two bases
-        bdi_zr_compression,       // BDI with zeros run
-        zero_vec_compression,     // Zero Vector
-        zeros_run_compression,    // Zeros Run
-        bdi_ze_compression,       // BDI with zero encoding
-        bdi_zv_compression,       // BDI with zero vector
-    };
+    FILE *cifilefp = NULL;
 
     if (argc > 2) {
         filename = argv[1];
-        chunksize = atoi(argv[2]);
+        strncpy(sizelist, argv[2], FILENAME_BUFSIZ-1);
+        sizelist[FILENAME_BUFSIZ-1] = 0;
     } else {
         fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
         exit(-1);
@@ -48,73 +101,364 @@ int main(int argc, char const *argv[]) {
         maxiter = atoi(argv[3]);
     if (argc > 4)
         logfilename = argv[4];
+    if (argc > 5)
+        mode = atoi(argv[5]);
+    if (argc > 6)
+        seed = strtoull(argv[6], NULL, 0);
+    if (argc > 7)
+        precision = atof(argv[7]);
+    if (argc > 8 && strcmp(argv[8], "-") != 0)
+        cachefilename = argv[8];
+    if (argc > 9 && strcmp(argv[9], "-") != 0)
+        reflistfilename = argv[9];
+    if (argc > 10)
+        delta_mode = atoi(argv[10]);
+    if (argc > 11)
+        delta_element_size = atoi(argv[11]);
+
+    for (char *token = strtok(sizelist, ","); token != NULL && sweep_num < SWEEP_MAX_NUM; token = strtok(NULL, ",")) {
+        sweep[sweep_num].chunksize = atoi(token);
+        if (sweep[sweep_num].chunksize <= 0) {
+            fprintf(stderr, "[ERROR] Invalid memory chunk size '%s'\n", token);
+            exit(-1);
+        }
+        if (sweep[sweep_num].chunksize > blocksize)
+            blocksize = sweep[sweep_num].chunksize;
+        sweep_num += 1;
+    }
+
+    for (int k = 0; k < sweep_num; k++) {
+        if (blocksize % sweep[k].chunksize != 0) {
+            fprintf(stderr, "[ERROR] Memory chunk size %d does not divide the largest size %d\n", sweep[k].chunksize, blocksize);
+            exit(-1);
+        }
+
+        // lines drawn from blocks of larger size are a different sample from lines drawn directly
+        if (mode == SAMPLE_SEQUENTIAL)
+            sprintf(sweep[k].options, "maxiter=%d;mode=%d", maxiter, mode);
+        else if (sweep[k].chunksize == blocksize)
+            sprintf(sweep[k].options, "maxiter=%d;mode=%d;seed=%llu;precision=%g", maxiter, mode, (unsigned long long)seed, precision);
+        else
+            sprintf(sweep[k].options, "maxiter=%d;mode=%d;seed=%llu;precision=%g;block=%d", maxiter, mode, (unsigned long long)seed, precision, blocksize);
+        if (mode == SAMPLE_STRATIFIED)
+            sprintf(sweep[k].options + strlen(sweep[k].options), ";estimator=%d", SAMPLE_ESTIMATOR_VERSION);
+        if (reflistfilename != NULL)
+            sprintf(sweep[k].options + strlen(sweep[k].options), ";delta=%d;element=%d", delta_mode, delta_element_size);
+    }
+
+    if (reflistfilename != NULL) {
+        if ((delta_mode != DELTA_XOR && delta_mode != DELTA_SUBTRACT) || (delta_mode == DELTA_SUBTRACT &&
+             (delta_element_size <= 0 || delta_element_size > 8 || blocksize % delta_element_size != 0))) {
+            fprintf(stderr, "[ERROR] Invalid delta mode %d or element size %d (size must divide memory chunk size)\n", delta_mode, delta_element_size);
+            exit(-1);
+        }
+        reflistfp = fopen(reflistfilename, "rt");
+        if (reflistfp == NULL) {
+            fprintf(stderr, "[ERROR] Opening reference filelist '%s' failed\n", reflistfilename);
+            exit(-1);
+        }
+    }
 
     FILE *filelistfp = fopen(filename, "rt");
     FILE *logfilefp = fopen(logfilename, "wt");
 
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
     fprintf(logfilefp, "%s", "Layer Name");
-    for (int i = 0 ; i < ALGO_NUM; i++) {
-        fprintf(logfilefp, ",%s", algo_names[i]);
+    for (int k = 0; k < sweep_num; k++) {
+        for (int i = 0 ; i < ALGO_NUM; i++) {
+            if (sweep_num == 1) fprintf(logfilefp, ",%s", algo_names[i]);
+            else                fprintf(logfilefp, ",%s (%dB)", algo_names[i], sweep[k].chunksize);
+        }
     }
     fprintf(logfilefp, "\n");
 
+    if (mode != SAMPLE_SEQUENTIAL) {
+        strncpy(cifilename, logfilename, FILENAME_BUFSIZ-8);
+        cifilename[FILENAME_BUFSIZ-8] = 0;
+        if (strlen(cifilename) > 4 && strcmp(cifilename + strlen(cifilename) - 4, ".csv") == 0)
+            cifilename[strlen(cifilename) - 4] = 0;
+        strcat(cifilename, "_ci.csv");
+
+        cifilefp = fopen(cifilename, "wt");
+        if (cifilefp == NULL) {
+            fprintf(stderr, "[ERROR] Opening logfile '%s' failed\n", cifilename);
+            exit(-1);
+        }
+
+        fprintf(cifilefp, "%s", "Layer Name,Samples");
+        for (int k = 0; k < sweep_num; k++) {
+            for (int i = 0 ; i < ALGO_NUM; i++) {
+                if (sweep_num == 1) fprintf(cifilefp, ",%s", algo_names[i]);
+                else                fprintf(cifilefp, ",%s (%dB)", algo_names[i], sweep[k].chunksize);
+            }
+        }
+        fprintf(cifilefp, "\n");
+    }
+
+    if (cachefilename != NULL)
+        cache = open_result_cache(cachefilename);
+
     while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
         if (datafilename[strlen(datafilename)-1] == '\n')
             datafilename[strlen(datafilename)-1] = 0;
 
         FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
         fseek(fp, 0, SEEK_END);
         filesize = ftell(fp);
-        fclose(fp);
 
-        printf("Reading %s (filesize: %dBytes)\n", datafilename, filesize);
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
 
-        for (int i = 0; i < ALGO_NUM; i++)
-            algo_sizes[i] = 0;
+        reference.body = NULL;
+        if (reflistfp != NULL) {
+            if (!fgets(reffilename, FILENAME_BUFSIZ-1, reflistfp)) {
+                fprintf(stderr, "[ERROR] No reference file for '%s' in reference filelist\n", datafilename);
+                exit(-1);
+            }
+            if (reffilename[strlen(reffilename)-1] == '\n')
+                reffilename[strlen(reffilename)-1] = 0;
 
-        iter = 0;
-        original_size = 0;
+            reference = open_delta_reference(reffilename, delta_mode, delta_element_size);
+            if (reference.body == NULL)
+                exit(-1);
+            printf("delta against %s (%s", reffilename, delta_mode == DELTA_XOR ? "XOR" : "subtraction");
+            if (delta_mode == DELTA_SUBTRACT)
+                printf(" of %dBytes elements", delta_element_size);
+            printf(")\n");
+            if (reference.size != filesize)
+                printf("[WARNING] Reference size %ldBytes differs from filesize (compared against zeros after its end)\n", reference.size);
+        }
 
-        for (int i = 0; (i < filesize) && (iter < maxiter); i += chunksize) {
-            chunk = file2memorychunk(datafilename, i, chunksize);
+        sampler = make_line_sampler((filesize + blocksize - 1) / blocksize, mode, seed);
+        if (cachefilename != NULL) {
+            content_hash = file_content_hash(fp);
+            if (reflistfp != NULL) {
+                FILE *reffp = fopen(reffilename, "rb");
+                content_hash = content_hash * 0x9e3779b97f4a7c15ULL ^ file_content_hash(reffp);  // result depends on both files
+                fclose(reffp);
+            }
+        }
+
+        active_num = 0;
+        for (int k = 0; k < sweep_num; k++) {
+            state = &sweep[k];
+            state->line_num = (filesize + state->chunksize - 1) / state->chunksize;
+            state->iter = 0;
+            state->original_size = 0;
+            state->active_num = 0;
+            for (int i = 0; i < ALGO_NUM; i++) {
+                state->algo_sizes[i] = 0;
+                state->estimators[i] = make_ratio_estimator(sampler);
+                state->cached[i] = NULL;
+                if (cachefilename != NULL)
+                    state->cached[i] = lookup_result_cache(&cache, content_hash, state->chunksize, algo_names[i], algo_versions[i], state->options);
+                state->algo_active[i] = state->cached[i] == NULL;
+                state->active_num += state->algo_active[i];
+            }
+            active_num += state->active_num;
+        }
+
+        if (cachefilename != NULL)
+            printf("cached results: %d/%d algorithms\n", ALGO_NUM * sweep_num - active_num, ALGO_NUM * sweep_num);
+
+        // sampling of each size stops at the number of its lines in the file (compressing the whole file is cheaper)
+        pipeline = make_read_ahead(fp, filesize, blocksize, READ_AHEAD_DEPTH);
+        end_of_samples = sampler.line_num <= 0;
+        drawn = 0;
+        stage_start = read_ahead_clock();
+
+        while (active_num > 0) {
+            // 1. Keep the pool of buffers filled with blocks to compress next (read by reader thread)
+            while (!end_of_samples && (batch = read_ahead_reserve(pipeline)) != NULL) {
+                while (batch->block_num < READ_AHEAD_BATCH) {
+                    block_idx = next_sample_line(&sampler, &stratum);
+                    if (block_idx * blocksize >= filesize) {  // end of file (sequential)
+                        end_of_samples = TRUE;
+                        break;
+                    }
+                    batch->block_idx[batch->block_num] = block_idx;
+                    batch->tags[batch->block_num++] = stratum;
+                }
+                if (batch->block_num == 0) break;
+                read_ahead_submit(pipeline);
+            }
+
+            // 2. Compress blocks of the oldest buffer
+            batch = read_ahead_next(pipeline);
+            if (batch == NULL) break;  // every sampled block is compressed
+
+            for (int b = 0; b < batch->block_num && active_num > 0; b++) {
+                block_idx = batch->block_idx[b];
+                stratum = batch->tags[b];
+                block.body = batch->body + (long)b * blocksize;
+                if (reference.body != NULL) {  // zero padding after the end of the file is kept
+                    delta_size = filesize - block_idx * blocksize < blocksize ? filesize - block_idx * blocksize : blocksize;
+                    checkpoint_delta(reference, block.body, block_idx * blocksize, delta_size);
+                }
+                drawn_sampler = sampler;
+                drawn_sampler.drawn = ++drawn;  // sampler as it was right after drawing this block
+
+                for (int k = 0; k < sweep_num; k++) {
+                    state = &sweep[k];
+                    subline_num = blocksize / state->chunksize;
+                    if ((filesize - block_idx * blocksize) < blocksize)  // last block of the file
+                        subline_num = (filesize - block_idx * blocksize + state->chunksize - 1) / state->chunksize;
+
+                    for (long j = 0; j < subline_num && state->active_num > 0; j++) {
+                        if (maxiter >= 0 && state->iter >= maxiter) break;
+                        if (mode != SAMPLE_SEQUENTIAL) {
+                            if (state->iter >= state->line_num || j > 0) break;
+                            j = sample_subline(drawn_sampler, block_idx, state->chunksize, subline_num);
+                        }
+
+                        line = block_idx * (blocksize / state->chunksize) + j;
+                        offset = line * state->chunksize;
+                        chunk.body = block.body + (offset - block_idx * blocksize);
+                        chunk.size = state->chunksize;
+                        chunk.valid_bitwidth = state->chunksize * BYTE_BITWIDTH;
 #ifdef VERBOSE
-            printf("original: ");
-            print_memory_chunk(chunk);
-            printf("\n");
+                        printf("original: ");
+                        print_memory_chunk(chunk);
+                        printf("\n");
 #endif
-            for (int j = 0; j < ALGO_NUM; j++) {
-                result = algo_funcs[j](chunk);
-                algo_sizes[j] += result.compressed.size;
+                        for (int i = 0; i < ALGO_NUM; i++) {
+                            if (!state->algo_active[i]) continue;
+                            result = algo_funcs[i](chunk);
+                            state->algo_sizes[i] += result.compressed.size;
+                            add_ratio_sample(&state->estimators[i], stratum, result.compressed.size);
 #ifdef VERBOSE
-                printf("%8s size: %dBytes  result: ", algo_names[j], result.compressed.size);
-                print_memory_chunk(result.compressed);
-                printf("\n");
+                            printf("%8s size: %dBytes  result: ", algo_names[i], result.compressed.size);
+                            print_memory_chunk(result.compressed);
+                            printf("\n");
 #endif
-                remove_compression_result(result);
-            }
+                            remove_compression_result(result);
+                        }
 #ifdef VERBOSE
-            printf("\n");
+                        printf("\n");
 #endif
+                        state->iter += 1;
+                        state->original_size += state->chunksize;
+
+                        // check precision of every algorithm once per round of strata
+                        if (mode != SAMPLE_SEQUENTIAL && precision > 0 && state->iter >= SAMPLE_MIN_NUM && state->iter % sampler.strata_num == 0) {
+                            for (int i = 0; i < ALGO_NUM; i++) {
+                                if (!state->algo_active[i]) continue;
+                                ratio = estimate_ratio(state->estimators[i], state->chunksize, &half_width);
+                                if (half_width <= precision * ratio) {
+                                    state->algo_active[i] = FALSE;  // target precision reached
+                                    state->active_num -= 1;
+                                }
+                            }
+                        }
+                    }
+
+                    // size is done when it reached maxiter or the number of its lines
+                    if ((maxiter >= 0 && state->iter >= maxiter) || (mode != SAMPLE_SEQUENTIAL && state->iter >= state->line_num)) {
+                        for (int i = 0; i < ALGO_NUM; i++)
+                            state->algo_active[i] = FALSE;
+                        state->active_num = 0;
+                    }
+                }
+
+                active_num = 0;
+                for (int k = 0; k < sweep_num; k++)
+                    active_num += sweep[k].active_num;
+
 #ifndef VERBOSE
-            printf("\r[ITER %2d] offset: %dBytes  size: %dBytes", iter+1, i, chunksize);
+                printf("\r[ITER %2ld] offset: %ldBytes  size: %dBytes", block_idx+1, block_idx * blocksize, blocksize);
 #endif
-            remove_memory_chunk(chunk);
-            iter += 1;
-            original_size += chunksize;
+            }
+
+            read_ahead_release(pipeline);
         }
 
+        stage_sec = read_ahead_clock() - stage_start;
+        printf("\nread: %.2fs  stall: %.2fs  compression: %.2fs  (%.2fMB read, reader idle: %.2fs)", pipeline->read_sec,
+               pipeline->consumer_wait_sec, stage_sec - pipeline->consumer_wait_sec, (double)pipeline->bytes_read / (1 << 20), pipeline->reader_wait_sec);
+        remove_read_ahead(pipeline);
+        close_delta_reference(reference);
+
+
+        fclose(fp);
+
         printf("\ncompression ratio: ");
         fprintf(logfilefp, "%s", datafilename);
-        for (int i = 0; i < ALGO_NUM; i++) {
-            printf("%.4f(%s) ", (double)original_size / algo_sizes[i], algo_names[i]);
-            fprintf(logfilefp, ",%.4f", (double)original_size / algo_sizes[i]);
+
+        samples = 0;
+        for (int k = 0; k < sweep_num; k++) {
+            if (sweep[k].iter > samples)
+                samples = sweep[k].iter;
+            for (int i = 0; i < ALGO_NUM; i++) {
+                if (sweep[k].cached[i] != NULL && sweep[k].cached[i]->samples > samples)
+                    samples = sweep[k].cached[i]->samples;  // lines sampled for the cached results
+            }
+        }
+        if (cifilefp != NULL)
+            fprintf(cifilefp, "%s,%d", datafilename, samples);
+
+        for (int k = 0; k < sweep_num; k++) {
+            state = &sweep[k];
+            if (sweep_num > 1)
+                printf("\n  [%dBytes] ", state->chunksize);
+
+            for (int i = 0; i < ALGO_NUM; i++) {
+                if (state->cached[i] != NULL) {
+                    ratio = state->cached[i]->ratio;
+                    half_width = state->cached[i]->half_width;
+                } else if (mode == SAMPLE_SEQUENTIAL) {
+                    ratio = (double)state->original_size / state->algo_sizes[i];
+                    half_width = 0;
+                } else {
+                    ratio = estimate_ratio(state->estimators[i], state->chunksize, &half_width);
+                }
+
+                if (state->cached[i] == NULL && cachefilename != NULL) {
+                    entry.content_hash = content_hash;
+                    entry.chunk_size = state->chunksize;
+                    strncpy(entry.algo_name, algo_names[i], RESULT_CACHE_NAME_SIZ-1);
+                    entry.algo_name[RESULT_CACHE_NAME_SIZ-1] = 0;
+                    entry.algo_version = algo_versions[i];
+                    strcpy(entry.options, state->options);
+                    entry.samples = state->estimators[i].counts[0];
+                    for (int s = 1; s < state->estimators[i].strata_num; s++)
+                        entry.samples += state->estimators[i].counts[s];
+                    entry.ratio = ratio;
+                    entry.half_width = half_width;
+                    insert_result_cache(&cache, entry);
+                }
+
+                if (mode == SAMPLE_SEQUENTIAL) {
+                    printf("%.4f(%s) ", ratio, algo_names[i]);
+                    fprintf(logfilefp, ",%.4f", ratio);
+                } else {
+                    printf("%.4f+-%.4f(%s) ", ratio, half_width, algo_names[i]);
+                    fprintf(logfilefp, ",%.4f", ratio);
+                    fprintf(cifilefp, ",%.4f", half_width);
+                }
+                remove_ratio_estimator(state->estimators[i]);
+            }
         }
         printf("\n");
         fprintf(logfilefp, "\n");
+        if (cifilefp != NULL)
+            fprintf(cifilefp, "\n");
     }
 
+    if (cachefilename != NULL)
+        close_result_cache(cache);
     fclose(filelistfp);
     fclose(logfilefp);
+    if (reflistfp != NULL)
+        fclose(reflistfp);
+    if (cifilefp != NULL)
+        fclose(cifilefp);
 
     return 0;
-}
\ No newline at end of file
+}
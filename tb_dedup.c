@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tb_algorithms.h"
+#include "line_dedup.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for cross-line deduplication
+ *   Every line of a layer file is hashed into a fixed-size DedupTable. Duplicated lines are
+ *   stored once, and each compression algorithm is applied only to the unique lines. Every line
+ *   (unique or not) keeps a DEDUP_REF_SIZE reference to its stored line, which is charged to
+ *   the dedup sizes. A hash hit is confirmed by reading back the earlier line and comparing it,
+ *   and mismatching lines (hash collisions) are counted as unique.
+ *
+ * Usage: tb_dedup <filelist> <chunksize> [maxiter (-1: whole file)] [logfile] [table bits]
+ *
+ * Output columns: layer name, number of lines, number of unique lines, dedup ratio and the
+ * compression ratio of dedup followed by each algorithm
+ */
+
+int main(int argc, char const *argv[]) {
+    MemoryChunk chunk, seen;
+    CompressionResult result;
+    DedupTable table;
+    int chunksize, iter, maxiter = -1, table_bits = DEDUP_DEFAULT_BITS;
+    long filesize, unique_lines, collided_lines, seen_offset;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/dedup.csv";
+
+    long  algo_sizes[ALGO_NUM];
+    long  original_size, unique_size, ref_size;
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        table_bits = atoi(argv[5]);
+
+    if (table_bits < 1 || table_bits > DEDUP_MAX_BITS) {
+        fprintf(stderr, "[ERROR] Invalid hash table bitwidth %d (1 ~ %d)\n", table_bits, DEDUP_MAX_BITS);
+        exit(-1);
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    table = make_dedup_table(table_bits);
+    chunk = make_memory_chunk(chunksize, 0);
+    seen = make_memory_chunk(chunksize, 0);
+
+    fprintf(logfilefp, "%s", "Layer Name,Lines,Unique Lines,Dedup");
+    for (int i = 0 ; i < ALGO_NUM; i++) {
+        fprintf(logfilefp, ",Dedup+%s", algo_names[i]);
+    }
+    fprintf(logfilefp, "\n");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        FILE *seenfp = fopen(datafilename, "rb");  // reads back earlier lines on hash hits
+        if (fp == NULL || seenfp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            if (fp != NULL) fclose(fp);
+            if (seenfp != NULL) fclose(seenfp);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
+
+        for (int i = 0; i < ALGO_NUM; i++)
+            algo_sizes[i] = 0;
+
+        reset_dedup_table(&table);
+        iter = 0;
+        unique_lines = 0;
+        collided_lines = 0;
+        original_size = 0;
+        unique_size = 0;
+
+        for (long i = 0; (i < filesize) && (maxiter < 0 || iter < maxiter); i += chunksize) {
+            memset(chunk.body, 0, chunksize);
+            fread(chunk.body, 1, chunksize, fp);
+
+            iter += 1;
+            original_size += chunksize;
+
+            seen_offset = dedup_lookup_insert(&table, line_hash64(chunk.body, chunksize), i);
+            if (seen_offset >= 0) {
+                memset(seen.body, 0, chunksize);
+                fseek(seenfp, seen_offset, SEEK_SET);
+                fread(seen.body, 1, chunksize, seenfp);
+
+                if (memcmp(seen.body, chunk.body, chunksize) == 0) {
+#ifdef VERBOSE
+                    printf("duplicated line at offset %ldBytes (first seen at %ldBytes)\n", i, seen_offset);
+#endif
+                    continue;
+                }
+                collided_lines += 1;
+            }
+
+            unique_lines += 1;
+            unique_size += chunksize;
+
+            for (int j = 0; j < ALGO_NUM; j++) {
+                result = algo_funcs[j](chunk);
+                algo_sizes[j] += result.compressed.size;
+                remove_compression_result(result);
+            }
+#ifndef VERBOSE
+            if (iter % 1024 == 0)
+                printf("\r[ITER %2d] offset: %ldBytes  unique: %ld", iter, i, unique_lines);
+#endif
+        }
+
+        fclose(fp);
+        fclose(seenfp);
+
+        if (table.overflowed > 0)
+            printf("\n[WARNING] dedup table is full (%ld lines not indexed), increase table bits", table.overflowed);
+        if (collided_lines > 0)
+            printf("\n[WARNING] %ld lines collided with a different line of the same hash (counted as unique)", collided_lines);
+
+        ref_size = (long)iter * DEDUP_REF_SIZE;
+
+        printf("\nlines: %d  unique lines: %ld  dedup ratio: %.4f\ncompression ratio: ",
+               iter, unique_lines, (double)original_size / (unique_size + ref_size));
+        fprintf(logfilefp, "%s,%d,%ld,%.4f", datafilename, iter, unique_lines, (double)original_size / (unique_size + ref_size));
+        for (int i = 0; i < ALGO_NUM; i++) {
+            printf("%.4f(Dedup+%s) ", (double)original_size / (algo_sizes[i] + ref_size), algo_names[i]);
+            fprintf(logfilefp, ",%.4f", (double)original_size / (algo_sizes[i] + ref_size));
+        }
+        printf("\n");
+        fprintf(logfilefp, "\n");
+    }
+
+    remove_memory_chunk(chunk);
+    remove_memory_chunk(seen);
+    remove_dedup_table(table);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
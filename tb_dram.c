@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tb_algorithms.h"
+#include "dram_model.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for DRAM traffic of compressed lines
+ *   Lines of a layer file are compressed in batches by each algorithm (batch_compression.h), and
+ *   the compressed size of each line is mapped onto DRAM bursts (dram_model.h). Byte ratio, bytes
+ *   on the bus, burst savings and modeled effective bandwidth are reported per layer, so that byte
+ *   ratios which do not reduce the number of bursts can be told apart from actual traffic savings.
+ *
+ * Usage: tb_dram <filelist> <chunksize> [maxiter (-1: whole file)] [logfile] [burst size] [metadata mode (0: ECC, 1: separate)] [metadata hit rate] [peak bandwidth (GB/s)]
+ *
+ * Output columns: layer name, number of lines, original bytes on the bus, and then byte ratio,
+ * bytes on the bus, burst savings and effective bandwidth (GB/s) of each algorithm
+ */
+
+int main(int argc, char const *argv[]) {
+    BatchResult batch;
+    DramConfig config;
+    DramTraffic traffic[ALGO_NUM];
+    int chunksize, iter, line_num, maxiter = -1, burst_size = DRAM_DEFAULT_BURST, metadata_mode = DRAM_META_IN_ECC;
+    double meta_hit_rate = 0.9, bandwidth = DRAM_DEFAULT_BANDWIDTH;
+    long filesize;
+    ByteArr lines;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/dram.csv";
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        burst_size = atoi(argv[5]);
+    if (argc > 6)
+        metadata_mode = atoi(argv[6]);
+    if (argc > 7)
+        meta_hit_rate = atof(argv[7]);
+    if (argc > 8)
+        bandwidth = atof(argv[8]);
+
+    if (chunksize <= 0 || burst_size <= 0) {
+        fprintf(stderr, "[ERROR] Invalid memory chunk size %d or burst size %d\n", chunksize, burst_size);
+        exit(-1);
+    }
+
+    config = make_dram_config(burst_size, metadata_mode, meta_hit_rate, bandwidth);
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    printf("burst: %dBytes  metadata: %s", burst_size, metadata_mode == DRAM_META_SEPARATE ? "separate" : "ECC");
+    if (metadata_mode == DRAM_META_SEPARATE)
+        printf(" (hit rate: %.2f)", config.meta_hit_rate);
+    printf("  peak bandwidth: %.1fGB/s\n", bandwidth);
+
+    lines = (ByteArr)malloc((long)BATCH_DEFAULT_LINES * chunksize);
+    batch = make_batch_result(BATCH_DEFAULT_LINES, chunksize, FALSE);
+
+    fprintf(logfilefp, "%s", "Layer Name,Lines,Original Bytes");
+    for (int i = 0 ; i < ALGO_NUM; i++) {
+        fprintf(logfilefp, ",%s Ratio,%s Bytes,%s Burst Savings,%s GB/s", algo_names[i], algo_names[i], algo_names[i], algo_names[i]);
+    }
+    fprintf(logfilefp, "\n");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        printf("Reading %s (filesize: %ldBytes)\n", datafilename, filesize);
+
+        for (int i = 0; i < ALGO_NUM; i++)
+            traffic[i] = make_dram_traffic();
+        iter = 0;
+
+        for (long i = 0; (i < filesize) && (maxiter < 0 || iter < maxiter); i += (long)line_num * chunksize) {
+            line_num = (filesize - i + chunksize - 1) / chunksize;
+            if (line_num > BATCH_DEFAULT_LINES)
+                line_num = BATCH_DEFAULT_LINES;
+            if (maxiter >= 0 && line_num > maxiter - iter)
+                line_num = maxiter - iter;
+
+            memset(lines, 0, (long)line_num * chunksize);  // last line of the file is zero padded
+            fread(lines, 1, (long)line_num * chunksize, fp);
+
+            for (int j = 0; j < ALGO_NUM; j++) {
+                algo_batch_compression(j, lines, line_num, &batch);
+                for (int l = 0; l < batch.line_num; l++)
+                    dram_add_line(&traffic[j], config, chunksize, batch.sizes[l]);
+            }
+
+            iter += line_num;
+#ifndef VERBOSE
+            printf("\r[ITER %2d] offset: %ldBytes", iter, i);
+#endif
+        }
+
+        fclose(fp);
+
+        printf("\nlines: %d  original: %ldBytes on the bus\n", iter, traffic[0].original_bursts * burst_size);
+        fprintf(logfilefp, "%s,%d,%ld", datafilename, iter, traffic[0].original_bursts * burst_size);
+        for (int i = 0; i < ALGO_NUM; i++) {
+            double ratio = traffic[i].compressed_bytes > 0 ? (double)traffic[i].original_bytes / traffic[i].compressed_bytes : 0;
+            printf("%-10s ratio: %.4f  bytes: %ld  burst savings: %6.2f%%  bandwidth: %.2fGB/s\n", algo_names[i], ratio,
+                   dram_transferred_bytes(traffic[i], config), dram_burst_savings(traffic[i]) * 100,
+                   dram_effective_bandwidth(traffic[i], config));
+            fprintf(logfilefp, ",%.4f,%ld,%.4f,%.2f", ratio, dram_transferred_bytes(traffic[i], config),
+                    dram_burst_savings(traffic[i]), dram_effective_bandwidth(traffic[i], config));
+        }
+        fprintf(logfilefp, "\n");
+    }
+
+    free(lines);
+    remove_batch_result(batch);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
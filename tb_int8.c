@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "compression.h"
+#include "int8_compression.h"
+#include "perf_counters.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+#define BENCH_NUM        5
+
+
+/*
+ * Throughput benchmark for int8 quantized tensor compression
+ *   Lines of each file are loaded into memory first, so that the benchmark excludes file I/O.
+ *   Each algorithm compresses every line (repeat times), and then decompresses every compressed
+ *   line, which is also checked against the original line. Decompression throughput only counts
+ *   compressed lines (uncompressed lines are stored as they are). Generic byte algorithms (BDI,
+ *   FPC, zero vector) are measured as baselines.
+ *
+ *   With counters enabled, compression and decompression loops are also measured with hardware
+ *   counters (perf_counters.h), and IPC, cycles, branch misses and L1D misses per line are reported.
+ *
+ * Usage: tb_int8 <filelist> <chunksize> [maxiter (-1: whole file)] [logfile] [repeat] [counters (0: off, 1: on)]
+ *
+ * Output columns: layer name, then compression ratio, compression and decompression throughput
+ * (MB/s) of each algorithm (and IPC, cycles, branch misses and L1D misses per line of compression
+ * and decompression with counters)
+ */
+
+static char *bench_names[BENCH_NUM] = {"BDI", "FPC", "ZeroVec", "INT8 BDI", "INT8 ZV"};
+
+static CompressionResult (*bench_comp_funcs[BENCH_NUM]) (CacheLine original) = {
+    bdi_compression,
+    fpc_compression,
+    zero_vec_compression,
+    int8_bdi_compression,
+    int8_zv_compression,
+};
+
+static DecompressionResult (*bench_decomp_funcs[BENCH_NUM]) (CacheLine compressed, MetaData tag_overhead, int original_size) = {
+    bdi_decompression,
+    NULL,  // FPC decompression is not measured (it overruns the line for some patterns)
+    zero_vec_decompression,
+    int8_decompression,
+    int8_decompression,
+};
+
+static void report_counters(FILE *logfilefp, char const *stage, PerfCounters counters, double line_num) {
+    double *values = counters.values;
+    double ipc = values[PERF_INSTRUCTIONS] / values[PERF_CYCLES];
+
+    if (line_num <= 0)
+        line_num = NAN;  // nothing measured
+
+    printf("  %-14s IPC: %.2f  cycles/line: %.1f  branch-misses/line: %.3f  L1D-misses/line: %.3f\n", stage, ipc,
+           values[PERF_CYCLES] / line_num, values[PERF_BRANCH_MISSES] / line_num, values[PERF_L1D_MISSES] / line_num);
+    fprintf(logfilefp, ",%.3f,%.2f,%.4f,%.4f", ipc, values[PERF_CYCLES] / line_num,
+            values[PERF_BRANCH_MISSES] / line_num, values[PERF_L1D_MISSES] / line_num);
+}
+
+int main(int argc, char const *argv[]) {
+    MemoryChunk chunk;
+    CompressionResult result, *results;
+    DecompressionResult restored;
+    int chunksize, line_num, maxiter = -1, repeat = 1, mismatch, decomp_lines;
+    Bool use_counters = FALSE;
+    PerfCounters counters, comp_counters;
+    long filesize, compressed_size;
+    clock_t start;
+    double comp_sec, decomp_sec, megabytes, decomp_megabytes;
+    ByteArr lines;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/int8.csv";
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        repeat = atoi(argv[5]);
+    if (argc > 6)
+        use_counters = atoi(argv[6]) != 0;
+
+    if (use_counters) {
+        counters = make_perf_counters();
+        if (!perf_counters_available(counters))
+            fprintf(stderr, "[WARNING] Hardware counters are not available (perf_event_open failed or not supported), counters are reported as nan\n");
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    fprintf(logfilefp, "%s", "Layer Name");
+    for (int i = 0; i < BENCH_NUM; i++) {
+        fprintf(logfilefp, ",%s Ratio,%s Comp MB/s,%s Decomp MB/s", bench_names[i], bench_names[i], bench_names[i]);
+        for (int d = 0; use_counters && d < 2; d++) {
+            char const *stage = d == 0 ? "Comp" : "Decomp";
+            fprintf(logfilefp, ",%s %s IPC,%s %s Cycles/Line,%s %s Branch Misses/Line,%s %s L1D Misses/Line",
+                    bench_names[i], stage, bench_names[i], stage, bench_names[i], stage, bench_names[i], stage);
+        }
+    }
+    fprintf(logfilefp, "\n");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        line_num = (filesize + chunksize - 1) / chunksize;
+        if (maxiter >= 0 && line_num > maxiter)
+            line_num = maxiter;
+
+        printf("Reading %s (filesize: %ldBytes  lines: %d)\n", datafilename, filesize, line_num);
+
+        lines = (ByteArr)calloc((long)line_num * chunksize + 1, 1);
+        fread(lines, 1, (long)line_num * chunksize, fp);
+        fclose(fp);
+
+        results = (CompressionResult *)malloc(sizeof(CompressionResult) * (line_num > 0 ? line_num : 1));
+        megabytes = (double)line_num * chunksize * repeat / (1 << 20);
+        chunk.size = chunksize;
+        chunk.valid_bitwidth = chunksize * BYTE_BITWIDTH;
+
+        fprintf(logfilefp, "%s", datafilename);
+
+        for (int i = 0; i < BENCH_NUM; i++) {
+            // 1. Compression throughput
+            if (use_counters)
+                perf_counters_start(&counters);
+            start = clock();
+            for (int r = 0; r < repeat - 1; r++) {
+                for (int l = 0; l < line_num; l++) {
+                    chunk.body = lines + (long)l * chunksize;
+                    result = bench_comp_funcs[i](chunk);
+                    remove_compression_result(result);
+                }
+            }
+            compressed_size = 0;
+            for (int l = 0; l < line_num; l++) {
+                chunk.body = lines + (long)l * chunksize;
+                results[l] = bench_comp_funcs[i](chunk);
+                compressed_size += results[l].compressed.size;
+            }
+            comp_sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+            if (use_counters) {
+                perf_counters_stop(&counters);
+                comp_counters = counters;
+            }
+
+            // 2. Decompression throughput (and verification)
+            decomp_sec = 0;
+            decomp_megabytes = 0;
+            mismatch = 0;
+            decomp_lines = 0;
+            if (use_counters)
+                perf_counters_start(&counters);
+            if (bench_decomp_funcs[i] != NULL) {
+                start = clock();
+                for (int r = 0; r < repeat; r++) {
+                    for (int l = 0; l < line_num; l++) {
+                        if (!results[l].is_compressed) continue;  // line is stored as it is
+                        restored = bench_decomp_funcs[i](results[l].compressed, results[l].tag_overhead, chunksize);
+                        if (r == 0 && (!restored.is_decompressed || memcmp(restored.original.body, lines + (long)l * chunksize, chunksize) != 0))
+                            mismatch += 1;
+                        remove_memory_chunk(restored.original);
+                    }
+                }
+                decomp_sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+                for (int l = 0; l < line_num; l++)
+                    decomp_lines += results[l].is_compressed;
+                decomp_megabytes = (double)decomp_lines * chunksize * repeat / (1 << 20);
+            }
+            if (use_counters)
+                perf_counters_stop(&counters);
+
+            for (int l = 0; l < line_num; l++)
+                remove_compression_result(results[l]);
+
+            if (mismatch > 0)
+                fprintf(stderr, "[ERROR] %s: %d lines are not restored\n", bench_names[i], mismatch);
+
+            printf("%-8s ratio: %.4f  compression: %.2fMB/s  decompression: %.2fMB/s\n", bench_names[i],
+                   (double)line_num * chunksize / compressed_size, megabytes / comp_sec, decomp_sec > 0 ? decomp_megabytes / decomp_sec : 0);
+            fprintf(logfilefp, ",%.4f,%.2f,%.2f", (double)line_num * chunksize / compressed_size,
+                    megabytes / comp_sec, decomp_sec > 0 ? decomp_megabytes / decomp_sec : 0);
+            if (use_counters) {
+                report_counters(logfilefp, "compression", comp_counters, (double)line_num * repeat);
+                report_counters(logfilefp, "decompression", counters, (double)decomp_lines * repeat);
+            }
+        }
+
+        fprintf(logfilefp, "\n");
+        free(results);
+        free(lines);
+    }
+
+    if (use_counters)
+        remove_perf_counters(counters);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
@@ -5,16 +5,20 @@ import argparse
 
 
 parser = argparse.ArgumentParser(description='Comparison Test Configs')
-parser.add_argument('-cs', '--csize', default=64, help='Cache line size (int)', dest='csize')
+parser.add_argument('-cs', '--csize', default=64, help='Cache line size (int, or comma separated list e.g. 32,64,128 for a single-pass sweep)', dest='csize')
 parser.add_argument('-mi', '--maxiter', default=5000, help='Max iteration of the file fetch (int)', dest='maxiter')
+parser.add_argument('-sm', '--sampling', default=0, help='Sampling mode (0: sequential, 1: uniform, 2: stratified)', dest='sampling')
+parser.add_argument('-sd', '--seed', default=24301, help='Seed of sampling (int)', dest='seed')
+parser.add_argument('-pr', '--precision', default=0, help='Target relative half width of 95% CI (float, 0: disabled)', dest='precision')
+parser.add_argument('-ca', '--cache', default=os.path.join(os.curdir, 'logs', 'result_cache.csv'), help='Result cache file (-: disabled)', dest='cache')
 comp_args, _ = parser.parse_known_args()
 
 tb_name = 'tb_csv.exe'
 if 'linux' in platform.platform().lower():
     tb_name = './tb_csv'
 
-print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0")
-subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0", shell=True, check=True)
+print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0")
+subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0", shell=True, check=True)
 #
 # out = subprocess.run(f"tb_csv.exe "
 #                f"{os.path.join(os.curdir, 'extractions', 'ResNet50_Imagenet', 'filelist.txt')} "
@@ -25,5 +29,5 @@ subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -W
 for model_name in os.listdir(os.path.join(os.curdir, 'extractions')):
     filelist_path = os.path.join(os.curdir, 'extractions', model_name, 'filelist.txt')
     result_path = os.path.join(os.curdir, 'extractions', model_name, 'comparison_results.csv')
-    print(f"\n{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}")
-    subprocess.run(f"{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}")
\ No newline at end of file
+    print(f"\n{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path} {comp_args.sampling} {comp_args.seed} {comp_args.precision} {comp_args.cache}")
+    subprocess.run(f"{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path} {comp_args.sampling} {comp_args.seed} {comp_args.precision} {comp_args.cache}")
\ No newline at end of file
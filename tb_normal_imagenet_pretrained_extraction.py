@@ -72,8 +72,8 @@ if __name__ == '__main__':
     if 'linux' in platform.platform().lower():
         tb_name = './tb_csv'
 
-    print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0")
-    subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0", shell=True, check=True)
+    print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0")
+    subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0", shell=True, check=True)
 
     for model_type, model_config in imagenet_pretrained.items():
         full_modelname = f"{model_type}_Imagenet"
@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "tb_algorithms.h"
+#include "page_store.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+#define REPLAY_SEED      0x5eed
+#define HOT_FRACTION     0.2   // share of pages in the hot set
+#define HOT_RATE         0.8   // share of accesses to the hot set
+#define MAX_THREAD_NUM   64
+
+
+/*
+ * Testbench for compressed page store (zswap-style memory tier)
+ *   Files in the filelist are split into pages, which are the working set. Accesses to the working
+ *   set are replayed against a page store (page_store.h) of each algorithm with decompression: 80%
+ *   of accesses go to a hot set of 20% of the pages (random, fixed by the seed). A page in the store
+ *   is loaded and checked against the original (hit), and a page not in the store is compressed
+ *   and stored (miss). When the pool is full, least recently used pages are evicted until the page
+ *   fits. Pool size is given as a share of the working set, so an algorithm with denser pool keeps
+ *   more pages in memory and has a higher hit rate.
+ *
+ *   Threads replay accesses to their own partition of pages (page index % threads) with their own
+ *   LRU list, sharing a single store (sharded locks). The store has one shard per thread unless
+ *   the number of shards is given.
+ *
+ *   Before reading the filelist, pages of 16B and 32B lines with each number of nonzero bytes are
+ *   stored and loaded with every algorithm, and the testbench fails if a page is not restored (run
+ *   with -fsanitize=address to check buffers of compressed pages).
+ *
+ *   Every shard keeps a partially filled slab per size class, so density is only meaningful once
+ *   slabs are amortized: with a pool smaller than a slab per class of each shard, it mostly
+ *   measures slab fragmentation (a warning is printed).
+ *
+ * Usage: tb_pagestore <filelist> <chunksize> [pool size (% of working set)] [accesses per page] [threads] [algorithm index (-1: all)] [logfile] [seed] [page size] [shards]
+ *
+ * Output columns: algorithm, pages of the working set, accesses, hit rate, resident pages, pages
+ * stored as they are, compression ratio and density (original / slab bytes) of resident pages,
+ * internal fragmentation (of size classes), slab bytes, store and load throughput (MB/s per thread)
+ * and replay time
+ */
+
+typedef struct {
+    PageStore   *store;
+    ByteArr      pages;         // working set
+    long         page_num;
+    int          page_size;
+    long        *hot_pages;     // pages of the hot set
+    long         hot_num;
+    int          thread_idx;
+    int          thread_num;
+    long         access_num;    // number of accesses of the thread
+    uint64_t     rng;           // state of random number generator (xorshift64*)
+    PageHandle  *handles;       // handle of each page (shared, a thread only uses its partition)
+    long        *lru_prev;      // LRU list of each thread (shared arrays, partitioned as handles)
+    long        *lru_next;
+    long         lru_head;      // most recently used page of the thread
+    long         lru_tail;      // least recently used page of the thread
+    long         hits;
+    long         misses;
+    long         rejected;      // pages not stored (pool is full without pages of the thread)
+    long         evictions;
+    long         mismatches;    // loaded pages different from the original
+    double       store_sec;
+    double       load_sec;
+} ReplayThread;
+
+static double replay_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t replay_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dULL;
+}
+
+static void lru_remove(ReplayThread *thread, long page) {
+    if (thread->lru_prev[page] >= 0) thread->lru_next[thread->lru_prev[page]] = thread->lru_next[page];
+    else                             thread->lru_head = thread->lru_next[page];
+    if (thread->lru_next[page] >= 0) thread->lru_prev[thread->lru_next[page]] = thread->lru_prev[page];
+    else                             thread->lru_tail = thread->lru_prev[page];
+}
+
+static void lru_push(ReplayThread *thread, long page) {
+    thread->lru_prev[page] = -1;
+    thread->lru_next[page] = thread->lru_head;
+    if (thread->lru_head >= 0) thread->lru_prev[thread->lru_head] = page;
+    else                       thread->lru_tail = page;
+    thread->lru_head = page;
+}
+
+static long next_access(ReplayThread *thread) {
+    long page;
+
+    // pages out of the partition of the thread are drawn again
+    do {
+        if ((double)(replay_random(&thread->rng) >> 11) / (1ULL << 53) < HOT_RATE)
+            page = thread->hot_pages[replay_random(&thread->rng) % thread->hot_num];
+        else
+            page = replay_random(&thread->rng) % thread->page_num;
+    } while (page % thread->thread_num != thread->thread_idx);
+
+    return page;
+}
+
+static void *replay_thread(void *arg) {
+    ReplayThread *thread = (ReplayThread *)arg;
+    ByteArr buffer = (ByteArr)malloc(thread->page_size);
+    ByteArr original;
+    PageHandle handle;
+    double start;
+    long page;
+
+    for (long i = 0; i < thread->access_num; i++) {
+        page = next_access(thread);
+        original = thread->pages + page * thread->page_size;
+
+        if (thread->handles[page] != PAGE_STORE_NO_HANDLE) {  // hit
+            start = replay_clock();
+            if (!page_store_load(thread->store, thread->handles[page], buffer) || memcmp(buffer, original, thread->page_size) != 0)
+                thread->mismatches += 1;
+            thread->load_sec += replay_clock() - start;
+            thread->hits += 1;
+            lru_remove(thread, page);
+            lru_push(thread, page);
+            continue;
+        }
+
+        // miss: page is stored after evicting least recently used pages
+        thread->misses += 1;
+        start = replay_clock();
+        handle = page_store_store(thread->store, original);
+        while (handle == PAGE_STORE_NO_HANDLE && thread->lru_tail >= 0) {
+            long victim = thread->lru_tail;
+            page_store_evict(thread->store, thread->handles[victim]);
+            thread->handles[victim] = PAGE_STORE_NO_HANDLE;
+            lru_remove(thread, victim);
+            thread->evictions += 1;
+            handle = page_store_store(thread->store, original);
+        }
+        thread->store_sec += replay_clock() - start;
+
+        if (handle == PAGE_STORE_NO_HANDLE) {
+            thread->rejected += 1;
+            continue;
+        }
+        thread->handles[page] = handle;
+        lru_push(thread, page);
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+static void check_partial_lines(int page_size, uint64_t seed) {
+    int const line_sizes[] = {16, 32};
+    ByteArr page = (ByteArr)malloc(page_size);
+    ByteArr buffer = (ByteArr)malloc(page_size);
+    PageStore *store;
+    PageHandle handle;
+    uint64_t rng = seed ? seed : REPLAY_SEED;
+    int line_size, swap_idx;
+    Byte tmp;
+
+    for (int k = 0; k < (int)(sizeof(line_sizes) / sizeof(line_sizes[0])); k++) {
+        line_size = line_sizes[k];
+        if (page_size % line_size != 0) continue;
+
+        // every line of the page has the same number of nonzero bytes at random positions
+        for (int nonzero = 0; nonzero <= line_size; nonzero++) {
+            memset(page, 0, page_size);
+            for (int offset = 0; offset < page_size; offset += line_size) {
+                for (int b = 0; b < nonzero; b++)
+                    page[offset + b] = (Byte)(replay_random(&rng) % 255 + 1);
+                for (int b = line_size - 1; b > 0; b--) {
+                    swap_idx = replay_random(&rng) % (b + 1);
+                    tmp = page[offset + b];
+                    page[offset + b] = page[offset + swap_idx];
+                    page[offset + swap_idx] = tmp;
+                }
+            }
+
+            for (int i = 0; i < ALGO_NUM; i++) {
+                if (algo_decomp_funcs[i] == NULL) continue;
+                store = make_page_store(algo_funcs[i], algo_decomp_funcs[i], page_size, line_size, 1, 0);
+                handle = page_store_store(store, page);
+                if (!page_store_load(store, handle, buffer) || memcmp(buffer, page, page_size) != 0) {
+                    fprintf(stderr, "[ERROR] %s: page of %dB lines with %d nonzero bytes is not restored\n", algo_names[i], line_size, nonzero);
+                    exit(-1);
+                }
+                remove_page_store(store);
+            }
+        }
+        printf("pages of %dB lines with 0 ~ %d nonzero bytes: restored by every algorithm\n", line_size, line_size);
+    }
+
+    free(page);
+    free(buffer);
+}
+
+int main(int argc, char const *argv[]) {
+    ReplayThread threads[MAX_THREAD_NUM];
+    pthread_t thread_ids[MAX_THREAD_NUM];
+    PageStore *store;
+    PageStoreStats stats;
+    PageHandle *handles;
+    ByteArr pages = NULL;
+    long page_num = 0, file_pages, hot_num, *hot_pages, *lru_prev, *lru_next, swap_idx, tmp;
+    long filesize, hits, misses, rejected, evictions, mismatches;
+    int chunksize, thread_num = 1, shard_num = 0, algo = -1, page_size = PAGE_STORE_DEFAULT_PAGE;
+    double pool_share = 50, accesses_per_page = 10, store_sec, load_sec, replay_sec, start;
+    uint64_t seed = REPLAY_SEED, rng;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/pagestore.csv";
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        pool_share = atof(argv[3]);
+    if (argc > 4)
+        accesses_per_page = atof(argv[4]);
+    if (argc > 5)
+        thread_num = atoi(argv[5]);
+    if (argc > 6)
+        algo = atoi(argv[6]);
+    if (argc > 7)
+        logfilename = argv[7];
+    if (argc > 8)
+        seed = strtoull(argv[8], NULL, 0);
+    if (argc > 9)
+        page_size = atoi(argv[9]);
+    if (argc > 10)
+        shard_num = atoi(argv[10]);
+
+    if (chunksize <= 0 || page_size <= 0 || page_size % chunksize != 0) {
+        fprintf(stderr, "[ERROR] Memory chunk size %d does not divide page size %d\n", chunksize, page_size);
+        exit(-1);
+    }
+    if (thread_num <= 0 || thread_num > MAX_THREAD_NUM || algo >= ALGO_NUM || (algo >= 0 && algo_decomp_funcs[algo] == NULL)) {
+        fprintf(stderr, "[ERROR] Invalid number of threads %d or algorithm %d (algorithm must have decompression)\n", thread_num, algo);
+        exit(-1);
+    }
+    if (shard_num < 0) {
+        fprintf(stderr, "[ERROR] Invalid number of shards %d\n", shard_num);
+        exit(-1);
+    }
+    if (shard_num == 0)
+        shard_num = thread_num;  // one shard per thread
+
+    check_partial_lines(page_size, seed);
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    // 1. Working set (every file is zero padded to pages)
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        file_pages = (filesize + page_size - 1) / page_size;
+        pages = (ByteArr)realloc(pages, (page_num + file_pages) * page_size);
+        memset(pages + page_num * page_size, 0, file_pages * page_size);
+        fread(pages + page_num * page_size, 1, filesize, fp);
+        fclose(fp);
+
+        printf("Reading %s (filesize: %ldBytes  pages: %ld)\n", datafilename, filesize, file_pages);
+        page_num += file_pages;
+    }
+
+    if (page_num < thread_num) {
+        fprintf(stderr, "[ERROR] Working set of %ld pages is smaller than the number of threads\n", page_num);
+        exit(-1);
+    }
+
+    // 2. Hot set (random pages fixed by the seed)
+    hot_pages = (long *)malloc(sizeof(long) * page_num);
+    for (long i = 0; i < page_num; i++)
+        hot_pages[i] = i;
+    rng = seed ? seed : REPLAY_SEED;
+    for (long i = page_num - 1; i > 0; i--) {
+        swap_idx = replay_random(&rng) % (i + 1);
+        tmp = hot_pages[i];
+        hot_pages[i] = hot_pages[swap_idx];
+        hot_pages[swap_idx] = tmp;
+    }
+    hot_num = (long)(page_num * HOT_FRACTION) > 0 ? (long)(page_num * HOT_FRACTION) : 1;
+
+    handles = (PageHandle *)malloc(sizeof(PageHandle) * page_num);
+    lru_prev = (long *)malloc(sizeof(long) * page_num);
+    lru_next = (long *)malloc(sizeof(long) * page_num);
+
+    printf("working set: %ld pages (%ldBytes)  pool: %.1f%%  accesses: %ld  threads: %d  shards: %d\n", page_num, page_num * page_size,
+           pool_share, (long)(page_num * accesses_per_page), thread_num, shard_num);
+    if (page_num * page_size * pool_share / 100 < (double)shard_num * (page_size / PAGE_STORE_CLASS_STEP) * PAGE_STORE_SLAB_SIZ)
+        printf("[WARNING] Pool is smaller than a slab per size class of each shard (density mostly measures slab fragmentation)\n");
+    fprintf(logfilefp, "%s\n", "Algorithm,Pages,Accesses,Hit Rate,Resident Pages,Raw Pages,Ratio,Density,Internal Fragmentation,Pool Bytes,Store MB/s,Load MB/s,Replay Sec");
+
+    // 3. Replay accesses against the store of each algorithm
+    for (int i = 0; i < ALGO_NUM; i++) {
+        if ((algo >= 0 && i != algo) || algo_decomp_funcs[i] == NULL) continue;
+
+        store = make_page_store(algo_funcs[i], algo_decomp_funcs[i], page_size, chunksize, shard_num,
+                                (long)(page_num * page_size * pool_share / 100));
+        for (long p = 0; p < page_num; p++)
+            handles[p] = PAGE_STORE_NO_HANDLE;
+
+        for (int t = 0; t < thread_num; t++) {
+            memset(&threads[t], 0, sizeof(ReplayThread));
+            threads[t].store = store;
+            threads[t].pages = pages;
+            threads[t].page_num = page_num;
+            threads[t].page_size = page_size;
+            threads[t].hot_pages = hot_pages;
+            threads[t].hot_num = hot_num;
+            threads[t].thread_idx = t;
+            threads[t].thread_num = thread_num;
+            threads[t].access_num = (long)(page_num * accesses_per_page) / thread_num;
+            threads[t].rng = (seed ? seed : REPLAY_SEED) + 0x9e3779b97f4a7c15ULL * (t + 1);  // same accesses for every algorithm
+            threads[t].handles = handles;
+            threads[t].lru_prev = lru_prev;
+            threads[t].lru_next = lru_next;
+            threads[t].lru_head = -1;
+            threads[t].lru_tail = -1;
+        }
+
+        start = replay_clock();
+        for (int t = 0; t < thread_num; t++)
+            pthread_create(&thread_ids[t], NULL, replay_thread, &threads[t]);
+        for (int t = 0; t < thread_num; t++)
+            pthread_join(thread_ids[t], NULL);
+        replay_sec = replay_clock() - start;
+
+        hits = misses = rejected = evictions = mismatches = 0;
+        store_sec = load_sec = 0;
+        for (int t = 0; t < thread_num; t++) {
+            hits += threads[t].hits;
+            misses += threads[t].misses;
+            rejected += threads[t].rejected;
+            evictions += threads[t].evictions;
+            mismatches += threads[t].mismatches;
+            store_sec += threads[t].store_sec;
+            load_sec += threads[t].load_sec;
+        }
+        stats = page_store_stats(store);
+
+        if (mismatches > 0)
+            fprintf(stderr, "[ERROR] %s: %ld pages are not restored\n", algo_names[i], mismatches);
+
+        printf("%-10s hit rate: %.4f  resident: %ld pages (raw: %ld)  ratio: %.4f  density: %.4f  fragmentation: %.4f  store: %.2fMB/s  load: %.2fMB/s  evictions: %ld  rejected: %ld  (%.2fs)\n",
+               algo_names[i], (double)hits / (hits + misses), stats.stored_pages, stats.raw_pages,
+               stats.compressed_bytes > 0 ? (double)stats.original_bytes / stats.compressed_bytes : 0,
+               stats.pool_bytes > 0 ? (double)stats.original_bytes / stats.pool_bytes : 0,
+               stats.object_bytes > 0 ? 1 - (double)stats.compressed_bytes / stats.object_bytes : 0,
+               store_sec > 0 ? (double)misses * page_size / store_sec / (1 << 20) : 0,
+               load_sec > 0 ? (double)hits * page_size / load_sec / (1 << 20) : 0, evictions, rejected, replay_sec);
+        fprintf(logfilefp, "%s,%ld,%ld,%.4f,%ld,%ld,%.4f,%.4f,%.4f,%ld,%.2f,%.2f,%.2f\n", algo_names[i], page_num, hits + misses,
+                (double)hits / (hits + misses), stats.stored_pages, stats.raw_pages,
+                stats.compressed_bytes > 0 ? (double)stats.original_bytes / stats.compressed_bytes : 0,
+                stats.pool_bytes > 0 ? (double)stats.original_bytes / stats.pool_bytes : 0,
+                stats.object_bytes > 0 ? 1 - (double)stats.compressed_bytes / stats.object_bytes : 0, stats.pool_bytes,
+                store_sec > 0 ? (double)misses * page_size / store_sec / (1 << 20) : 0,
+                load_sec > 0 ? (double)hits * page_size / load_sec / (1 << 20) : 0, replay_sec);
+
+        remove_page_store(store);
+    }
+
+    free(handles);
+    free(lru_prev);
+    free(lru_next);
+    free(hot_pages);
+    free(pages);
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
@@ -15,11 +15,17 @@ from models.tools.imagenet_utils.args_generator import args
 from models.model_presets import imagenet_pretrained
 from models.tools.extractor import QuantModelExtractor, weight_trace, bias_trace
 from models.tools.quanitzation import QuantizationModule
+from models.tools.shm_stream import ShmRingProducer, ShmStreamError
 
 
 parser = argparse.ArgumentParser(description='Comparison Test Configs')
 parser.add_argument('-cs', '--csize', default=64, help='Cache line size (int)', dest='csize')
 parser.add_argument('-mi', '--maxiter', default=5000, help='Max iteration of the file fetch (int)', dest='maxiter')
+parser.add_argument('-ac', '--activation', action='store_true', help='Extract and test quantized activations', dest='activation')
+parser.add_argument('-ai', '--actiter', default=1, type=int, help='Max iteration of the activation extraction (int)', dest='actiter')
+parser.add_argument('-st', '--stream', action='store_true', help='Stream activations to the compressor through shared memory instead of saving them (linux only)', dest='stream')
+parser.add_argument('-sr', '--stride', default=1, type=int, help='Compress every stride-th line of streamed activations (int)', dest='stride')
+parser.add_argument('-rs', '--ringsize', default=64, type=int, help='Size of the shared memory ring in MB (int)', dest='ringsize')
 comp_args, _ = parser.parse_known_args()
 
 
@@ -72,8 +78,12 @@ if __name__ == '__main__':
     if 'linux' in platform.platform().lower():
         tb_name = './tb_csv'
 
-    print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0")
-    subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c -lm -Wformat=0", shell=True, check=True)
+    print(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0")
+    subprocess.run(f"gcc -o tb_csv ./tb_csv.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c ./line_sampling.c ./line_dedup.c ./result_cache.c ./read_ahead.c ./checkpoint_delta.c -lm -pthread -Wformat=0", shell=True, check=True)
+
+    if comp_args.stream:
+        print(f"gcc -o tb_stream ./tb_stream.c ./shm_ring.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c -lm -Wformat=0")
+        subprocess.run(f"gcc -o tb_stream ./tb_stream.c ./shm_ring.c ./compression.c ./bdi_zerovec.c ./bpc_compression.c ./cpack_compression.c ./block_compression.c ./int8_compression.c ./original_bdi_compression.c ./batch_compression.c -lm -Wformat=0", shell=True, check=True)
 
     for model_type, model_config in imagenet_pretrained.items():
         full_modelname = f"{model_type}_quant_Imagenet"
@@ -104,17 +114,43 @@ if __name__ == '__main__':
         extractor_module.extract_params()                           # extract paramters
         extractor_module.save_params(savepath=save_extraction_dir)  # save extracted parameters
 
+        if comp_args.activation and comp_args.stream:
+            ring_path = os.path.join('/dev/shm', f"{full_modelname}_ring")
+            result_path = os.path.join(save_extraction_dir, 'comparison_results_activation.csv')
+            with ShmRingProducer(ring_path, int(comp_args.csize), capacity=comp_args.ringsize * (1 << 20)) as producer:  # compressor consumes while inference runs
+                consumer = subprocess.Popen(['./tb_stream', ring_path, str(comp_args.csize), result_path, str(comp_args.stride)])
+                producer.attach_consumer(consumer)  # inference stops instead of hanging if the compressor exits
+                extractor_module.attach_stream(producer)
+                try:
+                    extractor_module.extract_activation(test_loader, max_iter=comp_args.actiter)  # stream quantized activations
+                except ShmStreamError as error:
+                    print(f"Error occurred on streaming activations: {error}")
+                    consumer.kill()
+                extractor_module.attach_stream(None)
+                print(f"inference waited {producer.stall_time:.2f}s for the compressor")
+            if consumer.wait() != 0:
+                print('Error occurred on running streaming compression testbench')
+            os.remove(ring_path)
+        elif comp_args.activation:
+            extractor_module.extract_activation(test_loader, max_iter=comp_args.actiter)                     # extract quantized activations
+            extractor_module.save_activation(savepath=os.path.join(save_extraction_dir, 'activations'))  # save extracted activations
+
         print(f"extracting '{full_modelname}' completed")
         print(f"generating comparison test results")
 
-        filelist_path = os.path.join(os.curdir, 'extractions', full_modelname, 'filelist.txt')
-        result_path = os.path.join(os.curdir, 'extractions', full_modelname, 'comparison_results.csv')
-        print(f"\n{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}")
-        tb_result = subprocess.run(f"{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}",
-                                   shell=True)
-
-        if tb_result.returncode != 0:
-            print('Error occurred on running compression algorithm testbench')
-        else:
-            print(f"compression algorithm comparison test completed\n")
+        test_targets = [(save_extraction_dir, 'comparison_results.csv')]
+        if comp_args.activation and not comp_args.stream:
+            test_targets.append((os.path.join(save_extraction_dir, 'activations'), 'comparison_results_activation.csv'))
+
+        for target_dir, result_name in test_targets:
+            filelist_path = os.path.join(target_dir, 'filelist.txt')
+            result_path = os.path.join(save_extraction_dir, result_name)
+            print(f"\n{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}")
+            tb_result = subprocess.run(f"{tb_name} {filelist_path} {comp_args.csize} {comp_args.maxiter} {result_path}",
+                                       shell=True)
+
+            if tb_result.returncode != 0:
+                print('Error occurred on running compression algorithm testbench')
+            else:
+                print(f"compression algorithm comparison test completed\n")
 
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tb_algorithms.h"
+#include "line_sampling.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ    2048
+#define CHECK_SEED_NUM     1024   // seeds averaged in the bias check
+#define CHECK_MIN_SAMPLES  4      // fewest samples of the bias check
+#define CHECK_TOLERANCE    0.05   // relative error of the averaged estimate allowed in the bias check
+
+
+/*
+ * Testbench for sampled compression ratio estimates
+ *   Compression ratio of each file is computed from every line (exact) and estimated from maxiter
+ *   lines drawn by uniform and stratified sampling (line_sampling.h), so that the bias of the
+ *   estimates can be checked against the exact ratio, also with fewer samples than strata.
+ *
+ *   Before reading the filelist, stratified estimates are checked for bias on a synthetic image of
+ *   zero lines in its first quarter and random lines in the rest: the mean compressed size
+ *   estimated with 4 to twice the number of strata samples, averaged over seeds, has to be within
+ *   5% of the exact mean, and the testbench fails otherwise (drawing strata in file order samples
+ *   only zero lines with fewer samples than a quarter of the strata).
+ *
+ * Usage: tb_sampling <filelist> <chunksize> [maxiter] [logfile] [seed]
+ *
+ * Output columns: layer name, samples, and then exact, uniform and stratified ratio of each algorithm
+ */
+
+static double sampled_ratio(int algo, ByteArr image, long line_num, int chunksize, int mode, uint64_t seed, int samples) {
+    LineSampler sampler = make_line_sampler(line_num, mode, seed);
+    RatioEstimator estimator = make_ratio_estimator(sampler);
+    CompressionResult result;
+    CacheLine line;
+    double ratio, half_width;
+    long index;
+    int stratum;
+
+    line.size = chunksize;
+    line.valid_bitwidth = chunksize * BYTE_BITWIDTH;
+    for (int s = 0; s < samples; s++) {
+        index = next_sample_line(&sampler, &stratum);
+        line.body = image + index * chunksize;
+        result = algo_funcs[algo](line);
+        add_ratio_sample(&estimator, stratum, result.compressed.size);
+        remove_compression_result(result);
+    }
+
+    ratio = estimate_ratio(estimator, chunksize, &half_width);
+    remove_ratio_estimator(estimator);
+
+    return ratio;
+}
+
+static uint64_t image_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dULL;
+}
+
+static void check_nonuniform_image(int chunksize, uint64_t seed) {
+    long line_num = SAMPLE_STRATA_NUM * 16;
+    ByteArr image = (ByteArr)calloc(line_num * chunksize, 1);
+    uint64_t rng = seed ? seed : SAMPLE_DEFAULT_SEED;
+    double exact_size, mean_size;
+
+    // zero lines in the first quarter of the image, random lines in the rest
+    for (long i = line_num / 4 * chunksize; i < line_num * chunksize; i++)
+        image[i] = (Byte)image_random(&rng);
+
+    // mean compressed size estimated with each number of samples, averaged over seeds
+    exact_size = chunksize / sampled_ratio(0, image, line_num, chunksize, SAMPLE_SEQUENTIAL, seed, line_num);
+    for (int samples = CHECK_MIN_SAMPLES; samples <= 2 * SAMPLE_STRATA_NUM; samples *= 2) {
+        mean_size = 0;
+        for (int r = 1; r <= CHECK_SEED_NUM; r++)
+            mean_size += chunksize / sampled_ratio(0, image, line_num, chunksize, SAMPLE_STRATIFIED, seed + r, samples);
+        mean_size /= CHECK_SEED_NUM;
+
+        if (fabs(mean_size - exact_size) > CHECK_TOLERANCE * exact_size) {
+            fprintf(stderr, "[ERROR] Stratified mean size %.4f with %d samples differs from exact mean size %.4f (biased)\n", mean_size, samples, exact_size);
+            exit(-1);
+        }
+    }
+    printf("stratified estimate of non-uniform image: unbiased with %d ~ %d samples (%s)\n", CHECK_MIN_SAMPLES, 2 * SAMPLE_STRATA_NUM, algo_names[0]);
+
+    free(image);
+}
+
+int main(int argc, char const *argv[]) {
+    int chunksize, maxiter = SAMPLE_STRATA_NUM / 4;
+    long filesize, line_num;
+    uint64_t seed = SAMPLE_DEFAULT_SEED;
+    double exact, uniform, stratified;
+    ByteArr image;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char const *filename;
+    char const *logfilename = "./logs/sampling.csv";
+
+    if (argc > 2) {
+        filename = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        maxiter = atoi(argv[3]);
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        seed = strtoull(argv[5], NULL, 0);
+
+    if (chunksize <= 0 || maxiter <= 0) {
+        fprintf(stderr, "[ERROR] Invalid memory chunk size %d or maxiter %d\n", chunksize, maxiter);
+        exit(-1);
+    }
+
+    check_nonuniform_image(chunksize, seed);
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s' or logfile '%s' failed\n", filename, logfilename);
+        exit(-1);
+    }
+
+    fprintf(logfilefp, "%s", "Layer Name,Samples");
+    for (int i = 0; i < ALGO_NUM; i++)
+        fprintf(logfilefp, ",%s Exact,%s Uniform,%s Stratified", algo_names[i], algo_names[i], algo_names[i]);
+    fprintf(logfilefp, "\n");
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        line_num = (filesize + chunksize - 1) / chunksize;
+        image = (ByteArr)calloc(line_num * chunksize + 1, 1);  // last line is zero padded
+        fread(image, 1, filesize, fp);
+        fclose(fp);
+
+        printf("Reading %s (filesize: %ldBytes)  samples: %d\n", datafilename, filesize, maxiter);
+        fprintf(logfilefp, "%s,%d", datafilename, maxiter);
+
+        for (int i = 0; line_num > 0 && i < ALGO_NUM; i++) {
+            exact = sampled_ratio(i, image, line_num, chunksize, SAMPLE_SEQUENTIAL, seed, line_num);
+            uniform = sampled_ratio(i, image, line_num, chunksize, SAMPLE_UNIFORM, seed, maxiter);
+            stratified = sampled_ratio(i, image, line_num, chunksize, SAMPLE_STRATIFIED, seed, maxiter);
+
+            printf("%-10s exact: %.4f  uniform: %.4f  stratified: %.4f\n", algo_names[i], exact, uniform, stratified);
+            fprintf(logfilefp, ",%.4f,%.4f,%.4f", exact, uniform, stratified);
+        }
+        fprintf(logfilefp, "\n");
+
+        free(image);
+    }
+
+    fclose(filelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "tb_algorithms.h"
+#include "shm_ring.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define LAYER_INIT_NUM     64
+#define REPORT_INTERVAL    1000  // number of tensors between progress reports
+
+
+/*
+ * Testbench for compression of streamed activations
+ *   Consumes tensors written into the shared memory ring by PyTorch forward hooks
+ *   (models/tools/shm_stream.py) while inference runs, so compressibility can be measured over
+ *   thousands of batches without saving activations to disk. Compressed sizes are aggregated per
+ *   tensor name (e.g. layer name), over every batch. Each tensor is split into lines as a file in
+ *   tb_csv (the last line is zero padded), and every stride-th line is compressed. The producer
+ *   waits while the ring is full, so a larger stride makes inference faster.
+ *
+ *   Testbench finishes when the producer closes the ring and every tensor is consumed, and fails
+ *   without writing the log at a corrupted record. The log file has the same columns as tb_csv.
+ *
+ * Usage: tb_stream <ring path> <chunksize> [logfile] [line stride] [timeout (sec, -1: no timeout)]
+ */
+
+typedef struct {
+    char  name[SHM_RING_NAME_SIZ];  // name of tensor
+    long  tensor_num;               // number of consumed tensors (records, a tensor larger than a quarter of the ring is split)
+    long  line_num;                 // number of compressed lines
+    long  original_size;            // total size of compressed lines
+    long  algo_sizes[ALGO_NUM];     // total compressed size of each algorithm
+} LayerStat;
+
+static LayerStat *find_layer_stat(LayerStat **stats, int *stat_num, int *capacity, char const *name) {
+    for (int i = 0; i < *stat_num; i++) {
+        if (strcmp((*stats)[i].name, name) == 0)
+            return &(*stats)[i];
+    }
+
+    if (*stat_num >= *capacity) {
+        *capacity *= 2;
+        *stats = (LayerStat *)realloc(*stats, sizeof(LayerStat) * (*capacity));
+    }
+    memset(&(*stats)[*stat_num], 0, sizeof(LayerStat));
+    strcpy((*stats)[*stat_num].name, name);
+    return &(*stats)[(*stat_num)++];
+}
+
+int main(int argc, char const *argv[]) {
+    ShmRing ring;
+    ShmRecord record;
+    MemoryChunk chunk;
+    CompressionResult result;
+    LayerStat *stats, *stat;
+    int chunksize, stride = 1, timeout = 60, stat_num = 0, stat_capacity = LAYER_INIT_NUM;
+    long line_num, tensor_num = 0;
+    uint64_t consumed = 0, offset;
+    clock_t start;
+    double elapsed;
+    ByteArr padded;
+
+    char const *ringpath;
+    char const *logfilename = "./logs/stream.csv";
+
+    if (argc > 2) {
+        ringpath = argv[1];
+        chunksize = atoi(argv[2]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (ring path and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 3)
+        logfilename = argv[3];
+    if (argc > 4)
+        stride = atoi(argv[4]);
+    if (argc > 5)
+        timeout = atoi(argv[5]);
+
+    if (chunksize <= 0 || stride <= 0) {
+        fprintf(stderr, "[ERROR] Invalid memory chunk size %d or line stride %d\n", chunksize, stride);
+        exit(-1);
+    }
+
+    FILE *logfilefp = fopen(logfilename, "wt");
+    if (logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening logfile '%s' failed\n", logfilename);
+        exit(-1);
+    }
+
+    ring = open_shm_ring(ringpath, timeout);
+    if (ring.base == NULL)
+        exit(-1);
+
+    stats = (LayerStat *)malloc(sizeof(LayerStat) * stat_capacity);
+    padded = (ByteArr)malloc(chunksize);
+    chunk.size = chunksize;
+    chunk.valid_bitwidth = chunksize * BYTE_BITWIDTH;
+    start = clock();
+
+    while (shm_ring_read(&ring, &record)) {
+        stat = find_layer_stat(&stats, &stat_num, &stat_capacity, record.name);
+        line_num = (long)((record.size + chunksize - 1) / chunksize);
+
+        for (long l = 0; l < line_num; l += stride) {
+            offset = (uint64_t)l * chunksize;
+            if (offset + chunksize <= record.size) {
+                chunk.body = record.payload + offset;
+            } else {
+                memset(padded, 0, chunksize);  // last line of the tensor
+                memcpy(padded, record.payload + offset, record.size - offset);
+                chunk.body = padded;
+            }
+
+            for (int i = 0; i < ALGO_NUM; i++) {
+                result = algo_funcs[i](chunk);
+                stat->algo_sizes[i] += result.compressed.size;
+                remove_compression_result(result);
+            }
+            stat->original_size += chunksize;
+            stat->line_num += 1;
+        }
+
+        stat->tensor_num += 1;
+        consumed += record.size;
+        shm_ring_release(&ring);  // producer can overwrite the tensor from here
+
+        if (++tensor_num % REPORT_INTERVAL == 0) {
+            elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+            printf("\r[TENSOR %ld] consumed: %.2fMB  throughput: %.2fMB/s", tensor_num,
+                   (double)consumed / (1 << 20), elapsed > 0 ? (double)consumed / (1 << 20) / elapsed : 0);
+            fflush(stdout);
+        }
+    }
+
+    close_shm_ring(ring);
+    if (ring.corrupted)
+        exit(-1);  // stream ended at a corrupted record, results are incomplete
+    elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("\nconsumed %ld tensors (%.2fMB, %.2fs of compression)\n", tensor_num, (double)consumed / (1 << 20), elapsed);
+
+    fprintf(logfilefp, "%s", "Layer Name");
+    for (int i = 0; i < ALGO_NUM; i++)
+        fprintf(logfilefp, ",%s", algo_names[i]);
+    fprintf(logfilefp, "\n");
+
+    for (int s = 0; s < stat_num; s++) {
+        stat = &stats[s];
+        printf("%s (tensors: %ld  lines: %ld)\ncompression ratio: ", stat->name, stat->tensor_num, stat->line_num);
+        fprintf(logfilefp, "%s", stat->name);
+        for (int i = 0; i < ALGO_NUM; i++) {
+            double ratio = stat->algo_sizes[i] > 0 ? (double)stat->original_size / stat->algo_sizes[i] : 0;
+            printf("%.4f(%s) ", ratio, algo_names[i]);
+            fprintf(logfilefp, ",%.4f", ratio);
+        }
+        printf("\n");
+        fprintf(logfilefp, "\n");
+    }
+
+    fclose(logfilefp);
+    free(stats);
+    free(padded);
+
+    return 0;
+}
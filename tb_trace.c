@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tb_algorithms.h"
+#include "access_trace.h"
+
+// Verbose parameter
+// #define VERBOSE  // Comment this line not to display debug messages
+
+#define FILENAME_BUFSIZ  2048
+
+
+/*
+ * Testbench for access-weighted compressibility
+ *   Each data image (e.g. layer file) is paired with a memory access trace on the same line of the
+ *   trace filelist (access_trace.h). Lines of the image are weighted by the number of accesses
+ *   which touch them, so that hot lines count as much as they are accessed: weighted ratio is
+ *   (accesses x line size) / (sum of compressed size of the accessed line at each access). Static
+ *   ratio (every line weighted equally, as tb_csv) is reported next to it.
+ *
+ *   Addresses of the trace are mapped to the image with the base address. Records with data
+ *   snapshot update the image, and the lines they touch are compressed again, so that each access
+ *   is weighted with the line as it was at that time. Accessed lines are split into hot lines (the
+ *   most accessed lines covering hot share of accesses) and cold lines, and the weighted ratio of
+ *   each is reported.
+ *
+ * Usage: tb_trace <filelist> <trace filelist> <chunksize> [logfile] [base address] [hot share]
+ *
+ * Output columns: layer name, accesses, accessed lines, hot lines, and then static, weighted, hot
+ * and cold ratio of each algorithm
+ */
+
+int main(int argc, char const *argv[]) {
+    BatchResult batch;
+    AccessTrace trace;
+    AccessRecord record;
+    CacheLine line;
+    CompressionResult result;
+    int chunksize, line_batch;
+    int *sizes[ALGO_NUM];          // compressed size of each line (-1: line is updated by a snapshot)
+    long *access_bytes[ALGO_NUM];  // sum of compressed size of each line at its accesses
+    long *counts, static_bytes[ALGO_NUM];
+    long filesize, line_num, first, last, offset, copy_size, accesses, outside, accessed_num, hot_num;
+    double hot_share = TRACE_HOT_SHARE, hot_orig, cold_orig, hot_comp, cold_comp;
+    uint64_t base_address = 0;
+    Bool *hot;
+    ByteArr image;
+
+    char datafilename[FILENAME_BUFSIZ];
+    char tracefilename[FILENAME_BUFSIZ];
+    char const *filename, *tracelistname;
+    char const *logfilename = "./logs/trace.csv";
+
+    if (argc > 3) {
+        filename = argv[1];
+        tracelistname = argv[2];
+        chunksize = atoi(argv[3]);
+    } else {
+        fprintf(stderr, "[ERROR] Insufficient number of line arguments (filename, trace filename and memory chunk size is required\n");
+        exit(-1);
+    }
+
+    if (argc > 4)
+        logfilename = argv[4];
+    if (argc > 5)
+        base_address = strtoull(argv[5], NULL, 0);
+    if (argc > 6)
+        hot_share = atof(argv[6]);
+
+    if (chunksize <= 0) {
+        fprintf(stderr, "[ERROR] Invalid memory chunk size %d\n", chunksize);
+        exit(-1);
+    }
+
+    FILE *filelistfp = fopen(filename, "rt");
+    FILE *tracelistfp = fopen(tracelistname, "rt");
+    FILE *logfilefp = fopen(logfilename, "wt");
+
+    if (filelistfp == NULL || tracelistfp == NULL || logfilefp == NULL) {
+        fprintf(stderr, "[ERROR] Opening filelist '%s', trace filelist '%s' or logfile '%s' failed\n", filename, tracelistname, logfilename);
+        exit(-1);
+    }
+
+    fprintf(logfilefp, "%s", "Layer Name,Accesses,Accessed Lines,Hot Lines");
+    for (int i = 0; i < ALGO_NUM; i++)
+        fprintf(logfilefp, ",%s Static,%s Weighted,%s Hot,%s Cold", algo_names[i], algo_names[i], algo_names[i], algo_names[i]);
+    fprintf(logfilefp, "\n");
+
+    batch = make_batch_result(BATCH_DEFAULT_LINES, chunksize, FALSE);
+    line.size = chunksize;
+    line.valid_bitwidth = chunksize * BYTE_BITWIDTH;
+
+    while (fgets(datafilename, FILENAME_BUFSIZ-1, filelistfp)) {
+        if (datafilename[strlen(datafilename)-1] == '\n')
+            datafilename[strlen(datafilename)-1] = 0;
+        if (!fgets(tracefilename, FILENAME_BUFSIZ-1, tracelistfp)) {
+            fprintf(stderr, "[ERROR] No trace file for '%s' in trace filelist\n", datafilename);
+            exit(-1);
+        }
+        if (tracefilename[strlen(tracefilename)-1] == '\n')
+            tracefilename[strlen(tracefilename)-1] = 0;
+
+        FILE *fp = fopen(datafilename, "rb");
+        if (fp == NULL) {
+            fprintf(stderr, "[ERROR] Opening file '%s' failed\n", datafilename);
+            continue;
+        }
+        fseek(fp, 0, SEEK_END);
+        filesize = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        line_num = (filesize + chunksize - 1) / chunksize;
+        image = (ByteArr)calloc(line_num * chunksize + 1, 1);  // last line is zero padded
+        fread(image, 1, filesize, fp);
+        fclose(fp);
+
+        printf("Reading %s (filesize: %ldBytes)  trace: %s\n", datafilename, filesize, tracefilename);
+
+        // 1. Static sizes of every line of the image
+        for (int i = 0; i < ALGO_NUM; i++) {
+            sizes[i] = (int *)malloc(sizeof(int) * (line_num > 0 ? line_num : 1));
+            access_bytes[i] = (long *)calloc(line_num > 0 ? line_num : 1, sizeof(long));
+            static_bytes[i] = 0;
+            for (long l = 0; l < line_num; l += line_batch) {
+                line_batch = line_num - l < BATCH_DEFAULT_LINES ? line_num - l : BATCH_DEFAULT_LINES;
+                algo_batch_compression(i, image + l * chunksize, line_batch, &batch);
+                memcpy(&sizes[i][l], batch.sizes, sizeof(int) * line_batch);
+                for (int b = 0; b < line_batch; b++)
+                    static_bytes[i] += batch.sizes[b];
+            }
+        }
+        counts = (long *)calloc(line_num > 0 ? line_num : 1, sizeof(long));
+        hot = (Bool *)malloc(sizeof(Bool) * (line_num > 0 ? line_num : 1));
+
+        // 2. Replay trace (each access weights the lines it touches with their current size)
+        trace = open_access_trace(tracefilename);
+        accesses = outside = 0;
+        while (next_access_record(&trace, &record)) {
+            if (record.address < base_address || record.address - base_address >= (uint64_t)filesize) {
+                outside += 1;
+                continue;
+            }
+            offset = record.address - base_address;
+            first = offset / chunksize;
+            last = (offset + record.size - 1) / chunksize;
+            if (last >= line_num)
+                last = line_num - 1;
+
+            if (record.has_data) {
+                copy_size = offset + record.size > filesize ? filesize - offset : record.size;
+                memcpy(image + offset, record.data, copy_size);
+                for (int i = 0; i < ALGO_NUM; i++)
+                    for (long l = first; l <= last; l++)
+                        sizes[i][l] = -1;
+            }
+
+            for (long l = first; l <= last; l++) {
+                counts[l] += 1;
+                for (int i = 0; i < ALGO_NUM; i++) {
+                    if (sizes[i][l] < 0) {
+                        line.body = image + l * chunksize;
+                        result = algo_funcs[i](line);
+                        sizes[i][l] = result.compressed.size;
+                        remove_compression_result(result);
+                    }
+                    access_bytes[i][l] += sizes[i][l];
+                }
+            }
+            accesses += 1;
+#ifdef VERBOSE
+            printf("access 0x%llx (%dBytes): lines %ld-%ld%s\n", (unsigned long long)record.address, record.size, first, last, record.has_data ? " (snapshot)" : "");
+#endif
+        }
+
+        if (trace.broken_num > 0 || outside > 0)
+            printf("[WARNING] %ld broken records and %ld accesses outside of the image are skipped\n", trace.broken_num, outside);
+        close_access_trace(trace);
+
+        // 3. Hot and cold split of accessed lines
+        hot_num = mark_hot_lines(counts, line_num, hot_share, hot);
+        accessed_num = 0;
+        for (long l = 0; l < line_num; l++)
+            accessed_num += counts[l] > 0;
+
+        printf("accesses: %ld  accessed lines: %ld/%ld  hot lines: %ld (%.0f%% of accesses)\n", accesses, accessed_num, line_num, hot_num, hot_share * 100);
+        fprintf(logfilefp, "%s,%ld,%ld,%ld", datafilename, accesses, accessed_num, hot_num);
+
+        for (int i = 0; i < ALGO_NUM; i++) {
+            hot_orig = cold_orig = hot_comp = cold_comp = 0;
+            for (long l = 0; l < line_num; l++) {
+                if (counts[l] == 0) continue;
+                if (hot[l]) {
+                    hot_orig += (double)counts[l] * chunksize;
+                    hot_comp += access_bytes[i][l];
+                } else {
+                    cold_orig += (double)counts[l] * chunksize;
+                    cold_comp += access_bytes[i][l];
+                }
+            }
+
+            printf("%-10s static: %.4f  weighted: %.4f  hot: %.4f  cold: %.4f\n", algo_names[i],
+                   static_bytes[i] > 0 ? (double)line_num * chunksize / static_bytes[i] : 0,
+                   hot_comp + cold_comp > 0 ? (hot_orig + cold_orig) / (hot_comp + cold_comp) : 0,
+                   hot_comp > 0 ? hot_orig / hot_comp : 0, cold_comp > 0 ? cold_orig / cold_comp : 0);
+            fprintf(logfilefp, ",%.4f,%.4f,%.4f,%.4f", static_bytes[i] > 0 ? (double)line_num * chunksize / static_bytes[i] : 0,
+                    hot_comp + cold_comp > 0 ? (hot_orig + cold_orig) / (hot_comp + cold_comp) : 0,
+                    hot_comp > 0 ? hot_orig / hot_comp : 0, cold_comp > 0 ? cold_orig / cold_comp : 0);
+
+            free(sizes[i]);
+            free(access_bytes[i]);
+        }
+        fprintf(logfilefp, "\n");
+
+        free(counts);
+        free(hot);
+        free(image);
+    }
+
+    remove_batch_result(batch);
+    fclose(filelistfp);
+    fclose(tracelistfp);
+    fclose(logfilefp);
+
+    return 0;
+}